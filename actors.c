@@ -0,0 +1,96 @@
+/*
+  Structure-of-arrays actor table.
+*/
+#include "actors.h"
+
+// Arrays are padded and aligned like the particle pool's, for vector loads
+#define ACTOR_LANES 4
+#define ACTOR_ALIGN 16
+#define ACTOR_WORD_ARRAYS 17 // 4-byte arrays carved from the block
+#define ACTOR_BYTE_ARRAYS 4 // 1-byte arrays after them
+
+int actor_table_init(ActorTable *table, int capacity)
+{
+    SDL_zerop(table);
+    if (capacity < 1) {
+        capacity = 1;
+    }
+    int padded = (capacity + ACTOR_LANES - 1) & ~(ACTOR_LANES - 1);
+
+    // One block for every array, carved up below
+    size_t stride = sizeof(float) * (size_t)padded;
+    Uint8 *block = (Uint8 *)SDL_aligned_alloc(ACTOR_ALIGN, stride * ACTOR_WORD_ARRAYS + (size_t)padded * ACTOR_BYTE_ARRAYS);
+    if (!block) {
+        return 0;
+    }
+
+    Uint8 *next = block;
+    float **floats[] = { &table->x, &table->y, &table->w, &table->h, &table->prev_x, &table->prev_y,
+                         &table->vy, &table->move_x, &table->move_y, &table->spawn_x, &table->spawn_y };
+    for (int i = 0; i < (int)SDL_arraysize(floats); i++, next += stride) {
+        *floats[i] = (float *)next;
+    }
+    table->buttons = (Uint32 *)next;
+    next += stride;
+    table->events = (Uint32 *)next;
+    next += stride;
+    Sint32 **ints[] = { &table->coyote_timer, &table->jump_buffer, &table->invincibility_timer, &table->walk_timer };
+    for (int i = 0; i < (int)SDL_arraysize(ints); i++, next += stride) {
+        *ints[i] = (Sint32 *)next;
+    }
+    Uint8 **bytes[] = { &table->kind, &table->on_ground, &table->double_jump_used, &table->walking };
+    for (int i = 0; i < (int)SDL_arraysize(bytes); i++, next += padded) {
+        *bytes[i] = next;
+    }
+    table->capacity = capacity;
+    return 1;
+}
+
+void actor_table_free(ActorTable *table)
+{
+    // x is the start of the shared block
+    SDL_aligned_free(table->x);
+    SDL_zerop(table);
+}
+
+int actor_add(ActorTable *table, ActorKind kind, SDL_FRect rect)
+{
+    if (table->count == table->capacity) {
+        return -1;
+    }
+    int i = table->count++;
+    table->kind[i] = (Uint8)kind;
+    table->w[i] = rect.w;
+    table->h[i] = rect.h;
+    table->spawn_x[i] = rect.x;
+    table->spawn_y[i] = rect.y;
+    actor_respawn(table, i);
+    return i;
+}
+
+void actor_respawn(ActorTable *table, int i)
+{
+    table->x[i] = table->prev_x[i] = table->spawn_x[i];
+    table->y[i] = table->prev_y[i] = table->spawn_y[i];
+    table->vy[i] = 0;
+    table->move_x[i] = table->move_y[i] = 0;
+    table->buttons[i] = 0;
+    table->events[i] = 0;
+    table->coyote_timer[i] = 0;
+    table->jump_buffer[i] = 0;
+    table->invincibility_timer[i] = 0;
+    table->walk_timer[i] = 0;
+    table->on_ground[i] = 0;
+    table->double_jump_used[i] = 0;
+    table->walking[i] = 0;
+}
+
+SDL_FRect actor_rect(const ActorTable *table, int i)
+{
+    return (SDL_FRect){table->x[i], table->y[i], table->w[i], table->h[i]};
+}
+
+SDL_FRect actor_prev_rect(const ActorTable *table, int i)
+{
+    return (SDL_FRect){table->prev_x[i], table->prev_y[i], table->w[i], table->h[i]};
+}
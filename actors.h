@@ -0,0 +1,58 @@
+/*
+  Structure-of-arrays actor table.
+
+  The player and any AI-driven walkers share the platformer physics, so
+  their state lives side by side in parallel arrays and each simulation
+  step is a loop over a range of actors. The player is always actor 0.
+*/
+#ifndef ACTORS_H
+#define ACTORS_H
+
+#include <SDL3/SDL.h>
+
+#define ACTOR_PLAYER 0
+
+typedef enum {
+    ACTOR_KIND_PLAYER,
+    ACTOR_KIND_WALKER // Walks until blocked and hops now and then
+} ActorKind;
+
+// Things that happened to an actor during the last tick
+#define ACTOR_EVENT_STEP 0x01 // Walked on the ground
+#define ACTOR_EVENT_JUMP 0x02
+#define ACTOR_EVENT_LAND 0x04 // Stood on or landed on a static platform
+#define ACTOR_EVENT_BLOCKED 0x08 // Horizontal move was cut short
+
+typedef struct {
+    float *x, *y, *w, *h;
+    float *prev_x, *prev_y; // Position at the start of the last tick, for interpolation
+    float *vy;
+    float *move_x, *move_y; // Movement wanted this tick, before collision
+    float *spawn_x, *spawn_y; // Where the actor respawns after a fall or lava
+    Uint32 *buttons; // GameInput buttons for the coming tick
+    Uint32 *events;
+    Sint32 *coyote_timer;
+    Sint32 *jump_buffer;
+    Sint32 *invincibility_timer;
+    Sint32 *walk_timer; // Ticks spent walking
+    Uint8 *kind;
+    Uint8 *on_ground;
+    Uint8 *double_jump_used;
+    Uint8 *walking;
+    int count;
+    int capacity;
+} ActorTable;
+
+int actor_table_init(ActorTable *table, int capacity);
+void actor_table_free(ActorTable *table);
+
+// Adds an actor at rest at rect; returns its index, or -1 if the table is full.
+int actor_add(ActorTable *table, ActorKind kind, SDL_FRect rect);
+
+// Puts an actor back at its spawn point with its movement state cleared.
+void actor_respawn(ActorTable *table, int i);
+
+SDL_FRect actor_rect(const ActorTable *table, int i);
+SDL_FRect actor_prev_rect(const ActorTable *table, int i);
+
+#endif /* ACTORS_H */
@@ -0,0 +1,100 @@
+/*
+  Bump allocator.
+*/
+#include "arena.h"
+
+struct ArenaBlock {
+    ArenaBlock *next;
+    size_t size;
+    size_t used;
+    // Data follows the header
+};
+
+#define ARENA_HEADER_SIZE ((sizeof(ArenaBlock) + 15) & ~(size_t)15)
+
+static ArenaBlock *arena_new_block(size_t size)
+{
+    ArenaBlock *block = (ArenaBlock *)SDL_malloc(ARENA_HEADER_SIZE + size);
+    if (!block) {
+        return NULL;
+    }
+    block->next = NULL;
+    block->size = size;
+    block->used = 0;
+    return block;
+}
+
+int arena_init(Arena *arena, size_t block_size)
+{
+    SDL_zerop(arena);
+    arena->block_size = block_size;
+    arena->blocks = arena_new_block(block_size);
+    return arena->blocks != NULL;
+}
+
+void arena_free(Arena *arena)
+{
+    ArenaBlock *block = arena->blocks;
+    while (block) {
+        ArenaBlock *next = block->next;
+        SDL_free(block);
+        block = next;
+    }
+    SDL_zerop(arena);
+}
+
+void arena_reset(Arena *arena)
+{
+    ArenaBlock *block = arena->blocks;
+    while (block && block->next) {
+        ArenaBlock *next = block->next;
+        SDL_free(block);
+        block = next;
+    }
+    arena->blocks = block;
+    if (block) {
+        block->used = 0;
+    }
+}
+
+void *arena_alloc(Arena *arena, size_t size, size_t align)
+{
+    if (align < 1) {
+        align = 1;
+    }
+
+    ArenaBlock *block = arena->blocks;
+    size_t offset = 0;
+    if (block) {
+        offset = (block->used + align - 1) & ~(align - 1);
+    }
+
+    // Spill into a new block when the current one is full
+    if (!block || offset + size > block->size) {
+        size_t block_size = arena->block_size;
+        if (block_size < size + align) {
+            block_size = size + align;
+        }
+        block = arena_new_block(block_size);
+        if (!block) {
+            return NULL;
+        }
+        block->next = arena->blocks;
+        arena->blocks = block;
+        offset = 0;
+    }
+
+    Uint8 *data = (Uint8 *)block + ARENA_HEADER_SIZE + offset;
+    block->used = offset + size;
+    SDL_memset(data, 0, size);
+    return data;
+}
+
+size_t arena_used(const Arena *arena)
+{
+    size_t used = 0;
+    for (const ArenaBlock *block = arena->blocks; block; block = block->next) {
+        used += block->used;
+    }
+    return used;
+}
@@ -0,0 +1,34 @@
+/*
+  Bump allocator for data that shares a lifetime, such as everything that
+  belongs to a loaded level. Allocations are never freed individually; the
+  whole arena is released in one go.
+*/
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <SDL3/SDL.h>
+
+typedef struct ArenaBlock ArenaBlock;
+
+typedef struct {
+    ArenaBlock *blocks; // Most recent block first
+    size_t block_size; // Minimum size of each block
+} Arena;
+
+// Reserves the first block up front so a typical level fits in one allocation.
+int arena_init(Arena *arena, size_t block_size);
+void arena_free(Arena *arena);
+
+// Releases everything allocated so far, keeping the first block for what comes next.
+void arena_reset(Arena *arena);
+
+// Returns zeroed memory, or NULL if the system is out of memory.
+void *arena_alloc(Arena *arena, size_t size, size_t align);
+
+#define ARENA_ALIGN 16
+#define ARENA_NEW(arena, type, count) ((type *)arena_alloc((arena), sizeof(type) * (size_t)(count), ARENA_ALIGN))
+
+// Total bytes handed out, for diagnostics.
+size_t arena_used(const Arena *arena);
+
+#endif /* ARENA_H */
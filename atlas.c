@@ -0,0 +1,194 @@
+/*
+  Sprite atlas, rasterized on the CPU at startup.
+*/
+#include "atlas.h"
+
+#define ATLAS_COLUMNS (ATLAS_WIDTH / ATLAS_CELL)
+#define TWO_PI 6.28f
+
+// Cell layout: the white block, the standing pose, the walk cycle, then the spin
+#define CELL_WHITE 0
+#define CELL_IDLE 1
+#define CELL_WALK 2
+#define CELL_SPIN (CELL_WALK + ATLAS_WALK_FRAMES)
+#define CELL_COUNT (CELL_SPIN + ATLAS_SPIN_FRAMES)
+
+SDL_COMPILE_TIME_ASSERT(atlas_fits, (CELL_COUNT + ATLAS_COLUMNS - 1) / ATLAS_COLUMNS * ATLAS_CELL <= ATLAS_HEIGHT);
+
+typedef struct {
+    Uint32 *pixels;
+    int origin_x, origin_y; // Centre of the cell being drawn
+} Canvas;
+
+static void plot(Canvas *canvas, float x, float y)
+{
+    int px = canvas->origin_x + (int)SDL_floorf(x);
+    int py = canvas->origin_y + (int)SDL_floorf(y);
+    if (px >= 0 && px < ATLAS_WIDTH && py >= 0 && py < ATLAS_HEIGHT) {
+        canvas->pixels[py * ATLAS_WIDTH + px] = 0xFFFFFFFF;
+    }
+}
+
+// Same coverage SDL_RenderFillRect gives, relative to the cell centre
+static void fill_rect(Canvas *canvas, float x, float y, float w, float h)
+{
+    for (float py = y; py < y + h; py += 1.0f) {
+        for (float px = x; px < x + w; px += 1.0f) {
+            plot(canvas, px, py);
+        }
+    }
+}
+
+// One pixel wide line, stepping along the longer axis like SDL_RenderLine
+static void draw_line(Canvas *canvas, float x0, float y0, float x1, float y1)
+{
+    float dx = x1 - x0, dy = y1 - y0;
+    int steps = (int)SDL_ceilf(SDL_max(SDL_fabsf(dx), SDL_fabsf(dy)));
+    if (steps == 0) {
+        plot(canvas, x0, y0);
+        return;
+    }
+    for (int i = 0; i <= steps; i++) {
+        float t = (float)i / steps;
+        plot(canvas, x0 + dx * t + 0.5f, y0 + dy * t + 0.5f);
+    }
+}
+
+static SDL_FRect cell_coords(int cell)
+{
+    float x = (float)(cell % ATLAS_COLUMNS * ATLAS_CELL);
+    float y = (float)(cell / ATLAS_COLUMNS * ATLAS_CELL);
+    return (SDL_FRect){x / ATLAS_WIDTH, y / ATLAS_HEIGHT, (float)ATLAS_CELL / ATLAS_WIDTH, (float)ATLAS_CELL / ATLAS_HEIGHT};
+}
+
+static void begin_cell(Canvas *canvas, int cell)
+{
+    canvas->origin_x = cell % ATLAS_COLUMNS * ATLAS_CELL + ATLAS_CELL / 2;
+    canvas->origin_y = cell / ATLAS_COLUMNS * ATLAS_CELL + ATLAS_CELL / 2;
+}
+
+// Fat/chubby stick figure, upright; walking swings the arms and legs by phase
+static void draw_figure(Canvas *canvas, int walking, float phase)
+{
+    // Bigger head (circle approximated with filled rect)
+    fill_rect(canvas, -5, -20, 10, 8);
+
+    // Fat body (wide oval approximated with filled rect)
+    fill_rect(canvas, -8, -12, 16, 20);
+
+    // Shorter arms extending from wider body
+    float arm_swing = walking ? SDL_sinf(phase) * 2.0f : 0.0f;
+    draw_line(canvas, -8, -2 + arm_swing, -12, 2 + arm_swing);
+    draw_line(canvas, 8, -2 - arm_swing, 12, 2 - arm_swing);
+
+    if (walking) {
+        // Walking legs - alternating positions (shorter stride for fat person)
+        float leg_swing = SDL_sinf(phase) * 2.0f;
+        float leg_forward = SDL_sinf(phase + 3.14f) * 2.0f; // Opposite phase
+        draw_line(canvas, -4, 8, -6 + leg_swing, 17);
+        draw_line(canvas, 4, 8, 6 + leg_forward, 17);
+    } else {
+        // Static legs
+        draw_line(canvas, -4, 8, -6, 17);
+        draw_line(canvas, 4, 8, 6, 17);
+    }
+}
+
+// The figure turned by angle, as drawn while the player spins after dying
+static void draw_spinning_figure(Canvas *canvas, float angle_rad)
+{
+    float cos_a = SDL_cosf(angle_rad);
+    float sin_a = SDL_sinf(angle_rad);
+
+    // Head, body corners, hands and feet relative to the centre
+    static const float points[7][2] = {
+        {0, -16}, {-8, -2}, {8, -2}, {-12, 2}, {12, 2}, {-6, 17}, {6, 17}
+    };
+    float rotated[7][2];
+    for (int i = 0; i < 7; i++) {
+        rotated[i][0] = points[i][0] * cos_a - points[i][1] * sin_a;
+        rotated[i][1] = points[i][0] * sin_a + points[i][1] * cos_a;
+    }
+
+    fill_rect(canvas, rotated[0][0] - 5, rotated[0][1] - 4, 10, 8);
+
+    // Fat body as several parallel lines
+    for (int offset = -3; offset <= 3; offset++) {
+        draw_line(canvas, rotated[1][0] + offset, rotated[1][1], rotated[2][0] + offset, rotated[2][1]);
+    }
+
+    // Arms and legs
+    draw_line(canvas, rotated[1][0], rotated[1][1], rotated[3][0], rotated[3][1]);
+    draw_line(canvas, rotated[2][0], rotated[2][1], rotated[4][0], rotated[4][1]);
+    draw_line(canvas, rotated[1][0], rotated[1][1], rotated[5][0], rotated[5][1]);
+    draw_line(canvas, rotated[2][0], rotated[2][1], rotated[6][0], rotated[6][1]);
+}
+
+int atlas_init(Atlas *atlas, SDL_Renderer *renderer)
+{
+    SDL_zerop(atlas);
+    Canvas canvas;
+    canvas.pixels = (Uint32 *)SDL_calloc(ATLAS_WIDTH * ATLAS_HEIGHT, sizeof(Uint32));
+    if (!canvas.pixels) {
+        return 0;
+    }
+
+    // Whole cell so sampling anywhere near the middle stays white
+    begin_cell(&canvas, CELL_WHITE);
+    fill_rect(&canvas, -ATLAS_CELL / 2, -ATLAS_CELL / 2, ATLAS_CELL, ATLAS_CELL);
+    SDL_FRect white = cell_coords(CELL_WHITE);
+    atlas->white = (SDL_FPoint){white.x + white.w / 2, white.y + white.h / 2};
+
+    begin_cell(&canvas, CELL_IDLE);
+    draw_figure(&canvas, 0, 0.0f);
+    atlas->idle = cell_coords(CELL_IDLE);
+
+    for (int i = 0; i < ATLAS_WALK_FRAMES; i++) {
+        begin_cell(&canvas, CELL_WALK + i);
+        draw_figure(&canvas, 1, TWO_PI * i / ATLAS_WALK_FRAMES);
+        atlas->walk[i] = cell_coords(CELL_WALK + i);
+    }
+
+    for (int i = 0; i < ATLAS_SPIN_FRAMES; i++) {
+        begin_cell(&canvas, CELL_SPIN + i);
+        draw_spinning_figure(&canvas, 6.28318f * i / ATLAS_SPIN_FRAMES);
+        atlas->spin[i] = cell_coords(CELL_SPIN + i);
+    }
+
+    atlas->texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC,
+                                       ATLAS_WIDTH, ATLAS_HEIGHT);
+    if (!atlas->texture) {
+        SDL_free(canvas.pixels);
+        return 0;
+    }
+    // Crisp pixels like the line drawing it replaces
+    SDL_SetTextureScaleMode(atlas->texture, SDL_SCALEMODE_NEAREST);
+    SDL_SetTextureBlendMode(atlas->texture, SDL_BLENDMODE_BLEND);
+    SDL_UpdateTexture(atlas->texture, NULL, canvas.pixels, ATLAS_WIDTH * sizeof(Uint32));
+    SDL_free(canvas.pixels);
+    return 1;
+}
+
+void atlas_free(Atlas *atlas)
+{
+    if (atlas->texture) {
+        SDL_DestroyTexture(atlas->texture);
+    }
+    SDL_zerop(atlas);
+}
+
+const SDL_FRect *atlas_walk_frame(const Atlas *atlas, float phase)
+{
+    int frame = (int)(phase / TWO_PI * ATLAS_WALK_FRAMES);
+    return &atlas->walk[SDL_clamp(frame, 0, ATLAS_WALK_FRAMES - 1)];
+}
+
+const SDL_FRect *atlas_spin_frame(const Atlas *atlas, float degrees)
+{
+    int frame = (int)SDL_roundf(degrees / 360.0f * ATLAS_SPIN_FRAMES);
+    frame %= ATLAS_SPIN_FRAMES;
+    if (frame < 0) {
+        frame += ATLAS_SPIN_FRAMES;
+    }
+    return &atlas->spin[frame];
+}
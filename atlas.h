@@ -0,0 +1,40 @@
+/*
+  Sprite atlas.
+
+  The stick figure poses - standing, a walk cycle and the spin used for the
+  death animation - are rasterized once at startup into a single texture,
+  white on transparent so the vertex colour tints them. The atlas also
+  holds a solid white block that untextured quads sample, so coloured
+  rects and sprites go through the same quad batch in one draw call.
+*/
+#ifndef ATLAS_H
+#define ATLAS_H
+
+#include <SDL3/SDL.h>
+
+#define ATLAS_WIDTH 512
+#define ATLAS_HEIGHT 256
+#define ATLAS_CELL 48 // Every sprite is a cell this size with the figure centred in it
+#define ATLAS_WALK_FRAMES 8 // Over one full walk cycle
+#define ATLAS_SPIN_FRAMES 32 // Over one full turn
+
+typedef struct {
+    SDL_Texture *texture;
+    SDL_FPoint white; // Texture coordinate inside the solid white block
+
+    // Texture coordinates (0 to 1) of each sprite
+    SDL_FRect idle;
+    SDL_FRect walk[ATLAS_WALK_FRAMES];
+    SDL_FRect spin[ATLAS_SPIN_FRAMES];
+} Atlas;
+
+int atlas_init(Atlas *atlas, SDL_Renderer *renderer);
+void atlas_free(Atlas *atlas);
+
+// Walk cycle frame for a phase in radians.
+const SDL_FRect *atlas_walk_frame(const Atlas *atlas, float phase);
+
+// Spin frame nearest to a rotation in degrees.
+const SDL_FRect *atlas_spin_frame(const Atlas *atlas, float degrees);
+
+#endif /* ATLAS_H */
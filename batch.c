@@ -0,0 +1,132 @@
+/*
+  Coloured quad batcher.
+*/
+#include "batch.h"
+
+static int quad_batch_reserve(QuadBatch *batch, int capacity)
+{
+    if (capacity <= batch->capacity) {
+        return 1;
+    }
+
+    int new_capacity = batch->capacity ? batch->capacity : 256;
+    while (new_capacity < capacity) {
+        new_capacity *= 2;
+    }
+
+    SDL_Vertex *vertices = (SDL_Vertex *)SDL_realloc(batch->vertices, sizeof(SDL_Vertex) * 4 * new_capacity);
+    if (!vertices) {
+        return 0;
+    }
+    batch->vertices = vertices;
+
+    int *indices = (int *)SDL_realloc(batch->indices, sizeof(int) * 6 * new_capacity);
+    if (!indices) {
+        return 0;
+    }
+    batch->indices = indices;
+
+    // The index pattern never changes, so it is written once per slot
+    for (int i = batch->capacity; i < new_capacity; i++) {
+        int v = i * 4;
+        int *idx = &indices[i * 6];
+        idx[0] = v + 0;
+        idx[1] = v + 1;
+        idx[2] = v + 2;
+        idx[3] = v + 2;
+        idx[4] = v + 3;
+        idx[5] = v + 0;
+    }
+
+    batch->capacity = new_capacity;
+    return 1;
+}
+
+int quad_batch_init(QuadBatch *batch, int capacity)
+{
+    SDL_zerop(batch);
+    return quad_batch_reserve(batch, capacity);
+}
+
+void quad_batch_free(QuadBatch *batch)
+{
+    SDL_free(batch->vertices);
+    SDL_free(batch->indices);
+    SDL_zerop(batch);
+}
+
+static SDL_Vertex *quad_batch_next(QuadBatch *batch, float x, float y, float w, float h,
+                                   Uint8 r, Uint8 g, Uint8 b, Uint8 a)
+{
+    if (batch->num_quads >= batch->capacity && !quad_batch_reserve(batch, batch->num_quads + 1)) {
+        return NULL;
+    }
+
+    SDL_FColor color = {r / 255.0f, g / 255.0f, b / 255.0f, a / 255.0f};
+    x += batch->offset.x;
+    y += batch->offset.y;
+    SDL_Vertex *v = &batch->vertices[batch->num_quads * 4];
+    v[0].position = (SDL_FPoint){x, y};
+    v[1].position = (SDL_FPoint){x + w, y};
+    v[2].position = (SDL_FPoint){x + w, y + h};
+    v[3].position = (SDL_FPoint){x, y + h};
+    for (int i = 0; i < 4; i++) {
+        v[i].color = color;
+    }
+    batch->num_quads++;
+    return v;
+}
+
+void quad_batch_add(QuadBatch *batch, float x, float y, float w, float h,
+                    Uint8 r, Uint8 g, Uint8 b, Uint8 a)
+{
+    SDL_Vertex *v = quad_batch_next(batch, x, y, w, h, r, g, b, a);
+    if (v) {
+        for (int i = 0; i < 4; i++) {
+            v[i].tex_coord = batch->white;
+        }
+    }
+}
+
+void quad_batch_add_rect(QuadBatch *batch, const SDL_FRect *rect, Uint8 r, Uint8 g, Uint8 b, Uint8 a)
+{
+    quad_batch_add(batch, rect->x, rect->y, rect->w, rect->h, r, g, b, a);
+}
+
+void quad_batch_set_offset(QuadBatch *batch, float x, float y)
+{
+    batch->offset = (SDL_FPoint){x, y};
+}
+
+void quad_batch_set_texture(QuadBatch *batch, SDL_Renderer *renderer, SDL_Texture *texture, SDL_FPoint white)
+{
+    if (texture != batch->texture) {
+        quad_batch_flush(batch, renderer);
+    }
+    batch->texture = texture;
+    batch->white = white;
+}
+
+void quad_batch_add_sprite(QuadBatch *batch, float x, float y, float w, float h, const SDL_FRect *uv,
+                           Uint8 r, Uint8 g, Uint8 b, Uint8 a)
+{
+    SDL_Vertex *v = quad_batch_next(batch, x, y, w, h, r, g, b, a);
+    if (v) {
+        v[0].tex_coord = (SDL_FPoint){uv->x, uv->y};
+        v[1].tex_coord = (SDL_FPoint){uv->x + uv->w, uv->y};
+        v[2].tex_coord = (SDL_FPoint){uv->x + uv->w, uv->y + uv->h};
+        v[3].tex_coord = (SDL_FPoint){uv->x, uv->y + uv->h};
+    }
+}
+
+void quad_batch_flush(QuadBatch *batch, SDL_Renderer *renderer)
+{
+    if (batch->num_quads == 0) {
+        return;
+    }
+
+    SDL_RenderGeometry(renderer, batch->texture, batch->vertices, batch->num_quads * 4,
+                       batch->indices, batch->num_quads * 6);
+    batch->num_quads = 0;
+    batch->draw_calls++;
+}
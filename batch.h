@@ -0,0 +1,46 @@
+/*
+  Coloured quad batcher.
+
+  Quads are collected into a vertex buffer with per-vertex colour and
+  submitted with a single SDL_RenderGeometry call when the batch is flushed,
+  instead of a draw colour change and a fill call per rectangle.
+
+  With a texture set, sprites can be mixed in: plain quads sample a white
+  texel of it, so they still go out in the same call.
+*/
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <SDL3/SDL.h>
+
+typedef struct {
+    SDL_Vertex *vertices;
+    int *indices;
+    int num_quads;
+    int capacity; // in quads, grows as needed
+    int draw_calls; // submissions since the counter was last reset
+    SDL_Texture *texture; // NULL for untextured quads only
+    SDL_FPoint white; // Texture coordinate plain quads use
+    SDL_FPoint offset; // Added to every quad's position, e.g. to draw the world relative to a camera
+} QuadBatch;
+
+int quad_batch_init(QuadBatch *batch, int capacity);
+void quad_batch_free(QuadBatch *batch);
+void quad_batch_add(QuadBatch *batch, float x, float y, float w, float h,
+                    Uint8 r, Uint8 g, Uint8 b, Uint8 a);
+void quad_batch_add_rect(QuadBatch *batch, const SDL_FRect *rect, Uint8 r, Uint8 g, Uint8 b, Uint8 a);
+
+// Sets the offset applied to quads added from now on.
+void quad_batch_set_offset(QuadBatch *batch, float x, float y);
+
+// Sets the texture sprites come from and a white texel in it; flushes first if it changes.
+void quad_batch_set_texture(QuadBatch *batch, SDL_Renderer *renderer, SDL_Texture *texture, SDL_FPoint white);
+
+// Adds a quad showing the uv rect (0 to 1) of the batch texture, tinted by the colour.
+void quad_batch_add_sprite(QuadBatch *batch, float x, float y, float w, float h, const SDL_FRect *uv,
+                           Uint8 r, Uint8 g, Uint8 b, Uint8 a);
+
+// Draws everything queued so far in one call and empties the batch.
+void quad_batch_flush(QuadBatch *batch, SDL_Renderer *renderer);
+
+#endif /* BATCH_H */
@@ -0,0 +1,268 @@
+/*
+  Uniform grid broadphase.
+*/
+#include "broadphase.h"
+
+static int rects_overlap(const SDL_FRect *a, const SDL_FRect *b)
+{
+    return (a->x < b->x + b->w && a->x + a->w > b->x && a->y < b->y + b->h && a->y + a->h > b->y);
+}
+
+static int clamp_cell(int v, int max)
+{
+    return v < 0 ? 0 : (v >= max ? max - 1 : v);
+}
+
+// Cell range covered by a rect, clamped to the grid
+static SDL_Rect cell_range(const Broadphase *bp, const SDL_FRect *rect)
+{
+    int x0 = clamp_cell((int)SDL_floorf((rect->x - bp->origin_x) * bp->inv_cell_size), bp->cols);
+    int y0 = clamp_cell((int)SDL_floorf((rect->y - bp->origin_y) * bp->inv_cell_size), bp->rows);
+    int x1 = clamp_cell((int)SDL_floorf((rect->x + rect->w - bp->origin_x) * bp->inv_cell_size), bp->cols);
+    int y1 = clamp_cell((int)SDL_floorf((rect->y + rect->h - bp->origin_y) * bp->inv_cell_size), bp->rows);
+    return (SDL_Rect){x0, y0, x1 - x0 + 1, y1 - y0 + 1};
+}
+
+static void link_mover(Broadphase *bp, int mover, SDL_Rect cells)
+{
+    int n = mover * bp->nodes_per_mover;
+    for (int cy = cells.y; cy < cells.y + cells.h; cy++) {
+        for (int cx = cells.x; cx < cells.x + cells.w; cx++) {
+            int cell = cy * bp->cols + cx;
+            BroadphaseNode *node = &bp->nodes[n];
+            node->mover = mover;
+            node->cell = cell;
+            node->prev = -1;
+            node->next = bp->mover_head[cell];
+            if (node->next >= 0) {
+                bp->nodes[node->next].prev = n;
+            }
+            bp->mover_head[cell] = n;
+            n++;
+        }
+    }
+    bp->mover_cells[mover] = cells;
+}
+
+static void unlink_mover(Broadphase *bp, int mover)
+{
+    SDL_Rect cells = bp->mover_cells[mover];
+    int first = mover * bp->nodes_per_mover;
+    for (int n = first; n < first + cells.w * cells.h; n++) {
+        BroadphaseNode *node = &bp->nodes[n];
+        if (node->prev >= 0) {
+            bp->nodes[node->prev].next = node->next;
+        } else {
+            bp->mover_head[node->cell] = node->next;
+        }
+        if (node->next >= 0) {
+            bp->nodes[node->next].prev = node->prev;
+        }
+        node->mover = -1;
+    }
+}
+
+int broadphase_build(Broadphase *bp, Arena *arena, const BroadphaseEntry *statics, int num_statics,
+                     const Uint32 *mover_handles, const SDL_FRect *mover_rects,
+                     const SDL_FRect *mover_bounds, int num_movers, float cell_size)
+{
+    SDL_zerop(bp);
+
+    // Grid bounds cover everything that can ever be queried against
+    float min_x = 0, min_y = 0, max_x = cell_size, max_y = cell_size;
+    int first = 1;
+    for (int i = 0; i < num_statics + num_movers; i++) {
+        const SDL_FRect *r = i < num_statics ? &statics[i].rect : &mover_bounds[i - num_statics];
+        if (first || r->x < min_x) min_x = r->x;
+        if (first || r->y < min_y) min_y = r->y;
+        if (first || r->x + r->w > max_x) max_x = r->x + r->w;
+        if (first || r->y + r->h > max_y) max_y = r->y + r->h;
+        first = 0;
+    }
+
+    bp->origin_x = min_x;
+    bp->origin_y = min_y;
+    bp->cell_size = cell_size;
+    bp->inv_cell_size = 1.0f / cell_size;
+    bp->cols = (int)SDL_ceilf((max_x - min_x) * bp->inv_cell_size) + 1;
+    bp->rows = (int)SDL_ceilf((max_y - min_y) * bp->inv_cell_size) + 1;
+    int num_cells = bp->cols * bp->rows;
+
+    // Count entries per cell, prefix-sum into starts, then fill
+    bp->cell_start = ARENA_NEW(arena, int, num_cells + 1);
+    if (!bp->cell_start) {
+        return 0;
+    }
+    int total = 0;
+    for (int i = 0; i < num_statics; i++) {
+        SDL_Rect c = cell_range(bp, &statics[i].rect);
+        for (int cy = c.y; cy < c.y + c.h; cy++) {
+            for (int cx = c.x; cx < c.x + c.w; cx++) {
+                bp->cell_start[cy * bp->cols + cx + 1]++;
+            }
+        }
+        total += c.w * c.h;
+    }
+    for (int c = 0; c < num_cells; c++) {
+        bp->cell_start[c + 1] += bp->cell_start[c];
+    }
+
+    bp->entries = ARENA_NEW(arena, BroadphaseEntry, total);
+    int *fill = (int *)SDL_malloc(sizeof(int) * num_cells);
+    if (!bp->entries || !fill) {
+        SDL_free(fill);
+        return 0;
+    }
+    SDL_memcpy(fill, bp->cell_start, sizeof(int) * num_cells);
+    for (int i = 0; i < num_statics; i++) {
+        SDL_Rect c = cell_range(bp, &statics[i].rect);
+        for (int cy = c.y; cy < c.y + c.h; cy++) {
+            for (int cx = c.x; cx < c.x + c.w; cx++) {
+                bp->entries[fill[cy * bp->cols + cx]++] = statics[i];
+            }
+        }
+    }
+    SDL_free(fill);
+    bp->cell_end = ARENA_NEW(arena, int, num_cells);
+    if (!bp->cell_end) {
+        return 0;
+    }
+    SDL_memcpy(bp->cell_end, bp->cell_start + 1, sizeof(int) * num_cells);
+
+    // Movers get enough nodes for the largest cell span their rect can have
+    int nodes_per_mover = 1;
+    for (int i = 0; i < num_movers; i++) {
+        int span_w = (int)SDL_ceilf(mover_rects[i].w * bp->inv_cell_size) + 1;
+        int span_h = (int)SDL_ceilf(mover_rects[i].h * bp->inv_cell_size) + 1;
+        if (span_w * span_h > nodes_per_mover) {
+            nodes_per_mover = span_w * span_h;
+        }
+    }
+    bp->num_movers = num_movers;
+    bp->nodes_per_mover = nodes_per_mover;
+    bp->mover_head = ARENA_NEW(arena, int, num_cells);
+    bp->mover_rects = ARENA_NEW(arena, SDL_FRect, num_movers);
+    bp->mover_handles = ARENA_NEW(arena, Uint32, num_movers);
+    bp->mover_cells = ARENA_NEW(arena, SDL_Rect, num_movers);
+    bp->nodes = ARENA_NEW(arena, BroadphaseNode, num_movers * nodes_per_mover);
+    if (!bp->mover_head || !bp->mover_rects || !bp->mover_handles || !bp->mover_cells || !bp->nodes) {
+        return 0;
+    }
+    for (int c = 0; c < num_cells; c++) {
+        bp->mover_head[c] = -1;
+    }
+    for (int i = 0; i < num_movers; i++) {
+        bp->mover_rects[i] = mover_rects[i];
+        bp->mover_handles[i] = mover_handles[i];
+        link_mover(bp, i, cell_range(bp, &mover_rects[i]));
+    }
+
+    return 1;
+}
+
+static void swap_entries(Broadphase *bp, int a, int b)
+{
+    BroadphaseEntry entry = bp->entries[a];
+    bp->entries[a] = bp->entries[b];
+    bp->entries[b] = entry;
+}
+
+void broadphase_remove(Broadphase *bp, Uint32 handle, SDL_FRect rect)
+{
+    if (bp->cols == 0) {
+        return;
+    }
+    SDL_Rect c = cell_range(bp, &rect);
+    for (int cy = c.y; cy < c.y + c.h; cy++) {
+        for (int cx = c.x; cx < c.x + c.w; cx++) {
+            int cell = cy * bp->cols + cx;
+            for (int e = bp->cell_start[cell]; e < bp->cell_end[cell]; e++) {
+                if (bp->entries[e].handle == handle) {
+                    swap_entries(bp, e, --bp->cell_end[cell]);
+                    break;
+                }
+            }
+        }
+    }
+}
+
+void broadphase_restore(Broadphase *bp, Uint32 handle, SDL_FRect rect)
+{
+    if (bp->cols == 0) {
+        return;
+    }
+    SDL_Rect c = cell_range(bp, &rect);
+    for (int cy = c.y; cy < c.y + c.h; cy++) {
+        for (int cx = c.x; cx < c.x + c.w; cx++) {
+            int cell = cy * bp->cols + cx;
+            for (int e = bp->cell_end[cell]; e < bp->cell_start[cell + 1]; e++) {
+                if (bp->entries[e].handle == handle) {
+                    swap_entries(bp, e, bp->cell_end[cell]++);
+                    break;
+                }
+            }
+        }
+    }
+}
+
+void broadphase_move(Broadphase *bp, int mover, SDL_FRect rect)
+{
+    bp->mover_rects[mover] = rect;
+
+    SDL_Rect cells = cell_range(bp, &rect);
+    SDL_Rect old = bp->mover_cells[mover];
+    if (cells.x == old.x && cells.y == old.y && cells.w == old.w && cells.h == old.h) {
+        return;
+    }
+    unlink_mover(bp, mover);
+    link_mover(bp, mover, cells);
+}
+
+int broadphase_query(Broadphase *bp, SDL_FRect box, Uint32 *out, int max_out)
+{
+    int found = 0;
+    SDL_AddAtomicInt(&bp->num_queries, 1);
+
+    if (bp->cols == 0 || box.x + box.w < bp->origin_x || box.y + box.h < bp->origin_y ||
+        box.x > bp->origin_x + bp->cols * bp->cell_size || box.y > bp->origin_y + bp->rows * bp->cell_size) {
+        return 0;
+    }
+
+    SDL_Rect q = cell_range(bp, &box);
+    for (int cy = q.y; cy < q.y + q.h; cy++) {
+        for (int cx = q.x; cx < q.x + q.w; cx++) {
+            int cell = cy * bp->cols + cx;
+
+            // An entity spanning several cells is only reported from the first
+            // cell it shares with the query, so results need no de-duplication
+            for (int e = bp->cell_start[cell]; e < bp->cell_end[cell]; e++) {
+                const BroadphaseEntry *entry = &bp->entries[e];
+                if (!rects_overlap(&entry->rect, &box)) {
+                    continue;
+                }
+                SDL_Rect ec = cell_range(bp, &entry->rect);
+                if (cx != SDL_max(ec.x, q.x) || cy != SDL_max(ec.y, q.y)) {
+                    continue;
+                }
+                if (found < max_out) {
+                    out[found++] = entry->handle;
+                }
+            }
+
+            for (int n = bp->mover_head[cell]; n >= 0; n = bp->nodes[n].next) {
+                int mover = bp->nodes[n].mover;
+                if (!rects_overlap(&bp->mover_rects[mover], &box)) {
+                    continue;
+                }
+                SDL_Rect mc = bp->mover_cells[mover];
+                if (cx != SDL_max(mc.x, q.x) || cy != SDL_max(mc.y, q.y)) {
+                    continue;
+                }
+                if (found < max_out) {
+                    out[found++] = bp->mover_handles[mover];
+                }
+            }
+        }
+    }
+    return found;
+}
@@ -0,0 +1,85 @@
+/*
+  Uniform grid broadphase for AABB queries against level geometry.
+
+  Static entities are binned once into a packed cell table. They can be
+  taken out and put back cheaply, which moves them past the end of the live
+  part of each cell they are in, so queries never see them. Moving entities
+  live in a separate per-cell linked list so they can be re-binned
+  incrementally as they move. Queries only visit the cells the query box
+  overlaps, and report each overlapping entity exactly once.
+*/
+#ifndef BROADPHASE_H
+#define BROADPHASE_H
+
+#include <SDL3/SDL.h>
+
+#include "arena.h"
+
+typedef enum {
+    ENTITY_PLATFORM,
+    ENTITY_LAVA,
+    ENTITY_GOAL,
+    ENTITY_COLLECTIBLE,
+    ENTITY_MOVING_PLATFORM
+} EntityType;
+
+// Entities are referred to by a handle packing the type and the index into its array
+#define ENTITY_HANDLE(type, index) (((Uint32)(type) << 24) | ((Uint32)(index) & 0xFFFFFF))
+#define ENTITY_TYPE(handle) ((EntityType)((handle) >> 24))
+#define ENTITY_INDEX(handle) ((int)((handle) & 0xFFFFFF))
+
+#define BROADPHASE_CELL_SIZE 128.0f
+
+typedef struct {
+    Uint32 handle;
+    SDL_FRect rect;
+} BroadphaseEntry;
+
+typedef struct {
+    int mover; // Index of the moving entity, or -1 when free
+    int cell;
+    int prev, next; // Links within the cell's list
+} BroadphaseNode;
+
+typedef struct {
+    float origin_x, origin_y;
+    float cell_size, inv_cell_size;
+    int cols, rows;
+
+    // Static entities, packed by cell: cell c owns entries [cell_start[c], cell_start[c + 1]), of
+    // which those before cell_end[c] are live and the rest have been removed
+    int *cell_start;
+    int *cell_end;
+    BroadphaseEntry *entries;
+
+    // Moving entities: a fixed slice of nodes per mover, linked into the cells it covers
+    int num_movers;
+    int nodes_per_mover;
+    SDL_FRect *mover_rects;
+    Uint32 *mover_handles;
+    SDL_Rect *mover_cells; // Cell range each mover is currently linked into
+    int *mover_head; // Per-cell list head, -1 when empty
+    BroadphaseNode *nodes;
+
+    SDL_AtomicInt num_queries; // Queries since the counter was last reset; queries may run on several threads
+} Broadphase;
+
+// Builds the grid around the given entities, allocating from arena; the grid
+// lives as long as the arena does. mover_bounds is the area each mover can
+// ever cover, which sizes the grid.
+int broadphase_build(Broadphase *bp, Arena *arena, const BroadphaseEntry *statics, int num_statics,
+                     const Uint32 *mover_handles, const SDL_FRect *mover_rects,
+                     const SDL_FRect *mover_bounds, int num_movers, float cell_size);
+
+// Updates a mover's rect, re-linking it only if the set of cells it covers changed.
+void broadphase_move(Broadphase *bp, int mover, SDL_FRect rect);
+
+// Takes a static entity out of queries, or puts one taken out back; rect is
+// the one it was built with. Doing either twice does nothing.
+void broadphase_remove(Broadphase *bp, Uint32 handle, SDL_FRect rect);
+void broadphase_restore(Broadphase *bp, Uint32 handle, SDL_FRect rect);
+
+// Writes the handles of every entity overlapping box to out and returns how many were found.
+int broadphase_query(Broadphase *bp, SDL_FRect box, Uint32 *out, int max_out);
+
+#endif /* BROADPHASE_H */
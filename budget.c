@@ -0,0 +1,37 @@
+/*
+  Frame budget controller.
+*/
+#include "budget.h"
+
+#include "game.h"
+
+#define BUDGET_SMOOTHING 0.1f // Weight of the newest frame in the average
+#define BUDGET_HIGH 0.9f // Shed detail above this fraction of the target
+#define BUDGET_LOW 0.6f // Restore detail below it
+#define DETAIL_DECREASE 0.95f // Per frame over budget
+#define DETAIL_INCREASE 0.01f // Per frame with headroom
+
+void frame_budget_init(FrameBudget *budget, Uint64 target_ns)
+{
+    budget->target_ns = target_ns;
+    budget->average_ns = 0.0f;
+    budget->detail = 1.0f;
+}
+
+float frame_budget_update(FrameBudget *budget, Uint64 work_ns)
+{
+    if (budget->average_ns == 0.0f) {
+        budget->average_ns = (float)work_ns;
+    } else {
+        budget->average_ns += ((float)work_ns - budget->average_ns) * BUDGET_SMOOTHING;
+    }
+
+    float target = (float)budget->target_ns;
+    if (budget->average_ns > target * BUDGET_HIGH) {
+        budget->detail *= DETAIL_DECREASE;
+    } else if (budget->average_ns < target * BUDGET_LOW) {
+        budget->detail += DETAIL_INCREASE;
+    }
+    budget->detail = SDL_clamp(budget->detail, GAME_MIN_PARTICLE_DETAIL, 1.0f);
+    return budget->detail;
+}
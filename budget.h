@@ -0,0 +1,26 @@
+/*
+  Frame budget controller.
+
+  Watches how long each frame's work takes against a target frame time and
+  steers a detail level between GAME_MIN_PARTICLE_DETAIL and 1: down quickly
+  when frames run over budget, back up slowly once there is headroom again,
+  so a spike of effects doesn't cost the frame rate.
+*/
+#ifndef BUDGET_H
+#define BUDGET_H
+
+#include <SDL3/SDL.h>
+
+typedef struct {
+    Uint64 target_ns;
+    float average_ns; // Smoothed frame work time
+    float detail;
+} FrameBudget;
+
+void frame_budget_init(FrameBudget *budget, Uint64 target_ns);
+
+// Feeds in the work time of the frame just finished, excluding any wait for
+// vsync, and returns the detail level to use next.
+float frame_budget_update(FrameBudget *budget, Uint64 work_ns);
+
+#endif /* BUDGET_H */
@@ -0,0 +1,333 @@
+/*
+  Level chunk streaming.
+*/
+#include "chunks.h"
+
+static int SDLCALL loader_thread(void *data);
+static int read_chunk(ChunkStream *stream, ChunkSlot *slot);
+static int claim_slot(ChunkStream *stream, SDL_Rect need);
+static void queue_slot(ChunkStream *stream, int slot, int urgent);
+
+int chunk_stream_open(ChunkStream *stream, const char *path)
+{
+    SDL_zerop(stream);
+    for (int i = 0; i < CHUNK_SLOTS; i++) {
+        stream->slots[i].chunk = -1;
+    }
+
+    stream->io = SDL_IOFromFile(path, "rb");
+    if (!stream->io) {
+        return 0;
+    }
+    Sint64 size = SDL_GetIOSize(stream->io);
+    if (size < (Sint64)sizeof(LevelFileHeader) ||
+        SDL_ReadIO(stream->io, &stream->header, sizeof(stream->header)) != sizeof(stream->header)) {
+        SDL_SetError("%s: truncated level file", path);
+        chunk_stream_close(stream);
+        return 0;
+    }
+    if (!level_file_check_header(&stream->header, (Uint64)size, path)) {
+        chunk_stream_close(stream);
+        return 0;
+    }
+
+    // The directory is small and always needed, so it is read once up front
+    const LevelTableEntry *directory = &stream->header.tables[LEVEL_TABLE_CHUNKS];
+    stream->num_chunks = (int)directory->count;
+    stream->chunks = (LevelChunk *)SDL_malloc(sizeof(LevelChunk) * stream->num_chunks);
+    stream->resident = (int *)SDL_malloc(sizeof(int) * stream->num_chunks);
+    stream->failures = (Uint8 *)SDL_calloc(stream->num_chunks, 1);
+    if (!stream->chunks || !stream->resident || !stream->failures) {
+        chunk_stream_close(stream);
+        return 0;
+    }
+    size_t directory_size = sizeof(LevelChunk) * stream->num_chunks;
+    if (SDL_SeekIO(stream->io, directory->offset, SDL_IO_SEEK_SET) < 0 ||
+        SDL_ReadIO(stream->io, stream->chunks, directory_size) != directory_size ||
+        !level_file_check_chunks(&stream->header, stream->chunks, path)) {
+        chunk_stream_close(stream);
+        return 0;
+    }
+    for (int i = 0; i < stream->num_chunks; i++) {
+        stream->resident[i] = -1;
+    }
+
+    stream->lock = SDL_CreateMutex();
+    stream->work = SDL_CreateCondition();
+    stream->loaded = SDL_CreateCondition();
+    if (!stream->lock || !stream->work || !stream->loaded) {
+        chunk_stream_close(stream);
+        return 0;
+    }
+    stream->thread = SDL_CreateThread(loader_thread, "chunk loader", stream);
+    if (!stream->thread) {
+        chunk_stream_close(stream);
+        return 0;
+    }
+    return 1;
+}
+
+void chunk_stream_close(ChunkStream *stream)
+{
+    if (stream->thread) {
+        SDL_LockMutex(stream->lock);
+        stream->quit = 1;
+        SDL_SignalCondition(stream->work);
+        SDL_UnlockMutex(stream->lock);
+        SDL_WaitThread(stream->thread, NULL);
+    }
+    for (int i = 0; i < CHUNK_SLOTS; i++) {
+        SDL_free(stream->slots[i].data);
+    }
+    SDL_free(stream->chunks);
+    SDL_free(stream->resident);
+    SDL_free(stream->failures);
+    if (stream->loaded) SDL_DestroyCondition(stream->loaded);
+    if (stream->work) SDL_DestroyCondition(stream->work);
+    if (stream->lock) SDL_DestroyMutex(stream->lock);
+    if (stream->io) SDL_CloseIO(stream->io);
+    SDL_zerop(stream);
+}
+
+SDL_Rect chunk_stream_range(const ChunkStream *stream, SDL_FRect area)
+{
+    float size = (float)stream->header.chunk_size;
+    int cols = (int)stream->header.chunk_cols, rows = (int)stream->header.chunk_rows;
+    int left = SDL_max((int)SDL_floorf(area.x / size) - 1, 0);
+    int top = SDL_max((int)SDL_floorf(area.y / size) - 1, 0);
+    int right = SDL_min((int)SDL_floorf((area.x + area.w) / size), cols - 1);
+    int bottom = SDL_min((int)SDL_floorf((area.y + area.h) / size), rows - 1);
+    return (SDL_Rect){left, top, SDL_max(right - left + 1, 0), SDL_max(bottom - top + 1, 0)};
+}
+
+static int in_range(SDL_Rect range, int col, int row)
+{
+    return col >= range.x && col < range.x + range.w && row >= range.y && row < range.y + range.h;
+}
+
+int chunk_stream_update(ChunkStream *stream, SDL_Rect need, SDL_Rect want)
+{
+    // Usually the camera hasn't crossed into another chunk, so this is all there is to it
+    if (stream->settled && SDL_memcmp(&need, &stream->settled_need, sizeof(need)) == 0 &&
+        SDL_memcmp(&want, &stream->settled_want, sizeof(want)) == 0) {
+        return 1;
+    }
+
+    int cols = (int)stream->header.chunk_cols;
+    int ok = 1;
+    Uint64 now = SDL_GetTicksNS();
+    SDL_LockMutex(stream->lock);
+
+    // Evict whatever has scrolled out of both ranges; slots being read are left for next time
+    for (int i = 0; i < CHUNK_SLOTS; i++) {
+        ChunkSlot *slot = &stream->slots[i];
+        if (slot->chunk < 0 || slot->state == CHUNK_SLOT_LOADING ||
+            in_range(need, slot->chunk % cols, slot->chunk / cols) ||
+            in_range(want, slot->chunk % cols, slot->chunk / cols)) {
+            continue;
+        }
+        stream->resident[slot->chunk] = -1;
+        slot->chunk = -1;
+        slot->state = CHUNK_SLOT_FREE; // A queued slot stays in the queue; the loader skips it
+    }
+
+    // Needed chunks jump the queue; wanted ones only get a slot if one is free
+    for (int pass = 0; pass < 2; pass++) {
+        SDL_Rect range = pass == 0 ? need : want;
+        for (int row = range.y; row < range.y + range.h; row++) {
+            for (int col = range.x; col < range.x + range.w; col++) {
+                int chunk = row * cols + col;
+                int slot = stream->resident[chunk];
+                if (slot >= 0) {
+                    ChunkSlotState state = stream->slots[slot].state;
+                    if (state == CHUNK_SLOT_FAILED && now >= stream->slots[slot].retry_at) {
+                        stream->slots[slot].state = CHUNK_SLOT_QUEUED;
+                        queue_slot(stream, slot, pass == 0);
+                    } else if (pass == 0 && state == CHUNK_SLOT_QUEUED) {
+                        queue_slot(stream, slot, 1);
+                    }
+                    continue;
+                }
+                slot = claim_slot(stream, pass == 0 ? need : (SDL_Rect){0, 0, 0, 0});
+                if (slot < 0) {
+                    if (pass == 0) {
+                        ok = SDL_SetError("Level chunk pool of %d exhausted", CHUNK_SLOTS);
+                    }
+                    continue;
+                }
+                stream->slots[slot].chunk = chunk;
+                stream->slots[slot].state = CHUNK_SLOT_QUEUED;
+                stream->resident[chunk] = slot;
+                queue_slot(stream, slot, pass == 0);
+            }
+        }
+    }
+    // Most updates change nothing, and waking the loader for those would cost a context switch every tick
+    if (stream->queue_count > 0) {
+        SDL_SignalCondition(stream->work);
+    }
+
+    // Wait for the needed chunks
+    for (int row = need.y; row < need.y + need.h; row++) {
+        for (int col = need.x; col < need.x + need.w; col++) {
+            int slot = stream->resident[row * cols + col];
+            if (slot < 0) {
+                continue;
+            }
+            while (stream->slots[slot].state == CHUNK_SLOT_QUEUED || stream->slots[slot].state == CHUNK_SLOT_LOADING) {
+                SDL_WaitCondition(stream->loaded, stream->lock);
+            }
+            if (stream->slots[slot].state == CHUNK_SLOT_FAILED) {
+                ok = 0;
+            }
+        }
+    }
+    SDL_UnlockMutex(stream->lock);
+    stream->settled = ok;
+    stream->settled_need = need;
+    stream->settled_want = want;
+    return ok;
+}
+
+const ChunkSlot *chunk_stream_slot(ChunkStream *stream, int col, int row)
+{
+    if (col < 0 || row < 0 || col >= (int)stream->header.chunk_cols || row >= (int)stream->header.chunk_rows) {
+        return NULL;
+    }
+    SDL_LockMutex(stream->lock);
+    int slot = stream->resident[row * (int)stream->header.chunk_cols + col];
+    const ChunkSlot *result = (slot >= 0 && stream->slots[slot].state == CHUNK_SLOT_READY) ? &stream->slots[slot] : NULL;
+    SDL_UnlockMutex(stream->lock);
+    return result;
+}
+
+Uint32 chunk_stream_loads(ChunkStream *stream)
+{
+    SDL_LockMutex(stream->lock);
+    Uint32 loads = stream->loads;
+    SDL_UnlockMutex(stream->lock);
+    return loads;
+}
+
+/* Finds a free slot, or failing that takes one from a chunk outside keep that isn't being read. */
+static int claim_slot(ChunkStream *stream, SDL_Rect keep)
+{
+    int cols = (int)stream->header.chunk_cols;
+    int victim = -1;
+    for (int i = 0; i < CHUNK_SLOTS; i++) {
+        const ChunkSlot *slot = &stream->slots[i];
+        if (slot->chunk < 0) {
+            return i;
+        }
+        if (victim < 0 && keep.w > 0 && slot->state != CHUNK_SLOT_LOADING &&
+            !in_range(keep, slot->chunk % cols, slot->chunk / cols)) {
+            victim = i;
+        }
+    }
+    if (victim >= 0) {
+        stream->resident[stream->slots[victim].chunk] = -1;
+        stream->slots[victim].chunk = -1;
+        stream->slots[victim].state = CHUNK_SLOT_FREE;
+    }
+    return victim;
+}
+
+/* Puts a slot in the loader's queue, at the front if urgent. A slot already queued is only moved. */
+static void queue_slot(ChunkStream *stream, int slot, int urgent)
+{
+    for (int i = 0; i < stream->queue_count; i++) {
+        int at = (stream->queue_head + i) % CHUNK_SLOTS;
+        if (stream->queue[at] == slot) {
+            if (!urgent) {
+                return;
+            }
+            // Close the gap, then fall through to push it on the front
+            for (int j = i; j > 0; j--) {
+                stream->queue[(stream->queue_head + j) % CHUNK_SLOTS] = stream->queue[(stream->queue_head + j - 1) % CHUNK_SLOTS];
+            }
+            stream->queue_head = (stream->queue_head + 1) % CHUNK_SLOTS;
+            stream->queue_count--;
+            break;
+        }
+    }
+    if (urgent) {
+        stream->queue_head = (stream->queue_head + CHUNK_SLOTS - 1) % CHUNK_SLOTS;
+        stream->queue[stream->queue_head] = slot;
+    } else {
+        stream->queue[(stream->queue_head + stream->queue_count) % CHUNK_SLOTS] = slot;
+    }
+    stream->queue_count++;
+}
+
+static int SDLCALL loader_thread(void *data)
+{
+    ChunkStream *stream = (ChunkStream *)data;
+    SDL_LockMutex(stream->lock);
+    while (!stream->quit) {
+        if (stream->queue_count == 0) {
+            SDL_WaitCondition(stream->work, stream->lock);
+            continue;
+        }
+        int index = stream->queue[stream->queue_head];
+        stream->queue_head = (stream->queue_head + 1) % CHUNK_SLOTS;
+        stream->queue_count--;
+        ChunkSlot *slot = &stream->slots[index];
+        if (slot->state != CHUNK_SLOT_QUEUED) {
+            continue; // Evicted before its turn came
+        }
+
+        slot->state = CHUNK_SLOT_LOADING;
+        SDL_UnlockMutex(stream->lock);
+        int ok = read_chunk(stream, slot);
+        SDL_LockMutex(stream->lock);
+        Uint8 *failures = &stream->failures[slot->chunk];
+        if (ok) {
+            slot->state = CHUNK_SLOT_READY;
+            *failures = 0;
+            stream->loads++;
+        } else {
+            // Back off before trying again, and say so only the first time
+            slot->state = CHUNK_SLOT_FAILED;
+            slot->retry_at = SDL_GetTicksNS() + (CHUNK_RETRY_NS << SDL_min(*failures, CHUNK_RETRY_DOUBLINGS));
+            if (*failures == 0) {
+                SDL_Log("Couldn't read level chunk %d: %s", slot->chunk, SDL_GetError());
+            }
+            if (*failures < 255) {
+                (*failures)++;
+            }
+        }
+        SDL_BroadcastCondition(stream->loaded);
+    }
+    SDL_UnlockMutex(stream->lock);
+    return 0;
+}
+
+/* Reads a chunk's run of every entity table into its slot, one after another. */
+static int read_chunk(ChunkStream *stream, ChunkSlot *slot)
+{
+    const LevelChunk *chunk = &stream->chunks[slot->chunk];
+    size_t offsets[LEVEL_ENTITY_TABLES], size = 0;
+    for (int t = 0; t < LEVEL_ENTITY_TABLES; t++) {
+        offsets[t] = size;
+        size += (level_table_sizes[t] * chunk->count[t] + 15) & ~(size_t)15;
+    }
+    if (size > slot->capacity) {
+        void *data = SDL_realloc(slot->data, size);
+        if (!data) {
+            return 0;
+        }
+        slot->data = data;
+        slot->capacity = size;
+    }
+
+    for (int t = 0; t < LEVEL_ENTITY_TABLES; t++) {
+        Uint8 *out = (Uint8 *)slot->data + offsets[t];
+        size_t bytes = level_table_sizes[t] * chunk->count[t];
+        Sint64 offset = (Sint64)stream->header.tables[t].offset + (Sint64)(level_table_sizes[t] * chunk->first[t]);
+        slot->tables[t] = out;
+        if (bytes > 0 && (SDL_SeekIO(stream->io, offset, SDL_IO_SEEK_SET) < 0 || SDL_ReadIO(stream->io, out, bytes) != bytes)) {
+            return 0;
+        }
+    }
+    return 1;
+}
@@ -0,0 +1,88 @@
+/*
+  Level chunk streaming.
+
+  A ChunkStream keeps a level file open and pages its chunks in and out of a
+  fixed pool of slots as the area of interest moves, so memory use depends
+  on the view rather than on how large the level is. Chunks are read on a
+  loader thread owned by the stream; the caller only waits for chunks it
+  can't do without this tick, and asks for the ones around them early so
+  they are usually in by the time they are needed.
+*/
+#ifndef CHUNKS_H
+#define CHUNKS_H
+
+#include <SDL3/SDL.h>
+
+#include "level_file.h"
+
+#define CHUNK_SLOTS LEVEL_MAX_RESIDENT_CHUNKS
+
+// A chunk that couldn't be read is tried again after this, doubling with each failure up to 2^CHUNK_RETRY_DOUBLINGS times
+#define CHUNK_RETRY_NS (SDL_NS_PER_SECOND / 4)
+#define CHUNK_RETRY_DOUBLINGS 5
+
+typedef enum {
+    CHUNK_SLOT_FREE,
+    CHUNK_SLOT_QUEUED, // Waiting for the loader
+    CHUNK_SLOT_LOADING, // Being read; only the loader touches its data
+    CHUNK_SLOT_READY,
+    CHUNK_SLOT_FAILED
+} ChunkSlotState;
+
+typedef struct {
+    int chunk; // Index in the chunk directory, -1 when free
+    ChunkSlotState state; // Guarded by the stream's lock
+    const void *tables[LEVEL_ENTITY_TABLES]; // The chunk's run of each entity table, once ready
+    void *data; // Backing memory, kept for the next chunk when the slot is reused
+    size_t capacity;
+    Uint64 retry_at; // When a failed read may be tried again
+} ChunkSlot;
+
+typedef struct {
+    LevelFileHeader header;
+    LevelChunk *chunks; // Directory, header.chunk_cols * header.chunk_rows
+    int num_chunks;
+    int *resident; // Per chunk, the slot holding it or -1
+    Uint8 *failures; // Per chunk, reads that have failed in a row; only the first is logged
+    ChunkSlot slots[CHUNK_SLOTS];
+    int queue[CHUNK_SLOTS]; // Slots for the loader, oldest first
+    int queue_head, queue_count;
+
+    SDL_IOStream *io; // Read by the loader only
+    SDL_Thread *thread;
+    SDL_Mutex *lock;
+    SDL_Condition *work; // Signalled when a slot is queued or the stream closes
+    SDL_Condition *loaded; // Broadcast when the loader finishes a slot
+    Uint32 loads; // Chunks read so far
+    int quit;
+
+    // Ranges of the last update, if it got every needed chunk; the same again has nothing to do
+    SDL_Rect settled_need, settled_want;
+    int settled;
+} ChunkStream;
+
+// Reads the header and chunk directory of a level file and starts the
+// loader. The stream must stay at the same address until it is closed.
+// Returns 0 with the SDL error set on failure.
+int chunk_stream_open(ChunkStream *stream, const char *path);
+void chunk_stream_close(ChunkStream *stream);
+
+// Range of chunks, in chunk coordinates, holding every entity that can
+// overlap area; this reaches one chunk further left and up than the area
+// itself, since entities stick out of their chunk to the right and below.
+SDL_Rect chunk_stream_range(const ChunkStream *stream, SDL_FRect area);
+
+// Makes the chunks in need resident, waiting for any that aren't, and starts
+// loading those in want without waiting; chunks in neither are evicted.
+// Returns 0 if a needed chunk couldn't be read or didn't fit in the pool;
+// a chunk that couldn't be read is queued again once its backoff is up.
+int chunk_stream_update(ChunkStream *stream, SDL_Rect need, SDL_Rect want);
+
+// The slot holding chunk (col, row) if it has been read, otherwise NULL.
+// Slots in the last need range stay valid until the next update.
+const ChunkSlot *chunk_stream_slot(ChunkStream *stream, int col, int row);
+
+// Number of chunks read so far; while it hasn't changed, neither has any slot's contents.
+Uint32 chunk_stream_loads(ChunkStream *stream);
+
+#endif /* CHUNKS_H */
@@ -0,0 +1,88 @@
+/*
+  Swept AABB collision.
+*/
+#include "collision.h"
+
+// Overlaps this thin are treated as touching, so rounding after snapping a
+// box to a surface doesn't count as being inside it
+#define COLLISION_EPSILON 0.001f
+
+// Stands in for infinity on an axis the box doesn't move along but overlaps throughout
+#define SWEEP_ALWAYS 1e30f
+
+// Entry and exit times along one axis; returns 0 if the spans never overlap
+static int sweep_axis(float pos, float size, float d, float target_pos, float target_size, float *entry, float *exit)
+{
+    if (d == 0.0f) {
+        if (pos + size <= target_pos + COLLISION_EPSILON || pos >= target_pos + target_size - COLLISION_EPSILON) {
+            return 0;
+        }
+        *entry = -SWEEP_ALWAYS;
+        *exit = SWEEP_ALWAYS;
+        return 1;
+    }
+
+    float near_gap, far_gap;
+    if (d > 0.0f) {
+        near_gap = target_pos - (pos + size);
+        far_gap = target_pos + target_size - pos;
+    } else {
+        near_gap = pos - (target_pos + target_size);
+        far_gap = pos + size - target_pos;
+        d = -d;
+    }
+    // Touching counts as not yet inside
+    if (near_gap < 0.0f && near_gap > -COLLISION_EPSILON) {
+        near_gap = 0.0f;
+    }
+    *entry = near_gap / d;
+    *exit = far_gap / d;
+    return 1;
+}
+
+int collision_sweep(SDL_FRect box, float dx, float dy, SDL_FRect target, CollisionHit *hit)
+{
+    float entry_x, exit_x, entry_y, exit_y;
+    if (!sweep_axis(box.x, box.w, dx, target.x, target.w, &entry_x, &exit_x) ||
+        !sweep_axis(box.y, box.h, dy, target.y, target.h, &entry_y, &exit_y)) {
+        return 0;
+    }
+
+    float entry = SDL_max(entry_x, entry_y);
+    float exit = SDL_min(exit_x, exit_y);
+    if (entry >= exit || entry > 1.0f || exit <= 0.0f) {
+        return 0;
+    }
+
+    // The normal faces back along the axis the box entered on last
+    int along_x = entry_x > entry_y;
+    float d = along_x ? dx : dy;
+    if (entry < 0.0f) {
+        // Already inside: only a move towards the target's centre hits it
+        float to_centre = along_x ? (target.x + target.w * 0.5f) - (box.x + box.w * 0.5f)
+                                  : (target.y + target.h * 0.5f) - (box.y + box.h * 0.5f);
+        if (d * to_centre <= 0.0f) {
+            return 0;
+        }
+        entry = 0.0f;
+    }
+
+    hit->time = entry;
+    hit->normal_x = along_x ? (dx > 0.0f ? -1.0f : 1.0f) : 0.0f;
+    hit->normal_y = along_x ? 0.0f : (dy > 0.0f ? -1.0f : 1.0f);
+    return 1;
+}
+
+SDL_FRect collision_swept_bounds(SDL_FRect box, float dx, float dy)
+{
+    SDL_FRect bounds = box;
+    if (dx < 0.0f) {
+        bounds.x += dx;
+    }
+    if (dy < 0.0f) {
+        bounds.y += dy;
+    }
+    bounds.w += SDL_fabsf(dx);
+    bounds.h += SDL_fabsf(dy);
+    return bounds;
+}
@@ -0,0 +1,28 @@
+/*
+  Swept AABB collision.
+
+  Instead of moving a box and then checking what it ended up inside, the
+  move is swept against each candidate and the earliest time of impact is
+  found. A box can't skip past thin geometry however far it moves in a
+  tick, so the tick rate doesn't have to stay high to keep up with fast
+  movement.
+*/
+#ifndef COLLISION_H
+#define COLLISION_H
+
+#include <SDL3/SDL.h>
+
+typedef struct {
+    float time; // Fraction of the move completed before contact, in [0, 1]
+    float normal_x, normal_y; // Contact normal on the target's surface, pointing at the box
+} CollisionHit;
+
+// Sweeps box by (dx, dy) against target. Returns 1 and fills hit if the box
+// runs into it during the move. A box that already overlaps the target only
+// hits it when moving further in, reported at time 0, so it can't get stuck.
+int collision_sweep(SDL_FRect box, float dx, float dy, SDL_FRect target, CollisionHit *hit);
+
+// Area covered by box over the whole move, for the broadphase query.
+SDL_FRect collision_swept_bounds(SDL_FRect box, float dx, float dy);
+
+#endif /* COLLISION_H */
@@ -0,0 +1,1277 @@
+/*
+  Game simulation.
+*/
+#include "game.h"
+
+#include "collision.h"
+#include "physics.h"
+
+#define LEVEL_ARENA_BLOCK_SIZE (64 * 1024)
+#define ACTIVE_MARGIN ((float)LEVEL_ACTIVE_MARGIN)
+#define MAX_BURST 32 // Largest particle burst emitted at once
+
+// Items per job in the parallel phases - big enough to outweigh the dispatch
+#define ACTOR_JOB_GRAIN 64
+#define PARTICLE_JOB_GRAIN 4096
+
+// Per second, integrated with TICK_DT; movement constants come from the level's physics profile
+static const float SPIN_SPEED = 480.0f; // degrees per second
+static const float LAVA_PARTICLE_RATE = 24.0f; // per second from each lava square
+static const float DUST_PARTICLE_RATE = 40.0f; // per second while walking
+
+static const int INVINCIBILITY_TIME = TICK_RATE * 2; // ticks (2 seconds)
+static const int RESPAWN_INVINCIBILITY_TIME = TICK_RATE; // ticks (1 second)
+static const float ACTOR_WIDTH = 24.0f; // Matches the stick figure
+static const float ACTOR_HEIGHT = 40.0f;
+static const int WALKER_HOP_CHANCE = TICK_RATE * 2; // One in this many grounded ticks starts a hop
+
+// Save states: this fixed part, then the arrays listed by state_arrays() back to back
+typedef struct {
+    Sint64 level_ticks; // The tick counter keeps running through a rewind; the level clock goes back
+    Rng effects_rng, level_rng, ai_rng;
+    SDL_FPoint camera, prev_camera;
+    int game_over, game_won;
+    int score, lives;
+    float global_timer;
+    float player_rotation;
+    int has_double_jump;
+    int collected_count;
+    ParticleEmitter lava_emitter, dust_emitter;
+    int num_actors;
+    int num_particles, particle_limit, particle_recycle;
+} SaveStateHeader;
+
+typedef struct {
+    void *data;
+    size_t size; // Bytes
+} StateArray;
+
+#define MAX_STATE_ARRAYS 32
+
+static SDL_FRect level_rect(const LevelRect *rect);
+static void add_particle(Game *game, float x, float y, float vx, float vy, Uint8 r, Uint8 g, Uint8 b, float life);
+static void emit_burst(Game *game, int count, float x, float y, float spread,
+                       float vx_min, float vx_max, float vy_min, float vy_max,
+                       Uint8 r, Uint8 g, Uint8 b, float life);
+static int burst_size(const Game *game, int count);
+static void update_particles(Game *game);
+static char *level_path(int level_num);
+static int open_level(const char *path, Level *level);
+static int prepare_level(const char *path, Level *level);
+static void release_level(Level *level);
+static int load_level(Game *game, int level_num);
+static void start_level(Game *game);
+static int SDLCALL prefetch_thread(void *data);
+static void start_prefetch(Game *game, int level_num);
+static int take_prefetched_level(Game *game, int level_num, Level *level);
+static void cancel_prefetch(Game *game);
+static void build_level_broadphase(Level *level);
+static void update_chunks(Game *game);
+static void gather_active(Game *game, SDL_Rect range);
+static float collectible_phase(const Level *level, int id);
+static void set_collected(Level *level, int i, int collected);
+static int actor_awake(const Game *game, int i);
+static void reset_actors(Game *game);
+static JobFunc integrate_routine(Uint32 profile, int double_jump);
+static void think_walkers(Game *game, int begin, int end);
+static void collide_actors(void *data, int begin, int end);
+static void integrate_particles(void *data, int begin, int end);
+static void emit_actor_effects(Game *game, int i);
+static SDL_FRect actor_path(const ActorTable *actors, int i);
+static void update_collectibles(Game *game);
+static Sint64 level_ticks(const Game *game);
+static SDL_FPoint platform_position(const MovingPlatform *platform, Sint64 ticks);
+static void place_platform(MovingPlatform *platform, Sint64 ticks);
+static void update_moving_platforms(Game *game);
+static int query_world(Game *game, SDL_FRect box);
+static int first_overlap(Game *game, SDL_FRect box, EntityType type);
+static int sweep_solids(Game *game, SDL_FRect box, float dx, float dy, Uint32 *handle, CollisionHit *hit);
+static SDL_FRect solid_rect(const Level *level, Uint32 handle);
+static void update_camera(Game *game);
+static int state_arrays(Game *game, int num_actors, int num_particles, StateArray *arrays);
+static void save_state(Game *game);
+static int rewind_state(Game *game);
+
+int game_init(Game *game, float width, float height, int particle_capacity, int num_walkers, Uint64 seed,
+              Profiler *profiler)
+{
+    SDL_zerop(game);
+    game->seed = seed;
+    rng_seed(&game->effects_rng, seed, 1);
+    rng_seed(&game->level_rng, seed, 2);
+    rng_seed(&game->ai_rng, seed, 3);
+    game->width = width;
+    game->height = height;
+    game->profiler = profiler;
+    game->lives = 3;
+    game->global_time_limit = 120.0f; // 2 minutes total for all levels
+    game->prefetch.level_num = -1;
+    game->num_walkers = SDL_max(num_walkers, 0);
+    if (!particle_pool_init(&game->particles, particle_capacity) ||
+        !actor_table_init(&game->actors, 1 + game->num_walkers)) {
+        particle_pool_free(&game->particles);
+        return 0;
+    }
+    game->particle_detail = 1.0f;
+    game->lava_emitter.rate = LAVA_PARTICLE_RATE;
+    game->dust_emitter.rate = DUST_PARTICLE_RATE;
+    if (!save_ring_init(&game->rewind, GAME_REWIND_BYTES)) {
+        SDL_Log("Couldn't allocate the rewind buffer, rewinding is off");
+    }
+
+    // A level that fails to load later leaves the routine of the last one, never none
+    game->integrate_actors = integrate_routine(PHYSICS_NORMAL, 0);
+    if (!load_level(game, 0)) {
+        game_free(game);
+        return 0;
+    }
+    reset_actors(game);
+    game->global_timer = game->global_time_limit;
+    return 1;
+}
+
+void game_free(Game *game)
+{
+    cancel_prefetch(game);
+    release_level(&game->loaded_level);
+    actor_table_free(&game->actors);
+    particle_pool_free(&game->particles);
+    particle_queue_free(&game->particle_spawns);
+    save_ring_free(&game->rewind);
+}
+
+void game_restart(Game *game)
+{
+    if (!game->game_over && !game->game_won) {
+        return;
+    }
+
+    // Restart from beginning
+    game->game_over = 0;
+    game->game_won = 0;
+    game->lives = 3;
+    game->score = 0;
+    game->current_level = 0;
+    game->global_timer = game->global_time_limit; // Reset global timer
+    load_level(game, game->current_level);
+    reset_actors(game);
+}
+
+int game_next_level(Game *game)
+{
+    if (!game->game_won || game->current_level >= MAX_LEVELS - 1) {
+        return 0;
+    }
+
+    game->current_level++;
+    game->game_won = 0;
+    load_level(game, game->current_level);
+    reset_actors(game);
+    return 1;
+}
+
+// FNV-1a over a block of state
+static Uint32 hash_bytes(Uint32 hash, const void *data, size_t size)
+{
+    const Uint8 *bytes = (const Uint8 *)data;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+}
+
+Uint32 game_checksum(const Game *game)
+{
+    const ParticlePool *particles = &game->particles;
+    int session[6] = { game->current_level, game->score, game->lives, game->game_over, game->game_won, game->collected_count };
+    Uint32 hash = 2166136261u;
+    hash = hash_bytes(hash, &game->tick, sizeof(game->tick));
+    hash = hash_bytes(hash, session, sizeof(session));
+    hash = hash_bytes(hash, &game->actors.count, sizeof(game->actors.count));
+    hash = hash_bytes(hash, game->actors.x, sizeof(float) * game->actors.count);
+    hash = hash_bytes(hash, game->actors.y, sizeof(float) * game->actors.count);
+    hash = hash_bytes(hash, game->actors.vy, sizeof(float) * game->actors.count);
+    hash = hash_bytes(hash, &particles->count, sizeof(particles->count));
+    hash = hash_bytes(hash, particles->x, sizeof(float) * particles->count);
+    hash = hash_bytes(hash, particles->y, sizeof(float) * particles->count);
+    for (int i = 0; i < game->loaded_level.num_moving; i++) {
+        hash = hash_bytes(hash, &game->loaded_level.moving_platforms[i].rect, sizeof(SDL_FRect));
+    }
+    return hash;
+}
+
+void game_tick(Game *game, const GameInput *input)
+{
+    game->tick++;
+
+    // Session commands arrive as input too, so replays reproduce them
+    if (input->buttons & GAME_INPUT_RESTART) {
+        game_restart(game);
+    }
+    if (input->buttons & GAME_INPUT_NEXT_LEVEL) {
+        game_next_level(game);
+    }
+
+    // Rewinding takes the place of the tick: the state steps back instead of forward
+    if ((input->buttons & GAME_INPUT_REWIND) && rewind_state(game)) {
+        return;
+    }
+
+    // Bring the level in around where the camera ended up last tick
+    update_chunks(game);
+
+    // Remember where everything was for render interpolation
+    ActorTable *actors = &game->actors;
+    SDL_memcpy(actors->prev_x, actors->x, sizeof(float) * actors->count);
+    SDL_memcpy(actors->prev_y, actors->y, sizeof(float) * actors->count);
+    for (int i = 0; i < game->loaded_level.num_moving; i++) {
+        game->loaded_level.moving_platforms[i].prev_rect = game->loaded_level.moving_platforms[i].rect;
+    }
+    game->prev_camera = game->camera;
+
+    if (!game->game_over && !game->game_won) {
+        // Update global timer
+        game->global_timer -= TICK_DT;
+        if (game->global_timer <= 0) {
+            game->game_over = 1;
+        }
+
+        // Handle input, then move every actor
+        Uint64 phase_start = SDL_GetTicksNS();
+        actors->buttons[ACTOR_PLAYER] = input->buttons;
+        think_walkers(game, ACTOR_PLAYER + 1, actors->count);
+        jobs_parallel_for(game->jobs, actors->count, ACTOR_JOB_GRAIN, game->integrate_actors, game);
+
+        profiler_add(game->profiler, PROFILE_INPUT, phase_start);
+        phase_start = SDL_GetTicksNS();
+
+        jobs_parallel_for(game->jobs, actors->count, ACTOR_JOB_GRAIN, collide_actors, game);
+        emit_actor_effects(game, ACTOR_PLAYER);
+
+        // Walkers that fall or touch lava start over from where they spawned
+        Level *level = &game->loaded_level;
+        for (int i = ACTOR_PLAYER + 1; i < actors->count; i++) {
+            if (!actor_awake(game, i)) {
+                continue;
+            }
+            if (actors->y[i] > level->height + 100 || first_overlap(game, actor_path(actors, i), ENTITY_LAVA) >= 0) {
+                actor_respawn(actors, i);
+            }
+        }
+
+        // Lava collision, checked against everything the player passed through this tick
+        int player = ACTOR_PLAYER;
+        if (actors->invincibility_timer[player] <= 0 && first_overlap(game, actor_path(actors, player), ENTITY_LAVA) >= 0) {
+            game->lives--;
+            if (game->lives <= 0) {
+                game->game_over = 1;
+            } else {
+                // Respawn with invincibility
+                actor_respawn(actors, player);
+                actors->invincibility_timer[player] = INVINCIBILITY_TIME;
+            }
+
+            // Death particles
+            emit_burst(game, burst_size(game, 15), actors->x[player] + actors->w[player]/2, actors->y[player] + actors->h[player]/2, 0,
+                       -240.0f, 240.0f, -240.0f, 240.0f, 255, 100, 0, 1.0f);
+        }
+
+        // Fall out of the level
+        if (actors->y[player] > level->height + 100) {
+            game->lives--;
+            if (game->lives <= 0) {
+                game->game_over = 1;
+            } else {
+                actor_respawn(actors, player);
+                actors->invincibility_timer[player] = RESPAWN_INVINCIBILITY_TIME;
+            }
+        }
+
+        // Goal collision
+        if (first_overlap(game, actor_path(actors, player), ENTITY_GOAL) >= 0) {
+            if (game->collected_count >= level->total_collectibles) {
+                game->game_won = 1;
+                game->score += 1000 + (game->lives * 500);
+            }
+        }
+
+        profiler_add(game->profiler, PROFILE_COLLISION, phase_start);
+        phase_start = SDL_GetTicksNS();
+
+        // Lava particles
+        int lava_due = particle_emitter_step(&game->lava_emitter, TICK_DT, game->particle_detail);
+        for (int i = 0; lava_due > 0 && i < level->num_lava; i++) {
+            emit_burst(game, lava_due, level->lava_squares[i].x, level->lava_squares[i].y, level->lava_squares[i].w,
+                       -30.0f, 30.0f, -120.0f, -120.0f, 255, 100, 0, 1.35f);
+        }
+
+        update_collectibles(game);
+        update_moving_platforms(game);
+        profiler_add(game->profiler, PROFILE_ENTITIES, phase_start);
+    } else if (game->game_over) {
+        // Spin when dead
+        game->player_rotation += SPIN_SPEED * TICK_DT;
+        if (game->player_rotation >= 360.0f) {
+            game->player_rotation -= 360.0f;
+        }
+    }
+
+    Uint64 particle_start = SDL_GetTicksNS();
+    update_particles(game);
+    profiler_add(game->profiler, PROFILE_PARTICLES, particle_start);
+
+    update_camera(game);
+
+    // Every so often, something to rewind to
+    if (!game->game_over && !game->game_won && level_ticks(game) % GAME_SAVE_INTERVAL == 0) {
+        save_state(game);
+    }
+}
+
+static void add_particle(Game *game, float x, float y, float vx, float vy, Uint8 r, Uint8 g, Uint8 b, float life)
+{
+    if (game->external_particles) {
+        particle_queue_push(&game->particle_spawns, game->tick, x, y, vx, vy, r, g, b, life);
+        return;
+    }
+    particle_pool_add(&game->particles, x, y, vx, vy, r, g, b, life);
+}
+
+/* Emits count particles from (x, y), spread horizontally over [0, spread) with
+   velocities drawn from the given ranges; the randoms come from one batched fill. */
+static void emit_burst(Game *game, int count, float x, float y, float spread,
+                       float vx_min, float vx_max, float vy_min, float vy_max,
+                       Uint8 r, Uint8 g, Uint8 b, float life)
+{
+    float random[MAX_BURST * 3];
+    if (count > MAX_BURST) {
+        count = MAX_BURST;
+    }
+    rng_fill_floats(&game->effects_rng, random, count * 3, 0.0f, 1.0f);
+
+    // Lower detail also shortens lives, so fewer particles are alive at once
+    life *= 0.5f + 0.5f * game->particle_detail;
+    for (int i = 0; i < count; i++) {
+        const float *u = &random[i * 3];
+        add_particle(game, x + u[0] * spread, y,
+                     vx_min + (vx_max - vx_min) * u[1], vy_min + (vy_max - vy_min) * u[2], r, g, b, life);
+    }
+}
+
+/* Scales a one-off burst by the particle detail, rounding to the nearest particle. */
+static int burst_size(const Game *game, int count)
+{
+    return (int)(count * game->particle_detail + 0.5f);
+}
+
+void game_set_particle_detail(Game *game, float detail)
+{
+    game->particle_detail = SDL_clamp(detail, GAME_MIN_PARTICLE_DETAIL, 1.0f);
+    game->particles.limit = SDL_max((int)(game->particles.capacity * game->particle_detail), 1);
+}
+
+static void update_particles(Game *game)
+{
+    // Integration is independent per particle; removal reorders the pool so it stays serial
+    jobs_parallel_for(game->jobs, game->particles.count, PARTICLE_JOB_GRAIN, integrate_particles, game);
+    particle_pool_compact(&game->particles);
+}
+
+static void integrate_particles(void *data, int begin, int end)
+{
+    Game *game = (Game *)data;
+    particle_integrate(&game->particles, begin, end, TICK_DT, PARTICLE_GRAVITY);
+}
+
+static SDL_FRect level_rect(const LevelRect *rect)
+{
+    return (SDL_FRect){rect->x, rect->y, rect->w, rect->h};
+}
+
+/* levels/level<N>.lvl next to the executable; free it with SDL_free(). */
+static char *level_path(int level_num)
+{
+    char *path = NULL;
+    if (SDL_asprintf(&path, "%slevels/level%d.lvl", SDL_GetBasePath(), level_num) < 0) {
+        return NULL;
+    }
+    return path;
+}
+
+/* Opens a level file for streaming and sets up the state kept for the whole level. */
+static int open_level(const char *path, Level *level)
+{
+    level->stream = ARENA_NEW(&level->arena, ChunkStream, 1);
+    if (!level->stream || !chunk_stream_open(level->stream, path)) {
+        level->stream = NULL;
+        return 0;
+    }
+
+    const LevelFileHeader *header = &level->stream->header;
+    level->width = (float)header->width;
+    level->height = (float)header->height;
+    level->start_pos = level_rect(&header->start);
+    level->goal = level_rect(&header->goal);
+    level->total_collectibles = (int)header->tables[LEVEL_TABLE_COLLECTIBLES].count;
+    level->collected = ARENA_NEW(&level->arena, Uint8, level->total_collectibles);
+    return level->collected != NULL;
+}
+
+/* Opens a level and asks for the chunks around its start; touches no game
+   state, so it can run on the loader thread. */
+static int prepare_level(const char *path, Level *level)
+{
+    SDL_zerop(level);
+    if (!path || !arena_init(&level->arena, LEVEL_ARENA_BLOCK_SIZE) ||
+        !arena_init(&level->active_arena, LEVEL_ARENA_BLOCK_SIZE) || !open_level(path, level)) {
+        release_level(level);
+        return 0;
+    }
+
+    // Nothing is active until the game gathers it, but the start can be read in already
+    SDL_FRect start = level->start_pos;
+    float margin = (float)level->stream->header.chunk_size;
+    SDL_FRect around = {start.x - margin, start.y - margin, start.w + margin * 2, start.h + margin * 2};
+    chunk_stream_update(level->stream, (SDL_Rect){0, 0, 0, 0}, chunk_stream_range(level->stream, around));
+    return 1;
+}
+
+/* Stops streaming and releases everything in the level's arenas. */
+static void release_level(Level *level)
+{
+    if (level->stream) {
+        chunk_stream_close(level->stream);
+    }
+    arena_free(&level->active_arena);
+    arena_free(&level->arena);
+    SDL_zerop(level);
+}
+
+/* Loads and starts a level; returns 0 if it couldn't be loaded, leaving an empty world. */
+static int load_level(Game *game, int level_num)
+{
+    if (level_num >= MAX_LEVELS) return 0;
+
+    // Swap in the prefetched level if it is the one we want, otherwise load it here
+    Level *level = &game->loaded_level;
+    game->level_serial++;
+    save_ring_clear(&game->rewind); // Save states only rewind within a level
+    if (!take_prefetched_level(game, level_num, level)) {
+        release_level(level);
+        char *path = level_path(level_num);
+        int ok = prepare_level(path, level);
+        SDL_free(path);
+        if (!ok) {
+            SDL_Log("Couldn't load level %d: %s", level_num, SDL_GetError());
+            return 0;
+        }
+    }
+    start_level(game);
+
+    // Get the next level ready while this one is played; after the last level a restart goes back to the first
+    start_prefetch(game, (level_num + 1 < MAX_LEVELS) ? level_num + 1 : 0);
+    return 1;
+}
+
+int game_load_level_file(Game *game, const char *path)
+{
+    Level *level = &game->loaded_level;
+    cancel_prefetch(game);
+    game->level_serial++;
+    save_ring_clear(&game->rewind);
+    release_level(level);
+    if (!prepare_level(path, level)) {
+        return 0;
+    }
+    start_level(game);
+    game->game_over = 0;
+    game->game_won = 0;
+    game->global_timer = game->global_time_limit;
+    reset_actors(game);
+    return 1;
+}
+
+/* Resets the state of the level just loaded, for playing it from the start. */
+static void start_level(Game *game)
+{
+    Level *level = &game->loaded_level;
+
+    // Reset collectibles and the clock moving platforms run on; they are set up from this as their chunks come in
+    game->collected_count = 0;
+    SDL_memset(level->collected, 0, level->total_collectibles);
+    level->bob_seed = rng_next(&game->level_rng);
+    level->start_tick = game->tick;
+    level->active_chunks = (SDL_Rect){-1, -1, 0, 0}; // Nothing gathered yet
+    level->gathered_chunks = level->active_chunks;
+
+    // The level file decides whether the double jump power-up is available and how actors move
+    game->has_double_jump = (level->stream->header.flags & LEVEL_FLAG_DOUBLE_JUMP) != 0;
+    game->integrate_actors = integrate_routine(level->stream->header.physics, game->has_double_jump);
+}
+
+static int SDLCALL prefetch_thread(void *data)
+{
+    LevelPrefetch *job = (LevelPrefetch *)data;
+    char *path = level_path(job->level_num);
+    job->ready = prepare_level(path, &job->level);
+    SDL_free(path);
+    return job->ready;
+}
+
+/* Starts preparing level_num on the loader thread, dropping any earlier prefetch. */
+static void start_prefetch(Game *game, int level_num)
+{
+    cancel_prefetch(game);
+    game->prefetch.level_num = level_num;
+    game->prefetch.ready = 0;
+    game->prefetch.thread = SDL_CreateThread(prefetch_thread, "level prefetch", &game->prefetch);
+    if (!game->prefetch.thread) {
+        // Not fatal, the level will be loaded when it is needed
+        SDL_Log("Couldn't start the level loader: %s", SDL_GetError());
+        game->prefetch.level_num = -1;
+    }
+}
+
+/* Moves the prefetched level into level if it is level_num, waiting for the loader if it is still busy. */
+static int take_prefetched_level(Game *game, int level_num, Level *level)
+{
+    if (game->prefetch.level_num != level_num) {
+        return 0;
+    }
+    SDL_WaitThread(game->prefetch.thread, NULL);
+    game->prefetch.thread = NULL;
+    game->prefetch.level_num = -1;
+    if (!game->prefetch.ready) {
+        return 0;
+    }
+
+    release_level(level);
+    *level = game->prefetch.level;
+    SDL_zero(game->prefetch.level);
+    game->prefetch.ready = 0;
+    return 1;
+}
+
+/* Waits for the loader and throws away whatever it prepared. */
+static void cancel_prefetch(Game *game)
+{
+    if (game->prefetch.thread) {
+        SDL_WaitThread(game->prefetch.thread, NULL);
+        game->prefetch.thread = NULL;
+    }
+    if (game->prefetch.ready) {
+        release_level(&game->prefetch.level);
+        game->prefetch.ready = 0;
+    }
+    game->prefetch.level_num = -1;
+}
+
+/* Streams the chunks around the camera in and makes the entities in them
+   active. Only the chunks the simulation is about to touch are waited for;
+   a chunk's worth around them is read ahead as the camera moves. */
+static void update_chunks(Game *game)
+{
+    Level *level = &game->loaded_level;
+    if (!level->stream) {
+        return;
+    }
+    float ahead = (float)level->stream->header.chunk_size;
+    SDL_FRect view = {game->camera.x, game->camera.y, game->width, game->height};
+    SDL_FRect need = {view.x - ACTIVE_MARGIN, view.y - ACTIVE_MARGIN, view.w + ACTIVE_MARGIN * 2, view.h + ACTIVE_MARGIN * 2};
+    SDL_FRect want = {view.x - ahead, view.y - ahead, view.w + ahead * 2, view.h + ahead * 2};
+    SDL_Rect range = chunk_stream_range(level->stream, need);
+    int ok = chunk_stream_update(level->stream, range, chunk_stream_range(level->stream, want));
+    level->active_area = need;
+    if (SDL_memcmp(&range, &level->active_chunks, sizeof(range)) == 0) {
+        return;
+    }
+
+    // A chunk that couldn't be read stays out until a retry gets it, so gathering again before then changes nothing
+    Uint32 loads = chunk_stream_loads(level->stream);
+    if (SDL_memcmp(&range, &level->gathered_chunks, sizeof(range)) != 0 || loads != level->gathered_loads) {
+        if (!ok) {
+            SDL_Log("Couldn't stream level %d: %s", game->current_level, SDL_GetError());
+        }
+        level->gathered_chunks = range;
+        level->gathered_loads = loads;
+        gather_active(game, range);
+    }
+}
+
+/* Replaces the active entities with those of the chunks in range, restoring
+   the state of the ones coming back. Entities keep file order, so the result
+   only depends on the range. */
+static void gather_active(Game *game, SDL_Rect range)
+{
+    Level *level = &game->loaded_level;
+    arena_reset(&level->active_arena);
+    SDL_zero(level->broadphase);
+    level->active_chunks = (SDL_Rect){-1, -1, 0, 0}; // Until every chunk in range is in, so the next update tries again
+
+    const ChunkSlot *slots[CHUNK_SLOTS];
+    int num_slots = 0;
+    int complete = 1;
+    int counts[LEVEL_ENTITY_TABLES] = { 0 };
+    for (int row = range.y; row < range.y + range.h; row++) {
+        for (int col = range.x; col < range.x + range.w; col++) {
+            const ChunkSlot *slot = chunk_stream_slot(level->stream, col, row);
+            if (!slot || num_slots == CHUNK_SLOTS) {
+                complete = 0;
+                continue;
+            }
+            slots[num_slots++] = slot;
+            for (int t = 0; t < LEVEL_ENTITY_TABLES; t++) {
+                counts[t] += (int)level->stream->chunks[slot->chunk].count[t];
+            }
+        }
+    }
+
+    level->platforms = ARENA_NEW(&level->active_arena, SDL_FRect, counts[LEVEL_TABLE_PLATFORMS]);
+    level->lava_squares = ARENA_NEW(&level->active_arena, SDL_FRect, counts[LEVEL_TABLE_LAVA]);
+    level->collectibles = ARENA_NEW(&level->active_arena, Collectible, counts[LEVEL_TABLE_COLLECTIBLES]);
+    level->moving_platforms = ARENA_NEW(&level->active_arena, MovingPlatform, counts[LEVEL_TABLE_MOVERS]);
+    level->num_platforms = level->num_lava = level->num_collectibles = level->num_moving = 0;
+    if (!level->platforms || !level->lava_squares || !level->collectibles || !level->moving_platforms) {
+        SDL_Log("Couldn't allocate the active level");
+        return;
+    }
+
+    for (int s = 0; s < num_slots; s++) {
+        const LevelChunk *chunk = &level->stream->chunks[slots[s]->chunk];
+        const LevelRect *platforms = (const LevelRect *)slots[s]->tables[LEVEL_TABLE_PLATFORMS];
+        const LevelRect *lava = (const LevelRect *)slots[s]->tables[LEVEL_TABLE_LAVA];
+        const LevelRect *collectibles = (const LevelRect *)slots[s]->tables[LEVEL_TABLE_COLLECTIBLES];
+        const LevelMover *movers = (const LevelMover *)slots[s]->tables[LEVEL_TABLE_MOVERS];
+        for (Uint32 i = 0; i < chunk->count[LEVEL_TABLE_PLATFORMS]; i++) {
+            level->platforms[level->num_platforms++] = level_rect(&platforms[i]);
+        }
+        for (Uint32 i = 0; i < chunk->count[LEVEL_TABLE_LAVA]; i++) {
+            level->lava_squares[level->num_lava++] = level_rect(&lava[i]);
+        }
+        for (Uint32 i = 0; i < chunk->count[LEVEL_TABLE_COLLECTIBLES]; i++) {
+            Collectible *collectible = &level->collectibles[level->num_collectibles++];
+            int id = (int)(chunk->first[LEVEL_TABLE_COLLECTIBLES] + i);
+            collectible->rect = level_rect(&collectibles[i]);
+            collectible->collected = 0;
+            collectible->bob_phase = collectible_phase(level, id);
+            collectible->id = id;
+        }
+        for (Uint32 i = 0; i < chunk->count[LEVEL_TABLE_MOVERS]; i++) {
+            // Where it was as of the last tick; this tick's update moves it on
+            const LevelMover *mover = &movers[i];
+            MovingPlatform *platform = &level->moving_platforms[level->num_moving++];
+            LevelRect bounds = level_mover_bounds(mover);
+            mover_path_init(&platform->path, mover);
+            platform->bounds = level_rect(&bounds);
+            platform->rect.w = mover->w;
+            platform->rect.h = mover->h;
+            platform->ticks = -2;
+            platform->id = (int)(chunk->first[LEVEL_TABLE_MOVERS] + i);
+            place_platform(platform, level_ticks(game) - 1);
+        }
+    }
+    build_level_broadphase(level);
+
+    // Gems already taken come back out of the broadphase
+    for (int i = 0; i < level->num_collectibles; i++) {
+        set_collected(level, i, level->collected[level->collectibles[i].id]);
+    }
+    if (complete) {
+        level->active_chunks = range;
+    }
+}
+
+/* Where a collectible starts in its bob, derived from its id. */
+static float collectible_phase(const Level *level, int id)
+{
+    Rng bob;
+    rng_seed(&bob, level->bob_seed, (Uint64)id);
+    return rng_range(&bob, 0.0f, 6.28f);
+}
+
+/* Marks an active collectible collected or not, taking it out of the broadphase or putting it back. */
+static void set_collected(Level *level, int i, int collected)
+{
+    Collectible *collectible = &level->collectibles[i];
+    if (collectible->collected == collected) {
+        return;
+    }
+    collectible->collected = collected;
+    level->collected[collectible->id] = (Uint8)collected;
+    if (collected) {
+        broadphase_remove(&level->broadphase, ENTITY_HANDLE(ENTITY_COLLECTIBLE, i), collectible->rect);
+    } else {
+        broadphase_restore(&level->broadphase, ENTITY_HANDLE(ENTITY_COLLECTIBLE, i), collectible->rect);
+    }
+}
+
+float game_bob_time(const Game *game)
+{
+    double seconds = (double)level_ticks(game) * TICK_DT;
+    return (float)SDL_fmod(seconds * COLLECTIBLE_BOB_SPEED, 2.0 * SDL_PI_D);
+}
+
+/* Bins the level's static geometry and the live moving platforms into the broadphase. */
+static void build_level_broadphase(Level *level)
+{
+    int num_statics = level->num_platforms + level->num_lava + 1 + level->num_collectibles;
+    int num_moving = level->num_moving;
+    BroadphaseEntry *statics = (BroadphaseEntry *)SDL_malloc(sizeof(BroadphaseEntry) * num_statics);
+    Uint32 *mover_handles = (Uint32 *)SDL_malloc(sizeof(Uint32) * (num_moving + 1));
+    SDL_FRect *mover_rects = (SDL_FRect *)SDL_malloc(sizeof(SDL_FRect) * (num_moving + 1) * 2);
+    if (!statics || !mover_handles || !mover_rects) {
+        SDL_Log("Couldn't allocate broadphase entries");
+        SDL_free(statics);
+        SDL_free(mover_handles);
+        SDL_free(mover_rects);
+        return;
+    }
+    SDL_FRect *mover_bounds = mover_rects + num_moving;
+
+    int n = 0;
+    for (int i = 0; i < level->num_platforms; i++) {
+        statics[n++] = (BroadphaseEntry){ENTITY_HANDLE(ENTITY_PLATFORM, i), level->platforms[i]};
+    }
+    for (int i = 0; i < level->num_lava; i++) {
+        statics[n++] = (BroadphaseEntry){ENTITY_HANDLE(ENTITY_LAVA, i), level->lava_squares[i]};
+    }
+    statics[n++] = (BroadphaseEntry){ENTITY_HANDLE(ENTITY_GOAL, 0), level->goal};
+    for (int i = 0; i < level->num_collectibles; i++) {
+        statics[n++] = (BroadphaseEntry){ENTITY_HANDLE(ENTITY_COLLECTIBLE, i), level->collectibles[i].rect};
+    }
+
+    // Moving platforms are binned by their current rect; their path extents size the grid
+    for (int i = 0; i < num_moving; i++) {
+        const MovingPlatform *platform = &level->moving_platforms[i];
+        mover_handles[i] = ENTITY_HANDLE(ENTITY_MOVING_PLATFORM, i);
+        mover_rects[i] = platform->rect;
+        mover_bounds[i] = platform->bounds;
+    }
+
+    if (!broadphase_build(&level->broadphase, &level->active_arena, statics, n, mover_handles, mover_rects,
+                          mover_bounds, num_moving, BROADPHASE_CELL_SIZE)) {
+        SDL_Log("Couldn't build the level broadphase");
+        SDL_zero(level->broadphase);
+    }
+    SDL_free(statics);
+    SDL_free(mover_handles);
+    SDL_free(mover_rects);
+}
+
+/* Puts the player at the level start and scatters the walkers over the platforms around it. */
+static void reset_actors(Game *game)
+{
+    Level *level = &game->loaded_level;
+    ActorTable *actors = &game->actors;
+    actors->count = 0;
+    game->player_rotation = 0;
+    actor_add(actors, ACTOR_KIND_PLAYER, (SDL_FRect){level->start_pos.x, level->start_pos.y, ACTOR_WIDTH, ACTOR_HEIGHT});
+
+    // Cut straight to the start, centred on the player, rather than scrolling there
+    SDL_FRect player = actor_rect(actors, ACTOR_PLAYER);
+    game->camera = (SDL_FPoint){player.x + player.w / 2 - game->width / 2, player.y + player.h / 2 - game->height / 2};
+    update_camera(game);
+    game->prev_camera = game->camera;
+
+    // Walkers start on the platforms around the player
+    update_chunks(game);
+    for (int i = 0; i < game->num_walkers && level->num_platforms > 0; i++) {
+        const SDL_FRect *platform = &level->platforms[rng_int(&game->ai_rng, level->num_platforms)];
+        float x = platform->x + rng_float(&game->ai_rng) * SDL_max(platform->w - ACTOR_WIDTH, 0.0f);
+        actor_add(actors, ACTOR_KIND_WALKER, (SDL_FRect){x, platform->y - ACTOR_HEIGHT, ACTOR_WIDTH, ACTOR_HEIGHT});
+    }
+}
+
+/* Picks the buttons for walkers: keep going until blocked, then turn around,
+   and hop now and then, holding jump until the hop peaks. */
+static void think_walkers(Game *game, int begin, int end)
+{
+    ActorTable *actors = &game->actors;
+    for (int i = begin; i < end; i++) {
+        if (actors->kind[i] != ACTOR_KIND_WALKER || !actor_awake(game, i)) {
+            continue;
+        }
+        Uint32 previous = actors->buttons[i];
+        Uint32 buttons = previous & (GAME_INPUT_LEFT | GAME_INPUT_RIGHT);
+        if (!buttons) {
+            buttons = rng_int(&game->ai_rng, 2) ? GAME_INPUT_LEFT : GAME_INPUT_RIGHT;
+        } else if (actors->events[i] & ACTOR_EVENT_BLOCKED) {
+            buttons ^= GAME_INPUT_LEFT | GAME_INPUT_RIGHT;
+        }
+
+        if (actors->on_ground[i] && rng_int(&game->ai_rng, WALKER_HOP_CHANCE) == 0) {
+            buttons |= GAME_INPUT_JUMP | GAME_INPUT_JUMP_PRESSED;
+        } else if ((previous & GAME_INPUT_JUMP) && actors->vy[i] < 0) {
+            buttons |= GAME_INPUT_JUMP;
+        }
+        actors->buttons[i] = buttons;
+    }
+}
+
+/* Turns each actor's buttons into the move it wants this tick - walking,
+   jumping and gravity. Only arithmetic on the actor arrays; collision and
+   effects come after, over the same range. Only called with constants, from
+   the routines below, so each gets its own copy with them folded in. */
+SDL_FORCE_INLINE void integrate_actors(Game *game, int begin, int end, float gravity, float jump_strength,
+                                       float move_speed, float max_fall_speed, int coyote_time,
+                                       int jump_buffer_time, int double_jump)
+{
+    ActorTable *actors = &game->actors;
+    for (int i = begin; i < end; i++) {
+        if (!actor_awake(game, i)) {
+            continue;
+        }
+        Uint32 buttons = actors->buttons[i];
+        int left = (buttons & GAME_INPUT_LEFT) != 0;
+        int right = (buttons & GAME_INPUT_RIGHT) != 0;
+        Uint32 events = 0;
+        if (buttons & GAME_INPUT_JUMP_PRESSED) {
+            actors->jump_buffer[i] = jump_buffer_time;
+        }
+
+        // Walking animation
+        actors->walking[i] = (left || right) && actors->on_ground[i];
+        actors->walk_timer[i] = actors->walking[i] ? actors->walk_timer[i] + 1 : 0;
+        if (actors->walking[i]) {
+            events |= ACTOR_EVENT_STEP;
+        }
+
+        // Horizontal movement, kept inside the level
+        float x = actors->x[i] + (right - left) * move_speed * TICK_DT;
+        float level_width = game->loaded_level.width;
+        if (x < 0) x = 0;
+        if (x + actors->w[i] > level_width) x = level_width - actors->w[i];
+        if ((left || right) && x == actors->x[i]) {
+            events |= ACTOR_EVENT_BLOCKED;
+        }
+        actors->move_x[i] = x - actors->x[i];
+
+        // Coyote time
+        if (actors->on_ground[i]) {
+            actors->coyote_timer[i] = coyote_time;
+        } else if (actors->coyote_timer[i] > 0) {
+            actors->coyote_timer[i]--;
+        }
+
+        // Jump buffering
+        float vy = actors->vy[i];
+        if (actors->jump_buffer[i] > 0) {
+            actors->jump_buffer[i]--;
+            if (actors->coyote_timer[i] > 0 || (double_jump && !actors->double_jump_used[i])) {
+                if (actors->coyote_timer[i] > 0) {
+                    vy = jump_strength;
+                    actors->coyote_timer[i] = 0;
+                } else {
+                    vy = jump_strength * 0.8f; // Double jump is slightly weaker
+                    actors->double_jump_used[i] = 1;
+                }
+                actors->jump_buffer[i] = 0;
+                events |= ACTOR_EVENT_JUMP;
+            }
+        }
+
+        // Variable jump height
+        if (!(buttons & GAME_INPUT_JUMP) && vy < -120.0f) {
+            vy *= 0.5f; // Cut jump short
+        }
+
+        // Gravity
+        vy += gravity * TICK_DT;
+        if (vy > max_fall_speed) vy = max_fall_speed;
+        actors->vy[i] = vy;
+        actors->move_y[i] = vy * TICK_DT;
+
+        if (actors->invincibility_timer[i] > 0) {
+            actors->invincibility_timer[i]--;
+        }
+        actors->events[i] = events;
+    }
+}
+
+// Movement routines, one per physics profile with and without the double jump; run as jobs
+#define INTEGRATE_ROUTINES(id, name, gravity, jump_strength, move_speed, max_fall_speed, coyote_time, jump_buffer_time) \
+    static void integrate_##name(void *data, int begin, int end) \
+    { \
+        integrate_actors((Game *)data, begin, end, gravity, jump_strength, move_speed, max_fall_speed, coyote_time, \
+                         jump_buffer_time, 0); \
+    } \
+    static void integrate_##name##_double_jump(void *data, int begin, int end) \
+    { \
+        integrate_actors((Game *)data, begin, end, gravity, jump_strength, move_speed, max_fall_speed, coyote_time, \
+                         jump_buffer_time, 1); \
+    }
+PHYSICS_PROFILES(INTEGRATE_ROUTINES)
+#undef INTEGRATE_ROUTINES
+
+// By profile, then whether the level has the double jump
+static const JobFunc integrate_routines[PHYSICS_PROFILE_COUNT][2] = {
+#define INTEGRATE_ROUTINE_ENTRY(id, name, ...) [PHYSICS_##id] = { integrate_##name, integrate_##name##_double_jump },
+    PHYSICS_PROFILES(INTEGRATE_ROUTINE_ENTRY)
+#undef INTEGRATE_ROUTINE_ENTRY
+};
+
+/* The movement routine for a level played with profile. */
+static JobFunc integrate_routine(Uint32 profile, int double_jump)
+{
+    return integrate_routines[profile][double_jump != 0];
+}
+
+/* Sweeps each actor's move against the platforms, horizontal first, and
+   lands it on whatever it hits first on the way down. Runs as a job: actors
+   only read the level and write their own slots. */
+static void collide_actors(void *data, int begin, int end)
+{
+    Game *game = (Game *)data;
+    ActorTable *actors = &game->actors;
+    Level *level = &game->loaded_level;
+    for (int i = begin; i < end; i++) {
+        if (!actor_awake(game, i)) {
+            continue;
+        }
+        SDL_FRect box = actor_rect(actors, i);
+        Uint32 handle;
+        CollisionHit hit;
+
+        // Horizontal collision with static and moving platforms - stop at the first contact
+        float dx = actors->move_x[i];
+        if (dx != 0 && sweep_solids(game, box, dx, 0, &handle, &hit)) {
+            dx *= hit.time;
+            actors->events[i] |= ACTOR_EVENT_BLOCKED;
+        }
+        box.x += dx;
+
+        // Vertical collision - the earliest contact along the fall or jump wins
+        actors->on_ground[i] = 0;
+        if (sweep_solids(game, box, 0, actors->move_y[i], &handle, &hit)) {
+            SDL_FRect surface = solid_rect(level, handle);
+            actors->vy[i] = 0;
+            if (hit.normal_y < 0) {
+                box.y = surface.y - box.h;
+                actors->on_ground[i] = 1;
+                actors->double_jump_used[i] = 0;
+                if (ENTITY_TYPE(handle) == ENTITY_MOVING_PLATFORM) {
+                    // Move with the platform, as far as it goes this tick
+                    const MovingPlatform *platform = &level->moving_platforms[ENTITY_INDEX(handle)];
+                    box.x += platform_position(platform, level_ticks(game)).x - platform->rect.x;
+                } else {
+                    actors->events[i] |= ACTOR_EVENT_LAND;
+                }
+            } else {
+                box.y = surface.y + surface.h;
+            }
+        } else {
+            box.y += actors->move_y[i];
+        }
+
+        actors->x[i] = box.x;
+        actors->y[i] = box.y;
+    }
+}
+
+/* Dust, jump and landing particles for what happened to an actor this tick. */
+static void emit_actor_effects(Game *game, int i)
+{
+    const ActorTable *actors = &game->actors;
+    Uint32 events = actors->events[i];
+    float x = actors->x[i], y = actors->y[i], w = actors->w[i], h = actors->h[i];
+    if (events & ACTOR_EVENT_STEP) {
+        int due = particle_emitter_step(&game->dust_emitter, TICK_DT, game->particle_detail);
+        emit_burst(game, due, x + w/2, y + h, 0, -60.0f, 60.0f, -60.0f, -60.0f, 139, 69, 19, 0.5f);
+    }
+    if (events & ACTOR_EVENT_JUMP) {
+        emit_burst(game, burst_size(game, 8), x + w/2, y + h, 0, -120.0f, 120.0f, 30.0f, 90.0f, 200, 200, 255, 0.65f);
+    }
+    if (events & ACTOR_EVENT_LAND) {
+        emit_burst(game, burst_size(game, 5), x, y + h, w, -120.0f, 120.0f, -120.0f, -120.0f, 139, 69, 19, 0.4f);
+    }
+}
+
+/* Whether an actor is simulated this tick. Walkers wholly inside the active
+   area are; the rest wait where they are until the camera comes back, since
+   the level around them may not be loaded. */
+static int actor_awake(const Game *game, int i)
+{
+    if (i == ACTOR_PLAYER) {
+        return 1;
+    }
+    const SDL_FRect *area = &game->loaded_level.active_area;
+    const ActorTable *actors = &game->actors;
+    return actors->x[i] >= area->x && actors->y[i] >= area->y &&
+           actors->x[i] + actors->w[i] <= area->x + area->w && actors->y[i] + actors->h[i] <= area->y + area->h;
+}
+
+/* Area an actor covered over the last tick, so triggers can't be skipped. */
+static SDL_FRect actor_path(const ActorTable *actors, int i)
+{
+    SDL_FRect path, from = actor_prev_rect(actors, i), to = actor_rect(actors, i);
+    SDL_GetRectUnionFloat(&from, &to, &path);
+    return path;
+}
+
+static void update_collectibles(Game *game)
+{
+    Level *level = &game->loaded_level;
+
+    // Only collectibles the broadphase finds under the player can be picked up,
+    // and collected ones aren't in it, so every hit is a gem still to take
+    int num_hits = query_world(game, actor_rect(&game->actors, ACTOR_PLAYER));
+    for (int hit = 0; hit < num_hits; hit++) {
+        if (ENTITY_TYPE(game->query_results[hit]) != ENTITY_COLLECTIBLE) {
+            continue;
+        }
+        int i = ENTITY_INDEX(game->query_results[hit]);
+        set_collected(level, i, 1);
+        game->collected_count++;
+        game->score += 100;
+
+        // Collection particles
+        emit_burst(game, burst_size(game, 10), level->collectibles[i].rect.x + level->collectibles[i].rect.w/2,
+                   level->collectibles[i].rect.y + level->collectibles[i].rect.h/2, 0,
+                   -120.0f, 120.0f, -120.0f, 120.0f, 255, 255, 0, 0.85f);
+    }
+}
+
+/* Ticks since the level was loaded, the clock moving platforms follow. */
+static Sint64 level_ticks(const Game *game)
+{
+    return (Sint64)(game->tick - game->loaded_level.start_tick);
+}
+
+static SDL_FPoint platform_position(const MovingPlatform *platform, Sint64 ticks)
+{
+    return mover_path_at(&platform->path, (double)SDL_max(ticks, 0) / TICK_RATE);
+}
+
+/* Puts a platform where its path has it after ticks, and where it was a tick
+   earlier for interpolation, which is the rect it had unless it was skipped. */
+static void place_platform(MovingPlatform *platform, Sint64 ticks)
+{
+    if (platform->ticks == ticks) {
+        return;
+    }
+    SDL_FPoint prev = platform->ticks == ticks - 1 ? (SDL_FPoint){platform->rect.x, platform->rect.y}
+                                                   : platform_position(platform, ticks - 1);
+    SDL_FPoint position = platform_position(platform, ticks);
+    platform->prev_rect = (SDL_FRect){prev.x, prev.y, platform->rect.w, platform->rect.h};
+    platform->rect.x = position.x;
+    platform->rect.y = position.y;
+    platform->ticks = ticks;
+}
+
+/* Places the platforms that can reach the active area, the only ones anything
+   awake can touch or the view can show. The rest are placed again from their
+   path whenever they come back into it, so skipping them loses nothing. */
+static void update_moving_platforms(Game *game)
+{
+    Level *level = &game->loaded_level;
+    Sint64 ticks = level_ticks(game);
+    for (int i = 0; i < level->num_moving; i++) {
+        MovingPlatform *platform = &level->moving_platforms[i];
+        if (!SDL_HasRectIntersectionFloat(&platform->bounds, &level->active_area)) {
+            continue;
+        }
+        place_platform(platform, ticks);
+        broadphase_move(&level->broadphase, i, platform->rect);
+    }
+}
+
+/* Fills query_results with everything in the loaded level that overlaps box. */
+static int query_world(Game *game, SDL_FRect box)
+{
+    return broadphase_query(&game->loaded_level.broadphase, box, game->query_results, MAX_QUERY_RESULTS);
+}
+
+static int first_overlap(Game *game, SDL_FRect box, EntityType type)
+{
+    int num_hits = query_world(game, box);
+    int best = -1;
+    for (int i = 0; i < num_hits; i++) {
+        if (ENTITY_TYPE(game->query_results[i]) == type) {
+            int index = ENTITY_INDEX(game->query_results[i]);
+            if (best < 0 || index < best) {
+                best = index;
+            }
+        }
+    }
+    return best;
+}
+
+/* Earliest contact of box moving by (dx, dy) with a static or moving platform.
+   Ties go to the lowest handle so the result doesn't depend on query order.
+   Queries into its own buffer, so jobs can call it concurrently. */
+static int sweep_solids(Game *game, SDL_FRect box, float dx, float dy, Uint32 *handle, CollisionHit *hit)
+{
+    Level *level = &game->loaded_level;
+    Uint32 results[MAX_QUERY_RESULTS];
+    int num_hits = broadphase_query(&level->broadphase, collision_swept_bounds(box, dx, dy), results, MAX_QUERY_RESULTS);
+    int found = 0;
+    for (int i = 0; i < num_hits; i++) {
+        Uint32 candidate = results[i];
+        EntityType type = ENTITY_TYPE(candidate);
+        if (type != ENTITY_PLATFORM && type != ENTITY_MOVING_PLATFORM) {
+            continue;
+        }
+        CollisionHit contact;
+        if (!collision_sweep(box, dx, dy, solid_rect(level, candidate), &contact)) {
+            continue;
+        }
+        if (!found || contact.time < hit->time || (contact.time == hit->time && candidate < *handle)) {
+            *hit = contact;
+            *handle = candidate;
+            found = 1;
+        }
+    }
+    return found;
+}
+
+static SDL_FRect solid_rect(const Level *level, Uint32 handle)
+{
+    int index = ENTITY_INDEX(handle);
+    if (ENTITY_TYPE(handle) == ENTITY_MOVING_PLATFORM) {
+        return level->moving_platforms[index].rect;
+    }
+    return level->platforms[index];
+}
+
+/* Scrolls just enough to keep the player in the middle third of the view,
+   without showing anything past the level edges. */
+static void update_camera(Game *game)
+{
+    const Level *level = &game->loaded_level;
+    SDL_FRect player = actor_rect(&game->actors, ACTOR_PLAYER);
+    float center_x = player.x + player.w / 2, center_y = player.y + player.h / 2;
+    SDL_FPoint *camera = &game->camera;
+    camera->x = SDL_clamp(camera->x, center_x - game->width * 2 / 3, center_x - game->width / 3);
+    camera->y = SDL_clamp(camera->y, center_y - game->height * 2 / 3, center_y - game->height / 3);
+    camera->x = SDL_clamp(camera->x, 0.0f, SDL_max(level->width - game->width, 0.0f));
+    camera->y = SDL_clamp(camera->y, 0.0f, SDL_max(level->height - game->height, 0.0f));
+}
+
+/* The arrays a save state holds, sized for the given actor and particle counts. */
+static int state_arrays(Game *game, int num_actors, int num_particles, StateArray *arrays)
+{
+    ActorTable *a = &game->actors;
+    ParticlePool *p = &game->particles;
+    size_t actors = (size_t)num_actors, particles = (size_t)num_particles;
+    const StateArray list[] = {
+        {a->x, sizeof(float) * actors}, {a->y, sizeof(float) * actors},
+        {a->w, sizeof(float) * actors}, {a->h, sizeof(float) * actors},
+        {a->prev_x, sizeof(float) * actors}, {a->prev_y, sizeof(float) * actors},
+        {a->vy, sizeof(float) * actors},
+        {a->move_x, sizeof(float) * actors}, {a->move_y, sizeof(float) * actors},
+        {a->spawn_x, sizeof(float) * actors}, {a->spawn_y, sizeof(float) * actors},
+        {a->buttons, sizeof(Uint32) * actors}, {a->events, sizeof(Uint32) * actors},
+        {a->coyote_timer, sizeof(Sint32) * actors}, {a->jump_buffer, sizeof(Sint32) * actors},
+        {a->invincibility_timer, sizeof(Sint32) * actors}, {a->walk_timer, sizeof(Sint32) * actors},
+        {a->kind, actors}, {a->on_ground, actors}, {a->double_jump_used, actors}, {a->walking, actors},
+        {p->x, sizeof(float) * particles}, {p->y, sizeof(float) * particles},
+        {p->vx, sizeof(float) * particles}, {p->vy, sizeof(float) * particles},
+        {p->life, sizeof(float) * particles}, {p->max_life, sizeof(float) * particles},
+        {p->color, sizeof(Uint32) * particles},
+        {game->loaded_level.collected, (size_t)game->loaded_level.total_collectibles},
+    };
+    SDL_COMPILE_TIME_ASSERT(state_arrays_fit, SDL_arraysize(list) <= MAX_STATE_ARRAYS);
+    SDL_memcpy(arrays, list, sizeof(list));
+    return (int)SDL_arraysize(list);
+}
+
+size_t game_state_size(const Game *game)
+{
+    StateArray arrays[MAX_STATE_ARRAYS];
+    int num_arrays = state_arrays((Game *)game, game->actors.count, game->particles.count, arrays);
+    size_t size = sizeof(SaveStateHeader);
+    for (int i = 0; i < num_arrays; i++) {
+        size += arrays[i].size;
+    }
+    return size;
+}
+
+void game_save_state(const Game *game, void *state)
+{
+    SaveStateHeader header = {
+        level_ticks(game), game->effects_rng, game->level_rng, game->ai_rng, game->camera, game->prev_camera,
+        game->game_over, game->game_won, game->score, game->lives, game->global_timer, game->player_rotation,
+        game->has_double_jump, game->collected_count, game->lava_emitter, game->dust_emitter, game->actors.count,
+        game->particles.count, game->particles.limit, game->particles.recycle
+    };
+    Uint8 *out = (Uint8 *)state;
+    SDL_memcpy(out, &header, sizeof(header));
+    out += sizeof(header);
+
+    StateArray arrays[MAX_STATE_ARRAYS];
+    int num_arrays = state_arrays((Game *)game, game->actors.count, game->particles.count, arrays);
+    for (int i = 0; i < num_arrays; i++) {
+        SDL_memcpy(out, arrays[i].data, arrays[i].size);
+        out += arrays[i].size;
+    }
+}
+
+void game_load_state(Game *game, const void *state)
+{
+    const Uint8 *in = (const Uint8 *)state;
+    SaveStateHeader header;
+    SDL_memcpy(&header, in, sizeof(header));
+    in += sizeof(header);
+
+    Level *level = &game->loaded_level;
+    level->start_tick = game->tick - (Uint64)header.level_ticks;
+    game->effects_rng = header.effects_rng;
+    game->level_rng = header.level_rng;
+    game->ai_rng = header.ai_rng;
+    game->camera = header.camera;
+    game->prev_camera = header.prev_camera;
+    game->game_over = header.game_over;
+    game->game_won = header.game_won;
+    game->score = header.score;
+    game->lives = header.lives;
+    game->global_timer = header.global_timer;
+    game->player_rotation = header.player_rotation;
+    game->has_double_jump = header.has_double_jump;
+    game->collected_count = header.collected_count;
+    game->lava_emitter = header.lava_emitter;
+    game->dust_emitter = header.dust_emitter;
+    game->actors.count = header.num_actors;
+    game->particles.count = header.num_particles;
+    game->particles.limit = header.particle_limit;
+    game->particles.recycle = header.particle_recycle;
+
+    StateArray arrays[MAX_STATE_ARRAYS];
+    int num_arrays = state_arrays(game, header.num_actors, header.num_particles, arrays);
+    for (int i = 0; i < num_arrays; i++) {
+        SDL_memcpy(arrays[i].data, in, arrays[i].size);
+        in += arrays[i].size;
+    }
+
+    // Bring the active set in line: regathered if the camera moved to other chunks, otherwise
+    // the collectibles follow the restored flags and the platforms the restored level clock
+    update_chunks(game);
+    for (int i = 0; i < level->num_collectibles; i++) {
+        set_collected(level, i, level->collected[level->collectibles[i].id]);
+    }
+    update_moving_platforms(game);
+}
+
+/* Pushes the state of the simulation onto the rewind ring. */
+static void save_state(Game *game)
+{
+    void *state = save_ring_push(&game->rewind, game_state_size(game));
+    if (state) {
+        game_save_state(game, state);
+    }
+}
+
+/* Restores the newest save state, dropping it unless it is the last one left
+   so holding rewind walks back to the oldest and stays there. Returns 0 if
+   there is nothing to rewind to. */
+static int rewind_state(Game *game)
+{
+    const void *state = save_ring_newest(&game->rewind, NULL);
+    if (!state) {
+        return 0;
+    }
+    game_load_state(game, state);
+    if (game->rewind.count > 1) {
+        save_ring_pop(&game->rewind);
+    }
+    return 1;
+}
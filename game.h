@@ -0,0 +1,207 @@
+/*
+  Game simulation.
+
+  Everything the game needs to play - the loaded level, the player, the
+  particles and the session state - lives in a Game and is advanced one
+  fixed tick at a time from a GameInput. Nothing in here talks to a window
+  or renderer, so the same simulation runs in the game and headless.
+*/
+#ifndef GAME_H
+#define GAME_H
+
+#include <SDL3/SDL.h>
+
+#include "actors.h"
+#include "arena.h"
+#include "broadphase.h"
+#include "chunks.h"
+#include "jobs.h"
+#include "level_file.h"
+#include "particles.h"
+#include "paths.h"
+#include "profiler.h"
+#include "rng.h"
+#include "savestate.h"
+
+#define MAX_LEVELS 6
+#define GAME_MIN_PARTICLE_DETAIL 0.1f
+
+// Simulation rate - physics runs in fixed ticks, independent of the display
+#define TICK_RATE 120
+static const Uint64 TICK_TIME_NS = SDL_NS_PER_SECOND / TICK_RATE;
+static const float TICK_DT = 1.0f / TICK_RATE;
+
+// Pull on particles, per second; shared with renderers that simulate them
+static const float PARTICLE_GRAVITY = 360.0f;
+
+// Buttons held (or pressed) for a tick
+#define GAME_INPUT_LEFT 0x01
+#define GAME_INPUT_RIGHT 0x02
+#define GAME_INPUT_JUMP 0x04 // Held
+#define GAME_INPUT_JUMP_PRESSED 0x08 // Pressed since the previous tick
+#define GAME_INPUT_RESTART 0x10 // Start over once the game is over or won
+#define GAME_INPUT_NEXT_LEVEL 0x20 // Move on once the level is won
+#define GAME_INPUT_REWIND 0x40 // Held: step back through the level's recent save states instead of ticking
+
+// Rewind history - a save state every GAME_SAVE_INTERVAL ticks, kept in a
+// ring of GAME_REWIND_BYTES
+#define GAME_SAVE_INTERVAL (TICK_RATE / 20)
+#define GAME_REWIND_BYTES (32 * 1024 * 1024)
+
+typedef struct {
+    Uint32 buttons;
+} GameInput;
+
+// Collectibles - only uncollected ones are in the level broadphase, so picking
+// up and drawing never look at the rest. They all bob on the level clock
+#define COLLECTIBLE_BOB_SPEED 6.0f // radians per second
+#define COLLECTIBLE_BOB_HEIGHT 5.0f
+
+typedef struct {
+    SDL_FRect rect;
+    int collected; // Taken out of the broadphase
+    float bob_phase; // Its own start in the bob, added to game_bob_time()
+    int id; // Index in the level file, for state that outlives the chunk
+} Collectible;
+
+// Moving platforms - placed from their path, never integrated
+typedef struct {
+    SDL_FRect rect;
+    SDL_FRect prev_rect; // Position at the start of the last tick, for interpolation
+    Sint64 ticks; // Level tick rect is the position for
+    SDL_FRect bounds; // Covered over the whole path
+    MoverPath path;
+    int id; // Index in the level file
+} MovingPlatform;
+
+// Level data - only the loaded level exists. The level is streamed in chunks
+// around the camera; the entities in the chunks currently in range are the
+// active ones, gathered into their own arena whenever the range changes. The
+// little state that has to survive a chunk being dropped is kept per entity
+// for the whole level
+typedef struct {
+    float width, height; // World bounds, the size the level was authored at
+    SDL_FRect *platforms;
+    int num_platforms;
+    SDL_FRect *lava_squares;
+    int num_lava;
+    SDL_FRect start_pos;
+    SDL_FRect goal;
+    Collectible *collectibles; // Active ones, collected or not
+    int num_collectibles;
+    int total_collectibles; // In the whole level, for the goal
+    MovingPlatform *moving_platforms; // Active ones, only placed while they overlap the active area
+    int num_moving;
+    Broadphase broadphase; // Over the active entities
+    SDL_Rect active_chunks; // Chunk range the active entities were gathered from, once all of it was in
+    SDL_Rect gathered_chunks; // Range of the last gather, complete or not
+    Uint32 gathered_loads; // The stream's load count at the last gather; an incomplete one is only retried once it moves
+    SDL_FRect active_area; // Everything overlapping this is active; walkers outside it wait
+
+    Uint8 *collected; // Per collectible in the level file
+    Uint32 bob_seed; // Collectible bob phases derive from this and the collectible's id
+    Uint64 start_tick; // Tick the level was loaded on; moving platforms are placed by the time since
+    ChunkStream *stream; // In the arena, so it stays put when the level is moved
+    Arena arena; // Lives as long as the level
+    Arena active_arena; // Reset on every gather
+} Level;
+
+// Background loader - the level after the current one is prepared on a thread
+// while the current one is played, so moving on is just a swap
+typedef struct {
+    SDL_Thread *thread;
+    int level_num; // Level being prepared, -1 when idle
+    int ready; // Set by the thread once level is fully built
+    Level level;
+} LevelPrefetch;
+
+#define MAX_QUERY_RESULTS 256
+
+typedef struct {
+    Uint64 tick; // Ticks simulated since startup
+    Uint64 seed; // Everything random derives from this
+    Rng effects_rng; // Particle emitters
+    Rng level_rng; // Per-level setup such as collectible bob phases
+    Rng ai_rng; // Walker spawns and decisions
+    float width, height; // View size; the camera scrolls over levels larger than this
+    SDL_FPoint camera, prev_camera; // Top-left of the view in the world, before and after the last tick
+
+    // Session state
+    int game_over;
+    int game_won;
+    int current_level;
+    int score;
+    int lives;
+
+    // Timer system - Global timer for all levels
+    float global_timer;
+    float global_time_limit;
+
+    // The player is actor 0; walkers follow it
+    ActorTable actors;
+    int num_walkers; // Walkers spawned on each level
+    float player_rotation;
+    int has_double_jump;
+    JobFunc integrate_actors; // Movement for the level's physics profile and double jump, picked when it starts
+
+    int collected_count;
+    ParticlePool particles;
+    float particle_detail; // 1 is full; lower scales emission, lifetimes and the live cap down
+    ParticleEmitter lava_emitter; // Per lava square
+    ParticleEmitter dust_emitter; // Under the player while walking
+    int external_particles; // Set after game_init by a renderer that simulates particles itself
+    ParticleQueue particle_spawns; // With external_particles, what was emitted since the renderer took it
+    Level loaded_level;
+    Uint32 level_serial; // Bumped whenever a level is loaded, so renderers know when cached level art is stale
+    LevelPrefetch prefetch;
+    SaveRing rewind; // Save states of the current level, oldest first; empty if it couldn't be allocated
+
+    Uint32 query_results[MAX_QUERY_RESULTS]; // For queries made on the simulation thread
+    Profiler *profiler; // Simulation phases are timed into this
+    JobSystem *jobs; // Runs the parallel phases; set after game_init, NULL runs them serially
+} Game;
+
+// Starts a session on the first level with num_walkers AI walkers besides the
+// player; the same seed and inputs give the same run. Returns 0 if the
+// particle pool or actor table couldn't be allocated or the first level
+// couldn't be loaded.
+int game_init(Game *game, float width, float height, int particle_capacity, int num_walkers, Uint64 seed,
+              Profiler *profiler);
+void game_free(Game *game);
+
+// Advances the simulation by one fixed tick of TICK_DT seconds.
+void game_tick(Game *game, const GameInput *input);
+
+// Starts over from the first level once the game is over or won.
+void game_restart(Game *game);
+
+// Moves on to the next level once the current one is won; returns 0 if there is none.
+int game_next_level(Game *game);
+
+// Loads the level file at path in place of the current level, for tools that
+// check levels outside the game's own sequence. The session carries on as if
+// the level had just been started; game_next_level goes back to the built-in
+// levels. Returns 0 with the SDL error set if the file couldn't be loaded.
+int game_load_level_file(Game *game, const char *path);
+
+// Save states of the current level. A state holds everything the next ticks
+// depend on for the level that is loaded; moving platforms and collectible
+// bobbing follow from the level clock, and the active set from the camera, so
+// none of those are stored. game_state_size is the size game_save_state writes
+// for the game as it is now; game_load_state takes back any state saved on the
+// same level by a game with the same particle capacity.
+size_t game_state_size(const Game *game);
+void game_save_state(const Game *game, void *state);
+void game_load_state(Game *game, const void *state);
+
+// Sets the particle detail level, clamped to [GAME_MIN_PARTICLE_DETAIL, 1]. Particles are
+// part of the simulation state, so runs only match if they use the same detail.
+void game_set_particle_detail(Game *game, float detail);
+
+// Bob angle shared by every collectible as of the last tick, wrapped to a full turn.
+float game_bob_time(const Game *game);
+
+// Hash of the simulation state, for checking that two runs match.
+Uint32 game_checksum(const Game *game);
+
+#endif /* GAME_H */
@@ -0,0 +1,288 @@
+/*
+  GPU particle backend.
+*/
+#include "gpu_particles.h"
+
+// Uniform blocks, laid out as the shaders declare them
+typedef struct {
+    float dt;
+    float gravity;
+    Uint32 count;
+    Uint32 steps;
+} StepUniforms;
+
+typedef struct {
+    float camera_x, camera_y;
+    float target_w, target_h;
+} ViewUniforms;
+
+static void *load_shader_code(const char *name, size_t *size);
+static SDL_GPUShader *load_shader(SDL_GPUDevice *device, const char *name, SDL_GPUShaderStage stage,
+                                  Uint32 num_storage_buffers, Uint32 num_uniform_buffers);
+static int create_pipelines(GpuParticles *particles);
+static int size_target(GpuParticles *particles, SDL_Renderer *renderer);
+static void upload_spawns(GpuParticles *particles, SDL_GPUCommandBuffer *commands,
+                          const ParticleSpawn *spawns, int num_spawns);
+
+int gpu_particles_init(GpuParticles *particles, SDL_Renderer *renderer, int capacity)
+{
+    SDL_zerop(particles);
+    particles->device = (SDL_GPUDevice *)SDL_GetPointerProperty(SDL_GetRendererProperties(renderer),
+                                                                SDL_PROP_RENDERER_GPU_DEVICE_POINTER, NULL);
+    if (!particles->device) {
+        return SDL_SetError("GPU particles need the gpu render driver");
+    }
+    if (!(SDL_GetGPUShaderFormats(particles->device) & SDL_GPU_SHADERFORMAT_SPIRV)) {
+        particles->device = NULL;
+        return SDL_SetError("GPU particles need a GPU driver that takes SPIR-V");
+    }
+
+    particles->capacity = (Uint32)SDL_max(capacity, 1);
+    SDL_GPUBufferCreateInfo buffer_info;
+    SDL_zero(buffer_info);
+    buffer_info.usage = SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_READ | SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_WRITE |
+                        SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ;
+    buffer_info.size = (Uint32)sizeof(ParticleSpawn) * particles->capacity;
+    particles->particles = SDL_CreateGPUBuffer(particles->device, &buffer_info);
+    if (!particles->particles || !create_pipelines(particles)) {
+        gpu_particles_free(particles);
+        return 0;
+    }
+    return 1;
+}
+
+void gpu_particles_free(GpuParticles *particles)
+{
+    SDL_GPUDevice *device = particles->device;
+    if (device) {
+        if (particles->integrate) SDL_ReleaseGPUComputePipeline(device, particles->integrate);
+        if (particles->draw) SDL_ReleaseGPUGraphicsPipeline(device, particles->draw);
+        if (particles->particles) SDL_ReleaseGPUBuffer(device, particles->particles);
+        if (particles->upload) SDL_ReleaseGPUTransferBuffer(device, particles->upload);
+    }
+    if (particles->target) {
+        SDL_DestroyTexture(particles->target);
+    }
+    SDL_zerop(particles);
+}
+
+int gpu_particles_render(GpuParticles *particles, SDL_Renderer *renderer, const ParticleSpawn *spawns, int num_spawns,
+                         int steps, float gravity, SDL_FPoint camera)
+{
+    if (!size_target(particles, renderer)) {
+        return 0;
+    }
+    SDL_GPUTexture *target = (SDL_GPUTexture *)SDL_GetPointerProperty(SDL_GetTextureProperties(particles->target),
+                                                                      SDL_PROP_TEXTURE_GPU_TEXTURE_POINTER, NULL);
+    SDL_GPUCommandBuffer *commands = SDL_AcquireGPUCommandBuffer(particles->device);
+    if (!target || !commands) {
+        return 0;
+    }
+
+    StepUniforms step = {TICK_DT, gravity, particles->used, (Uint32)SDL_clamp(steps, 0, GPU_PARTICLE_MAX_STEPS)};
+    if (step.steps > 0 && particles->used > 0) {
+        SDL_GPUStorageBufferReadWriteBinding binding;
+        SDL_zero(binding);
+        binding.buffer = particles->particles;
+        SDL_GPUComputePass *pass = SDL_BeginGPUComputePass(commands, NULL, 0, &binding, 1);
+        SDL_BindGPUComputePipeline(pass, particles->integrate);
+        SDL_PushGPUComputeUniformData(commands, 0, &step, sizeof(step));
+        SDL_DispatchGPUCompute(pass, (particles->used + GPU_PARTICLE_THREADS - 1) / GPU_PARTICLE_THREADS, 1, 1);
+        SDL_EndGPUComputePass(pass);
+    }
+
+    // After the step, since spawns come already moved on by the ticks they have lived
+    upload_spawns(particles, commands, spawns, num_spawns);
+
+    SDL_GPUColorTargetInfo color_target;
+    SDL_zero(color_target);
+    color_target.texture = target;
+    color_target.clear_color = (SDL_FColor){0, 0, 0, 0};
+    color_target.load_op = SDL_GPU_LOADOP_CLEAR;
+    color_target.store_op = SDL_GPU_STOREOP_STORE;
+    SDL_GPURenderPass *pass = SDL_BeginGPURenderPass(commands, &color_target, 1, NULL);
+    if (particles->used > 0) {
+        ViewUniforms view = {camera.x, camera.y, (float)particles->target_w, (float)particles->target_h};
+        SDL_BindGPUGraphicsPipeline(pass, particles->draw);
+        SDL_BindGPUVertexStorageBuffers(pass, 0, &particles->particles, 1);
+        SDL_PushGPUVertexUniformData(commands, 0, &view, sizeof(view));
+        SDL_DrawGPUPrimitives(pass, 4, particles->used, 0, 0);
+    }
+    SDL_EndGPURenderPass(pass);
+
+    // Submitted ahead of the renderer's own work for the frame, which samples the target
+    return SDL_SubmitGPUCommandBuffer(commands);
+}
+
+static void *load_shader_code(const char *name, size_t *size)
+{
+    char *path = NULL;
+    if (SDL_asprintf(&path, "%sshaders/%s.spv", SDL_GetBasePath(), name) < 0) {
+        return NULL;
+    }
+    void *code = SDL_LoadFile(path, size);
+    SDL_free(path);
+    return code;
+}
+
+static SDL_GPUShader *load_shader(SDL_GPUDevice *device, const char *name, SDL_GPUShaderStage stage,
+                                  Uint32 num_storage_buffers, Uint32 num_uniform_buffers)
+{
+    size_t size;
+    void *code = load_shader_code(name, &size);
+    if (!code) {
+        return NULL;
+    }
+    SDL_GPUShaderCreateInfo info;
+    SDL_zero(info);
+    info.code = (const Uint8 *)code;
+    info.code_size = size;
+    info.entrypoint = "main";
+    info.format = SDL_GPU_SHADERFORMAT_SPIRV;
+    info.stage = stage;
+    info.num_storage_buffers = num_storage_buffers;
+    info.num_uniform_buffers = num_uniform_buffers;
+    SDL_GPUShader *shader = SDL_CreateGPUShader(device, &info);
+    SDL_free(code);
+    return shader;
+}
+
+static int create_pipelines(GpuParticles *particles)
+{
+    SDL_GPUDevice *device = particles->device;
+    size_t size;
+    void *code = load_shader_code("particles.comp", &size);
+    if (!code) {
+        return 0;
+    }
+    SDL_GPUComputePipelineCreateInfo compute;
+    SDL_zero(compute);
+    compute.code = (const Uint8 *)code;
+    compute.code_size = size;
+    compute.entrypoint = "main";
+    compute.format = SDL_GPU_SHADERFORMAT_SPIRV;
+    compute.num_readwrite_storage_buffers = 1;
+    compute.num_uniform_buffers = 1;
+    compute.threadcount_x = GPU_PARTICLE_THREADS;
+    compute.threadcount_y = 1;
+    compute.threadcount_z = 1;
+    particles->integrate = SDL_CreateGPUComputePipeline(device, &compute);
+    SDL_free(code);
+    if (!particles->integrate) {
+        return 0;
+    }
+
+    SDL_GPUShader *vertex = load_shader(device, "particles.vert", SDL_GPU_SHADERSTAGE_VERTEX, 1, 1);
+    SDL_GPUShader *fragment = load_shader(device, "particles.frag", SDL_GPU_SHADERSTAGE_FRAGMENT, 0, 0);
+    if (!vertex || !fragment) {
+        if (vertex) SDL_ReleaseGPUShader(device, vertex);
+        if (fragment) SDL_ReleaseGPUShader(device, fragment);
+        return 0;
+    }
+
+    // Premultiplied over, to match the target's blend mode when it is composited
+    SDL_GPUColorTargetDescription color;
+    SDL_zero(color);
+    color.format = SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM;
+    color.blend_state.enable_blend = true;
+    color.blend_state.src_color_blendfactor = SDL_GPU_BLENDFACTOR_ONE;
+    color.blend_state.dst_color_blendfactor = SDL_GPU_BLENDFACTOR_ONE_MINUS_SRC_ALPHA;
+    color.blend_state.color_blend_op = SDL_GPU_BLENDOP_ADD;
+    color.blend_state.src_alpha_blendfactor = SDL_GPU_BLENDFACTOR_ONE;
+    color.blend_state.dst_alpha_blendfactor = SDL_GPU_BLENDFACTOR_ONE_MINUS_SRC_ALPHA;
+    color.blend_state.alpha_blend_op = SDL_GPU_BLENDOP_ADD;
+
+    SDL_GPUGraphicsPipelineCreateInfo graphics;
+    SDL_zero(graphics);
+    graphics.vertex_shader = vertex;
+    graphics.fragment_shader = fragment;
+    graphics.primitive_type = SDL_GPU_PRIMITIVETYPE_TRIANGLESTRIP;
+    graphics.rasterizer_state.fill_mode = SDL_GPU_FILLMODE_FILL;
+    graphics.rasterizer_state.cull_mode = SDL_GPU_CULLMODE_NONE;
+    graphics.target_info.color_target_descriptions = &color;
+    graphics.target_info.num_color_targets = 1;
+    particles->draw = SDL_CreateGPUGraphicsPipeline(device, &graphics);
+    SDL_ReleaseGPUShader(device, vertex);
+    SDL_ReleaseGPUShader(device, fragment);
+    return particles->draw != NULL;
+}
+
+/* (Re)creates the target to match the render output. */
+static int size_target(GpuParticles *particles, SDL_Renderer *renderer)
+{
+    int out_w, out_h;
+    if (!SDL_GetRenderOutputSize(renderer, &out_w, &out_h) || out_w <= 0 || out_h <= 0) {
+        return 0;
+    }
+    if (particles->target && out_w == particles->target_w && out_h == particles->target_h) {
+        return 1;
+    }
+    if (particles->target) {
+        SDL_DestroyTexture(particles->target);
+    }
+    // RGBA32 is R8G8B8A8_UNORM on the GPU, the format the draw pipeline was built for
+    particles->target = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_TARGET, out_w, out_h);
+    if (!particles->target) {
+        return 0;
+    }
+    SDL_SetTextureBlendMode(particles->target, SDL_BLENDMODE_BLEND_PREMULTIPLIED);
+    SDL_SetTextureScaleMode(particles->target, SDL_SCALEMODE_NEAREST);
+    particles->target_w = out_w;
+    particles->target_h = out_h;
+    return 1;
+}
+
+/* Copies spawns into the ring at head, wrapping at the end. Only the newest
+   capacity spawns can survive, so any before them are skipped. */
+static void upload_spawns(GpuParticles *particles, SDL_GPUCommandBuffer *commands,
+                          const ParticleSpawn *spawns, int num_spawns)
+{
+    Uint32 count = (Uint32)SDL_max(num_spawns, 0);
+    if (count > particles->capacity) {
+        spawns += count - particles->capacity;
+        count = particles->capacity;
+    }
+    if (count == 0) {
+        return;
+    }
+
+    if (count > particles->upload_capacity) {
+        if (particles->upload) {
+            SDL_ReleaseGPUTransferBuffer(particles->device, particles->upload);
+        }
+        SDL_GPUTransferBufferCreateInfo info;
+        SDL_zero(info);
+        info.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD;
+        info.size = (Uint32)sizeof(ParticleSpawn) * SDL_max(count, 4096u);
+        particles->upload = SDL_CreateGPUTransferBuffer(particles->device, &info);
+        particles->upload_capacity = particles->upload ? info.size / (Uint32)sizeof(ParticleSpawn) : 0;
+        if (!particles->upload) {
+            return;
+        }
+    }
+
+    // Cycling hands back fresh memory if the GPU is still reading last frame's spawns
+    void *mapped = SDL_MapGPUTransferBuffer(particles->device, particles->upload, true);
+    if (!mapped) {
+        return;
+    }
+    SDL_memcpy(mapped, spawns, sizeof(ParticleSpawn) * count);
+    SDL_UnmapGPUTransferBuffer(particles->device, particles->upload);
+
+    SDL_GPUCopyPass *copy = SDL_BeginGPUCopyPass(commands);
+    Uint32 first = SDL_min(count, particles->capacity - particles->head);
+    SDL_GPUTransferBufferLocation source = {particles->upload, 0};
+    SDL_GPUBufferRegion region = {particles->particles, (Uint32)sizeof(ParticleSpawn) * particles->head,
+                                  (Uint32)sizeof(ParticleSpawn) * first};
+    SDL_UploadToGPUBuffer(copy, &source, &region, false);
+    if (count > first) {
+        source.offset = (Uint32)sizeof(ParticleSpawn) * first;
+        region.offset = 0;
+        region.size = (Uint32)sizeof(ParticleSpawn) * (count - first);
+        SDL_UploadToGPUBuffer(copy, &source, &region, false);
+    }
+    SDL_EndGPUCopyPass(copy);
+
+    particles->head = (particles->head + count) % particles->capacity;
+    particles->used = SDL_min(particles->used + count, particles->capacity);
+}
@@ -0,0 +1,55 @@
+/*
+  GPU particle backend.
+
+  With the SDL_GPU render driver, particles can live in a GPU storage buffer
+  instead of the simulation's pool. The game only queues what it emits; the
+  spawns are uploaded into a ring in the buffer, a compute shader advances
+  every particle with the same motion as particle_integrate(), and a single
+  instanced draw renders them all into a texture that is composited over the
+  world. Nothing is read back or rebuilt on the CPU, so the particle count is
+  bounded by the GPU rather than by uploads and vertex building.
+
+  Particles simulated this way are cosmetic: they aren't part of the game
+  state, so recording and replaying sessions keep to the CPU pool. The
+  shaders are SPIR-V, loaded from shaders/ next to the executable, and are
+  only built with the HELLO_GPU_PARTICLES CMake option.
+*/
+#ifndef GPU_PARTICLES_H
+#define GPU_PARTICLES_H
+
+#include <SDL3/SDL.h>
+
+#include "game.h"
+#include "particles.h"
+
+#define GPU_PARTICLE_THREADS 64 // Compute workgroup size, matches particles.comp
+#define GPU_PARTICLE_MAX_STEPS 8 // Ticks one frame may advance by; more are dropped like the frame loop does
+
+typedef struct {
+    SDL_GPUDevice *device; // The renderer's, not owned
+    SDL_GPUComputePipeline *integrate;
+    SDL_GPUGraphicsPipeline *draw;
+    SDL_GPUBuffer *particles; // capacity ParticleSpawn-sized slots
+    SDL_GPUTransferBuffer *upload; // Spawns on their way to the ring
+    Uint32 upload_capacity; // In spawns
+    SDL_Texture *target; // Drawn into each frame, then composited
+    int target_w, target_h;
+    Uint32 capacity;
+    Uint32 head; // Slot the next spawn goes into, overwriting the oldest particle
+    Uint32 used; // Slots written so far, up to capacity; nothing past it is simulated or drawn
+} GpuParticles;
+
+// Sets the backend up on renderer's GPU device. Returns 0 with the SDL error
+// set if the renderer isn't the gpu driver, the device can't take SPIR-V or
+// the shaders are missing.
+int gpu_particles_init(GpuParticles *particles, SDL_Renderer *renderer, int capacity);
+void gpu_particles_free(GpuParticles *particles);
+
+// Advances the particles already there by steps ticks, adds the spawns as
+// they are and draws the result into particles->target as the view from
+// camera. The target is the size of
+// the render output. Returns 0 if the frame's GPU work couldn't be submitted.
+int gpu_particles_render(GpuParticles *particles, SDL_Renderer *renderer, const ParticleSpawn *spawns, int num_spawns,
+                         int steps, float gravity, SDL_FPoint camera);
+
+#endif /* GPU_PARTICLES_H */
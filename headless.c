@@ -0,0 +1,263 @@
+/*
+  headless - runs the simulation without a window or renderer.
+
+  Usage: headless [--ticks N] [--script file] [--particles N] [--walkers N]
+                  [--threads N] [--seed N] [--record file | --replay file]
+
+  Replays a scripted input stream as fast as the machine allows and reports
+  ticks per second, particle throughput and collision queries per tick. The
+  script is one step per line, '#' starts a comment:
+
+    <ticks> <buttons>
+
+  where buttons is any of L (left), R (right), J (jump) and B (rewind), or
+  - for none.
+  Jump presses are generated whenever J goes down. The script loops until
+  the tick count is reached; a lost game restarts and a won level moves on,
+  so a long run keeps playing. --walkers adds AI actors that share the
+  player's physics, for measuring how the actor update scales. --threads
+  sets how many threads the parallel phases use (default: every core).
+
+  --record saves the inputs of the run as a replay; --replay plays one back
+  (from headless or the game) instead of the script, with its seed and play
+  area. Both print a checksum of the final state, so a replay can be checked
+  against the run it was recorded from.
+*/
+#include <SDL3/SDL.h>
+
+#include "game.h"
+#include "jobs.h"
+#include "replay.h"
+
+#define DEFAULT_TICKS (TICK_RATE * 60 * 10) // Ten minutes of play
+#define DEFAULT_PARTICLE_CAPACITY 16384
+#define MAX_SCRIPT_STEPS 1024
+#define DEFAULT_SEED 1 // Fixed so runs are comparable unless asked otherwise
+
+// Same play area as the game window
+#define PLAY_WIDTH 1200.0f
+#define PLAY_HEIGHT 800.0f
+
+typedef struct {
+    int ticks;
+    Uint32 buttons;
+} ScriptStep;
+
+// Runs right across the first levels, jumping over the gaps
+static const char *default_script =
+    "30 -\n"
+    "40 R\n"
+    "12 RJ\n"
+    "30 R\n"
+    "12 RJ\n"
+    "20 R\n"
+    "20 -\n"
+    "12 J\n"
+    "30 L\n"
+    "12 LJ\n"
+    "40 R\n"
+    "14 RJ\n"
+    "6 R\n"
+    "10 RJ\n"
+    "40 R\n";
+
+static ScriptStep script[MAX_SCRIPT_STEPS];
+static int num_steps = 0;
+
+static int parse_script(char *text)
+{
+    num_steps = 0;
+    char *state = NULL;
+    for (char *line = SDL_strtok_r(text, "\n", &state); line; line = SDL_strtok_r(NULL, "\n", &state)) {
+        char *comment = SDL_strchr(line, '#');
+        if (comment) {
+            *comment = '\0';
+        }
+
+        char *end;
+        long ticks = SDL_strtol(line, &end, 10);
+        if (end == line) {
+            continue; // Blank line
+        }
+        if (ticks <= 0 || num_steps == MAX_SCRIPT_STEPS) {
+            SDL_Log("Bad script step: %s", line);
+            return 0;
+        }
+
+        Uint32 buttons = 0;
+        for (const char *c = end; *c; c++) {
+            if (*c == 'L') {
+                buttons |= GAME_INPUT_LEFT;
+            } else if (*c == 'R') {
+                buttons |= GAME_INPUT_RIGHT;
+            } else if (*c == 'J') {
+                buttons |= GAME_INPUT_JUMP;
+            } else if (*c == 'B') {
+                buttons |= GAME_INPUT_REWIND;
+            }
+        }
+        script[num_steps++] = (ScriptStep){(int)ticks, buttons};
+    }
+    return num_steps > 0;
+}
+
+int main(int argc, char *argv[])
+{
+    Uint64 total_ticks = DEFAULT_TICKS;
+    int capacity = DEFAULT_PARTICLE_CAPACITY;
+    int num_walkers = 0;
+    int num_threads = 0;
+    const char *script_path = NULL;
+    Uint64 seed = DEFAULT_SEED;
+    const char *record_path = NULL;
+    const char *replay_path = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (SDL_strcmp(argv[i], "--ticks") == 0 && i + 1 < argc) {
+            total_ticks = SDL_strtoull(argv[++i], NULL, 10);
+        } else if (SDL_strcmp(argv[i], "--script") == 0 && i + 1 < argc) {
+            script_path = argv[++i];
+        } else if (SDL_strcmp(argv[i], "--particles") == 0 && i + 1 < argc) {
+            capacity = SDL_atoi(argv[++i]);
+        } else if (SDL_strcmp(argv[i], "--walkers") == 0 && i + 1 < argc) {
+            num_walkers = SDL_atoi(argv[++i]);
+        } else if (SDL_strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            num_threads = SDL_atoi(argv[++i]);
+        } else if (SDL_strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = SDL_strtoull(argv[++i], NULL, 10);
+        } else if (SDL_strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            record_path = argv[++i];
+        } else if (SDL_strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            replay_path = argv[++i];
+        } else {
+            SDL_Log("Usage: %s [--ticks N] [--script file] [--particles N] [--walkers N] [--threads N] [--seed N] "
+                    "[--record file | --replay file]", argv[0]);
+            return 1;
+        }
+    }
+
+    char *text = script_path ? (char *)SDL_LoadFile(script_path, NULL) : SDL_strdup(default_script);
+    if (!text) {
+        SDL_Log("Couldn't read %s: %s", script_path, SDL_GetError());
+        return 1;
+    }
+    int ok = parse_script(text);
+    SDL_free(text);
+    if (!ok) {
+        return 1;
+    }
+
+    static Replay replay;
+    float play_w = PLAY_WIDTH, play_h = PLAY_HEIGHT;
+    if (replay_path) {
+        if (!replay_load(&replay, replay_path)) {
+            SDL_Log("Couldn't load replay: %s", SDL_GetError());
+            return 1;
+        }
+        seed = replay.seed;
+        play_w = replay.width;
+        play_h = replay.height;
+        num_walkers = replay.num_walkers;
+        capacity = replay.particle_capacity;
+        total_ticks = replay.num_ticks;
+    } else if (record_path) {
+        replay_init(&replay, seed, play_w, play_h, num_walkers, capacity);
+    }
+
+    static Game game;
+    static Profiler profiler;
+    if (!game_init(&game, play_w, play_h, capacity, num_walkers, seed, &profiler)) {
+        SDL_Log("Couldn't start a game with %d particles and %d walkers", capacity, num_walkers);
+        return 1;
+    }
+    static JobSystem jobs;
+    if (!jobs_init(&jobs, num_threads)) {
+        SDL_Log("Couldn't start job threads: %s", SDL_GetError());
+    }
+    game.jobs = &jobs;
+
+    Uint64 phase_ns[PROFILE_PHASE_COUNT] = {0};
+    Uint64 particles_updated = 0;
+    Uint64 queries = 0;
+    Uint64 actors_updated = 0;
+    int step = 0, step_ticks = 0;
+    Uint32 prev_buttons = 0;
+    Uint32 continue_buttons = 0;
+
+    Uint64 start = SDL_GetTicksNS();
+    for (Uint64 tick = 0; tick < total_ticks; tick++) {
+        GameInput input;
+        if (replay_path) {
+            if (!replay_next(&replay, &input)) {
+                break;
+            }
+        } else {
+            input.buttons = script[step].buttons;
+            if ((input.buttons & GAME_INPUT_JUMP) && !(prev_buttons & GAME_INPUT_JUMP)) {
+                input.buttons |= GAME_INPUT_JUMP_PRESSED;
+            }
+            prev_buttons = input.buttons;
+            if (++step_ticks == script[step].ticks) {
+                step = (step + 1) % num_steps;
+                step_ticks = 0;
+            }
+            input.buttons |= continue_buttons;
+            if (record_path && !replay_record(&replay, &input)) {
+                SDL_Log("Out of memory recording input");
+                return 1;
+            }
+        }
+
+        profiler_begin_frame(&profiler);
+        particles_updated += game.particles.count;
+        actors_updated += game.actors.count;
+        game_tick(&game, &input);
+        for (int phase = 0; phase < PROFILE_PHASE_COUNT; phase++) {
+            phase_ns[phase] += profiler.current.phase_ns[phase];
+        }
+        queries += SDL_SetAtomicInt(&game.loaded_level.broadphase.num_queries, 0);
+
+        // Keep playing: move on after a win, start over after a loss or the last level.
+        // These go through the next tick's input so recordings capture them
+        continue_buttons = 0;
+        if (game.game_won && game.current_level < MAX_LEVELS - 1) {
+            continue_buttons = GAME_INPUT_NEXT_LEVEL;
+        } else if (game.game_won || game.game_over) {
+            continue_buttons = GAME_INPUT_RESTART;
+        }
+    }
+    Uint64 elapsed = SDL_GetTicksNS() - start;
+
+    double seconds = elapsed / 1e9;
+    double particle_ms = phase_ns[PROFILE_PARTICLES] / 1e6;
+    SDL_Log("%" SDL_PRIu64 " ticks in %.3f s: %.0f ticks/s (%.1fx real time)",
+            total_ticks, seconds, total_ticks / seconds, (total_ticks / (double)TICK_RATE) / seconds);
+    SDL_Log("Threads: %d", jobs.num_threads + 1);
+    SDL_Log("Particles: %" SDL_PRIu64 " updated, %.0f per ms", particles_updated,
+            particle_ms > 0 ? particles_updated / particle_ms : 0.0);
+    SDL_Log("Collision queries: %.2f per tick", total_ticks ? (double)queries / total_ticks : 0.0);
+    double actor_ms = (phase_ns[PROFILE_INPUT] + phase_ns[PROFILE_COLLISION]) / 1e6;
+    SDL_Log("Actors: %" SDL_PRIu64 " updated, %.0f per ms", actors_updated,
+            actor_ms > 0 ? actors_updated / actor_ms : 0.0);
+    for (int phase = 0; phase < PROFILE_PHASE_COUNT; phase++) {
+        if (phase_ns[phase]) {
+            SDL_Log("  %-10s %8.3f us/tick", profiler_phase_name((ProfilePhase)phase),
+                    phase_ns[phase] / 1e3 / total_ticks);
+        }
+    }
+    SDL_Log("Final state: level %d, score %d, lives %d, player at %.2f, %.2f",
+            game.current_level + 1, game.score, game.lives, game.actors.x[ACTOR_PLAYER], game.actors.y[ACTOR_PLAYER]);
+    SDL_Log("Checksum: %08" SDL_PRIx32, game_checksum(&game));
+
+    if (record_path) {
+        if (!replay_save(&replay, record_path)) {
+            SDL_Log("Couldn't save replay to %s: %s", record_path, SDL_GetError());
+            return 1;
+        }
+        SDL_Log("Recorded %" SDL_PRIu64 " ticks to %s", replay.num_ticks, record_path);
+    }
+    replay_free(&replay);
+
+    game_free(&game);
+    jobs_shutdown(&jobs);
+    return 0;
+}
@@ -16,141 +16,262 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "atlas.h"
+#include "batch.h"
+#include "budget.h"
+#include "game.h"
+#include "gpu_particles.h"
+#include "jobs.h"
+#include "pacing.h"
+#include "profiler.h"
+#include "replay.h"
+#include "snapshot.h"
+#include "tiles.h"
+
 // Game constants
 const int SCREEN_WIDTH = 1200;
 const int SCREEN_HEIGHT = 800;
-#define MAX_PARTICLES 100
-#define MAX_COLLECTIBLES 10
-#define MAX_LEVELS 6
-
-// Physics constants
-const float GRAVITY = 0.2f;
-const float JUMP_STRENGTH = -8.0f;
-const float MOVE_SPEED = 5.0f;
-const float MAX_FALL_SPEED = 18.0f;
-const float SPIN_SPEED = 8.0f;
+#define DEFAULT_PARTICLE_CAPACITY 16384
+#define BENCH_PARTICLE_COUNT 100000
 
-const int COYOTE_TIME = 6; // frames
-const int JUMP_BUFFER_TIME = 8; // frames
+static const Uint64 MAX_FRAME_TIME_NS = SDL_NS_PER_SECOND / 4; // Drop time beyond this to avoid a spiral of death
+const float WALK_CYCLE_SPEED = 18.0f; // radians per second
 
-// Game state
+// Window state
 static SDL_Window *window = NULL;
 static SDL_Renderer *renderer = NULL;
 static int w = 0, h = 0;
-static int game_over = 0;
-static int game_won = 0;
-static int current_level = 0;
-static int score = 0;
-static int lives = 3;
 
-// Timer system - Global timer for all levels
-static float global_timer = 0.0f;
-static float global_time_limit = 120.0f; // 2 minutes total for all levels
+// The simulation; everything below only draws it
+static Game game;
+static JobSystem jobs; // Runs the simulation's parallel phases
+
+// Input handed to the simulation: buttons held as of the last frame, and
+// presses since the last tick so short taps aren't missed
+static SDL_AtomicInt held_buttons;
+static SDL_AtomicInt pending_buttons;
+
+// Render snapshots - frames are drawn from these, never from the Game itself
+static SnapshotBuffer snapshots;
+static const RenderSnapshot *snapshot = NULL; // The one being drawn this frame
+
+// Pipelined mode (--pipelined): the simulation ticks on its own thread while
+// this one renders, so a slow present doesn't hold up gameplay
+static int pipelined = 0;
+static SDL_Thread *sim_thread = NULL;
+static SDL_AtomicInt sim_quit;
+static SDL_AtomicInt sim_finished; // Set once a replay has run out
+static Profiler sim_profiler; // Simulation phases since startup, folded into frames as snapshots arrive
+static Uint64 last_sim_phase_ns[PROFILE_PHASE_COUNT];
+static Uint64 last_sim_tick = 0;
+
+// Input recording (--record) and playback (--replay); playback bypasses the keyboard
+static Replay replay;
+static const char *record_path = NULL;
+static int replaying = 0;
+static int started = 0; // Set once init has finished; until then there is no session to save
+
+// Background cache - gradient sky baked into a texture, rebuilt on resize
+static SDL_Texture *background_texture = NULL;
+static int background_w = 0, background_h = 0;
+
+// HUD cache - the HUD is drawn into a texture and only redrawn when
+// something it shows changes, which is at most once a second for the timer
+typedef struct {
+    int out_w, out_h;
+    int score, lives, level;
+    int collected, num_collectibles;
+    int timer_seconds;
+    int timer_urgency; // 0 plenty, 1 low, 2 critical
+    int time_up;
+    int has_double_jump;
+    int game_over, game_won;
+} HudState;
+static SDL_Texture *hud_texture = NULL;
+static HudState hud_state;
 
 // Frame rate control
 static Uint64 last_frame_time = 0;
-static const Uint64 TARGET_FRAME_TIME = 16666667; // 60 FPS in nanoseconds
-
-// Player state
-static SDL_FRect player;
-static float player_vy = 0;
-static int is_on_ground = 0;
-static int coyote_timer = 0;
-static int jump_buffer = 0;
-static int jump_held = 0;
-static float player_rotation = 0.0f;
-static int has_double_jump = 0;
-static int double_jump_used = 0;
-static float invincibility_timer = 0;
-static float walk_animation_timer = 0.0f;
-static int is_walking = 0;
-
-// Particle system
-typedef struct {
-    float x, y, vx, vy;
-    float life, max_life;
-    Uint8 r, g, b, a;
-    int active;
-} Particle;
-
-static Particle particles[MAX_PARTICLES];
-
-// Collectibles
-typedef struct {
-    SDL_FRect rect;
-    int collected;
-    float bob_offset;
-} Collectible;
-
-static Collectible collectibles[MAX_COLLECTIBLES];
-static int total_collectibles = 0;
-static int collected_count = 0;
-
-// Moving platforms
-typedef struct {
-    SDL_FRect rect;
-    float vx, vy;
-    float start_x, end_x, start_y, end_y;
-    int direction;
-} MovingPlatform;
-
-static MovingPlatform moving_platforms[5];
-static int num_moving_platforms = 0;
-
-// Level data
-typedef struct {
-    SDL_FRect platforms[20];
-    int num_platforms;
-    SDL_FRect lava_squares[5];
-    int num_lava;
-    SDL_FRect start_pos;
-    SDL_FRect goal;
-    Collectible level_collectibles[MAX_COLLECTIBLES];
-    int num_collectibles;
-    MovingPlatform level_moving_platforms[5];
-    int num_moving;
-} Level;
-
-static Level levels[MAX_LEVELS];
+static Uint64 tick_accumulator = 0;
+static float render_alpha = 1.0f; // Interpolation factor between the last two ticks
+static FramePacer frame_pacer; // Target rate set with --fps, cycled with F4
+
+// Quad batch shared by the render layers, flushed once per layer
+static QuadBatch quad_batch;
+
+// Stick figure sprites, drawn through the quad batch
+static Atlas atlas;
+
+// Static level geometry, baked per tile
+static TileCache tile_cache;
+
+// Frame profiler - overlay toggled with F3, CSV written on exit with --profile-csv
+static Profiler profiler;
+static int show_profiler = 0;
+static const char *profile_csv_path = NULL;
+
+// Particle detail, traded for frame rate by the frame budget and handed to
+// the simulation each tick in thousandths
+static FrameBudget frame_budget;
+static SDL_AtomicInt particle_detail;
+
+// GPU particles (--gpu-particles): the game queues its spawns instead of
+// simulating them, and each frame hands those from the ticks it draws to the
+// GPU. Ticks fill pending_spawns, frames move them to frame_spawns, where
+// spawns from ticks newer than the snapshot wait for a later frame.
+static int use_gpu_particles = 0;
+static GpuParticles gpu_particles;
+static SDL_Mutex *spawn_lock = NULL;
+static ParticleQueue pending_spawns;
+static ParticleQueue frame_spawns;
+static Uint64 gpu_particle_tick = 0; // Tick the GPU particles were last advanced to
 
 // Function declarations
-void init_particles(void);
-void add_particle(float x, float y, float vx, float vy, Uint8 r, Uint8 g, Uint8 b, float life);
-void update_particles(void);
+void press_buttons(Uint32 buttons);
+void sample_keyboard(void);
+GameInput read_input(void);
+int run_tick(void);
+void publish_snapshot(Uint64 time_ns);
+int SDLCALL simulation_thread(void *data);
 void render_particles(void);
-void init_levels(void);
-void load_level(int level_num);
-void reset_player(void);
-void update_collectibles(void);
+void render_gpu_particles(float camera_x, float camera_y);
 void render_collectibles(void);
-void update_moving_platforms(void);
 void render_moving_platforms(void);
-int is_colliding(SDL_FRect a, SDL_FRect b);
 void render_hud(void);
+void draw_hud(void);
+void render_profiler(void);
 void render_background(void);
 void render_player(void);
+void render_walkers(void);
+void render_frame(void);
+SDL_FRect interpolate_rect(SDL_FRect prev, SDL_FRect cur);
 
 /* This function runs once at startup. */
 SDL_AppResult SDL_AppInit(void **appstate, int argc, char *argv[])
 {
+    int capacity = DEFAULT_PARTICLE_CAPACITY;
+    int num_walkers = 0;
+    int num_threads = 0; // Every core
+    int target_hz = PACING_DISPLAY;
+    Uint64 seed = SDL_GetPerformanceCounter(); // A different run each time unless pinned
+    for (int i = 1; i < argc; i++) {
+        if (SDL_strcmp(argv[i], "--uncapped") == 0) {
+            target_hz = PACING_UNCAPPED;
+        } else if (SDL_strcmp(argv[i], "--fps") == 0 && i + 1 < argc) {
+            ++i;
+            target_hz = SDL_strcmp(argv[i], "uncapped") == 0 ? PACING_UNCAPPED : SDL_max(SDL_atoi(argv[i]), 0);
+        } else if (SDL_strcmp(argv[i], "--particles") == 0 && i + 1 < argc) {
+            capacity = SDL_atoi(argv[++i]);
+        } else if (SDL_strcmp(argv[i], "--walkers") == 0 && i + 1 < argc) {
+            num_walkers = SDL_atoi(argv[++i]);
+        } else if (SDL_strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            num_threads = SDL_atoi(argv[++i]);
+        } else if (SDL_strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = SDL_strtoull(argv[++i], NULL, 10);
+        } else if (SDL_strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            record_path = argv[++i];
+        } else if (SDL_strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            if (!replay_load(&replay, argv[++i])) {
+                SDL_Log("Couldn't load replay: %s", SDL_GetError());
+                return SDL_APP_FAILURE;
+            }
+            replaying = 1;
+        } else if (SDL_strcmp(argv[i], "--gpu-particles") == 0) {
+            use_gpu_particles = 1;
+        } else if (SDL_strcmp(argv[i], "--pipelined") == 0) {
+            pipelined = 1;
+        } else if (SDL_strcmp(argv[i], "--profile-csv") == 0 && i + 1 < argc) {
+            profile_csv_path = argv[++i];
+        } else if (SDL_strcmp(argv[i], "--bench-particles") == 0) {
+            // Measure the particle update on its own and exit, no window needed
+            particle_benchmark(BENCH_PARTICLE_COUNT, 1000);
+            return SDL_APP_SUCCESS;
+        }
+    }
+
+    // The GPU particle backend shares the renderer's device, so only the gpu driver will do
+    if (use_gpu_particles) {
+        SDL_SetHint(SDL_HINT_RENDER_DRIVER, "gpu");
+    }
     if (!SDL_CreateWindowAndRenderer("Enhanced Platformer", SCREEN_WIDTH, SCREEN_HEIGHT, 0, &window, &renderer)) {
         SDL_Log("Couldn't create window and renderer: %s", SDL_GetError());
         return SDL_APP_FAILURE;
     }
 
+    // Present on vsync when the display runs at the target rate; otherwise the pacer holds frames to it
+    frame_pacer_init(&frame_pacer, renderer, window, target_hz);
+
     SDL_GetRenderOutputSize(renderer, &w, &h);
 
-    init_particles();
-    init_levels();
-    load_level(0);
-    reset_player();
+    // A replay runs in the session it was recorded in
+    float play_w = (float)w, play_h = (float)h;
+    if (replaying) {
+        seed = replay.seed;
+        play_w = replay.width;
+        play_h = replay.height;
+        num_walkers = replay.num_walkers;
+        capacity = replay.particle_capacity;
+    } else if (record_path) {
+        replay_init(&replay, seed, play_w, play_h, num_walkers, capacity);
+    }
+
+    // Particles simulated on the GPU aren't game state, so sessions being recorded or replayed keep to the pool
+    if (use_gpu_particles && (record_path || replaying)) {
+        SDL_Log("GPU particles are off while recording or replaying");
+        use_gpu_particles = 0;
+    }
+    if (use_gpu_particles) {
+        spawn_lock = SDL_CreateMutex();
+        if (!spawn_lock || !gpu_particles_init(&gpu_particles, renderer, capacity)) {
+            SDL_Log("Couldn't set up GPU particles, simulating them here: %s", SDL_GetError());
+            use_gpu_particles = 0;
+        }
+    }
 
-    // Initialize global timer
-    global_timer = global_time_limit;
+    if (!game_init(&game, play_w, play_h, use_gpu_particles ? 1 : capacity, num_walkers, seed, &profiler)) {
+        SDL_Log("Couldn't start a game with %d particles and %d walkers", capacity, num_walkers);
+        return SDL_APP_FAILURE;
+    }
+    SDL_Log("Random seed: %" SDL_PRIu64 " (pin it with --seed)", seed);
+    if (!jobs_init(&jobs, num_threads)) {
+        SDL_Log("Couldn't start job threads: %s", SDL_GetError());
+    }
+    game.jobs = &jobs;
+    game.external_particles = use_gpu_particles;
+    if (!quad_batch_init(&quad_batch, 1024)) {
+        SDL_Log("Couldn't allocate the quad batch");
+        return SDL_APP_FAILURE;
+    }
+    if (!atlas_init(&atlas, renderer)) {
+        SDL_Log("Couldn't create the sprite atlas: %s", SDL_GetError());
+        return SDL_APP_FAILURE;
+    }
+    quad_batch_set_texture(&quad_batch, renderer, atlas.texture, atlas.white);
+    if (!tile_cache_init(&tile_cache, renderer)) {
+        // Not fatal, the level is drawn rect by rect instead
+        SDL_Log("Couldn't create the tile cache: %s", SDL_GetError());
+    }
 
     // Initialize frame timing
     last_frame_time = SDL_GetTicksNS();
+    frame_budget_init(&frame_budget, frame_pacer_budget(&frame_pacer));
+    SDL_SetAtomicInt(&particle_detail, 1000);
+
+    // Something to draw before the first tick
+    snapshot_buffer_init(&snapshots);
+    publish_snapshot(last_frame_time);
+
+    if (pipelined) {
+        game.profiler = &sim_profiler;
+        sim_thread = SDL_CreateThread(simulation_thread, "simulation", NULL);
+        if (!sim_thread) {
+            SDL_Log("Couldn't start the simulation thread, running it here: %s", SDL_GetError());
+            game.profiler = &profiler;
+            pipelined = 0;
+        }
+    }
 
+    started = 1;
     return SDL_APP_CONTINUE;
 }
 
@@ -164,42 +285,23 @@ SDL_AppResult SDL_AppEvent(void *appstate, SDL_Event *event)
         switch (event->key.key) {
         case SDLK_ESCAPE:
             return SDL_APP_SUCCESS;
+        case SDLK_F3:
+            show_profiler = !show_profiler;
+            break;
+        case SDLK_F4:
+            frame_pacer_next_rate(&frame_pacer);
+            frame_budget.target_ns = frame_pacer_budget(&frame_pacer);
+            SDL_Log("Frame rate: %s, %d Hz", frame_pacer_mode(&frame_pacer), frame_pacer.target_hz);
+            break;
         case SDLK_R:
-            if (game_over || game_won) {
-                // Restart from beginning
-                game_over = 0;
-                game_won = 0;
-                lives = 3;
-                score = 0;
-                current_level = 0;
-                global_timer = global_time_limit; // Reset global timer
-                load_level(current_level);
-                reset_player();
-            }
+            press_buttons(GAME_INPUT_RESTART);
             break;
         case SDLK_N:
-            if (game_won && current_level < MAX_LEVELS - 1) {
-                // Next level
-                current_level++;
-                game_won = 0;
-                load_level(current_level);
-                reset_player();
-            }
+            press_buttons(GAME_INPUT_NEXT_LEVEL);
             break;
         case SDLK_SPACE:
         case SDLK_UP:
-            if (!game_over && !game_won) {
-                jump_buffer = JUMP_BUFFER_TIME;
-                jump_held = 1;
-            }
-            break;
-        }
-        break;
-    case SDL_EVENT_KEY_UP:
-        switch (event->key.key) {
-        case SDLK_SPACE:
-        case SDLK_UP:
-            jump_held = 0;
+            press_buttons(GAME_INPUT_JUMP_PRESSED);
             break;
         }
         break;
@@ -210,722 +312,445 @@ SDL_AppResult SDL_AppEvent(void *appstate, SDL_Event *event)
 /* This function runs once per frame, and is the heart of the program. */
 SDL_AppResult SDL_AppIterate(void *appstate)
 {
-    if (!game_over && !game_won) {
-        // Update global timer
-        global_timer -= 1.0f / 60.0f; // Assuming 60 FPS
-        if (global_timer <= 0) {
-            game_over = 1;
-        }
-
-        // Handle input
-        const Uint8 *keystate = SDL_GetKeyboardState(NULL);
-        float old_x = player.x;
-
-        // Check if player is walking
-        is_walking = (keystate[SDL_SCANCODE_LEFT] || keystate[SDL_SCANCODE_A] ||
-                     keystate[SDL_SCANCODE_RIGHT] || keystate[SDL_SCANCODE_D]) && is_on_ground;
+    Uint64 now = SDL_GetTicksNS();
+    Uint64 elapsed = now - last_frame_time;
+    profiler_begin_frame(&profiler);
+    quad_batch.draw_calls = 0;
+    last_frame_time = now;
+    if (elapsed > MAX_FRAME_TIME_NS) {
+        elapsed = MAX_FRAME_TIME_NS;
+    }
 
-        // Update walking animation timer
-        if (is_walking) {
-            walk_animation_timer += 0.3f; // Animation speed
-            if (walk_animation_timer >= 6.28f) { // Full cycle (2 * PI)
-                walk_animation_timer -= 6.28f;
-            }
-        } else {
-            walk_animation_timer = 0.0f; // Reset when not walking
+    sample_keyboard();
+    if (pipelined) {
+        if (SDL_GetAtomicInt(&sim_finished)) {
+            return SDL_APP_SUCCESS;
         }
+        snapshot = snapshot_acquire(&snapshots);
 
-        // Horizontal movement
-        if (keystate[SDL_SCANCODE_LEFT] || keystate[SDL_SCANCODE_A]) {
-            player.x -= MOVE_SPEED;
-            // Add dust particles when moving
-            if (is_on_ground && SDL_GetTicks() % 3 == 0) {
-                add_particle(player.x + player.w/2, player.y + player.h,
-                           (float)(rand() % 20 - 10) / 10.0f, -1.0f,
-                           139, 69, 19, 30.0f);
-            }
+        // Fold the simulation time since the last snapshot into this frame
+        for (int phase = 0; phase < PROFILE_PHASE_COUNT; phase++) {
+            profiler.current.phase_ns[phase] += snapshot->sim_phase_ns[phase] - last_sim_phase_ns[phase];
+            last_sim_phase_ns[phase] = snapshot->sim_phase_ns[phase];
         }
-        if (keystate[SDL_SCANCODE_RIGHT] || keystate[SDL_SCANCODE_D]) {
-            player.x += MOVE_SPEED;
-            if (is_on_ground && SDL_GetTicks() % 3 == 0) {
-                add_particle(player.x + player.w/2, player.y + player.h,
-                           (float)(rand() % 20 - 10) / 10.0f, -1.0f,
-                           139, 69, 19, 30.0f);
+        profiler.current.ticks += (int)(snapshot->tick - last_sim_tick);
+        last_sim_tick = snapshot->tick;
+
+        // The newest tick is drawn as it catches up to real time, one tick behind
+        Uint64 since = now > snapshot->time_ns ? now - snapshot->time_ns : 0;
+        render_alpha = SDL_min((float)since / (float)TICK_TIME_NS, 1.0f);
+    } else {
+        // Run as many fixed simulation ticks as real time has accumulated
+        tick_accumulator += elapsed;
+        while (tick_accumulator >= TICK_TIME_NS) {
+            if (!run_tick()) {
+                return SDL_APP_SUCCESS;
             }
+            profiler_count_tick(&profiler);
+            tick_accumulator -= TICK_TIME_NS;
         }
+        publish_snapshot(now);
+        snapshot = snapshot_acquire(&snapshots);
 
-        // Screen boundaries
-        if (player.x < 0) player.x = 0;
-        if (player.x + player.w > w) player.x = w - player.w;
+        // Draw between the last two ticks
+        render_alpha = (float)tick_accumulator / (float)TICK_TIME_NS;
+    }
+    render_frame();
+    profiler_end_frame(&profiler, quad_batch.draw_calls);
+
+    // Particles are part of the simulation state, so recordings and replays
+    // stay at full detail to reproduce exactly; on the GPU they don't cost the frame
+    if (!record_path && !replaying && !use_gpu_particles) {
+        Uint64 work_ns = profiler.current.frame_ns - profiler.current.phase_ns[PROFILE_PRESENT];
+        float detail = frame_budget_update(&frame_budget, work_ns);
+        SDL_SetAtomicInt(&particle_detail, (int)(detail * 1000.0f));
+    }
 
-                // Horizontal collision with platforms
-        Level *level = &levels[current_level];
-        for (int i = 0; i < level->num_platforms; i++) {
-            if (is_colliding(player, level->platforms[i])) {
-                player.x = old_x;
-                break;
-            }
-        }
+    frame_pacer_wait(&frame_pacer);
 
-        // Check moving platform collisions
-        for (int i = 0; i < num_moving_platforms; i++) {
-            if (is_colliding(player, moving_platforms[i].rect)) {
-                player.x = old_x;
-                break;
-            }
-        }
+    return SDL_APP_CONTINUE;
+}
 
-        // Coyote time
-        if (is_on_ground) {
-            coyote_timer = COYOTE_TIME;
-        } else if (coyote_timer > 0) {
-            coyote_timer--;
+/* This function runs once at shutdown. */
+void SDL_AppQuit(void *appstate, SDL_AppResult result)
+{
+    if (sim_thread) {
+        SDL_SetAtomicInt(&sim_quit, 1);
+        SDL_WaitThread(sim_thread, NULL);
+        sim_thread = NULL;
+    }
+    if (background_texture) {
+        SDL_DestroyTexture(background_texture);
+        background_texture = NULL;
+    }
+    if (hud_texture) {
+        SDL_DestroyTexture(hud_texture);
+        hud_texture = NULL;
+    }
+    if (started && profile_csv_path && !profiler_write_csv(&profiler, profile_csv_path)) {
+        SDL_Log("Couldn't write profile to %s: %s", profile_csv_path, SDL_GetError());
+    }
+    if (started && record_path) {
+        if (replay_save(&replay, record_path)) {
+            SDL_Log("Recorded %" SDL_PRIu64 " ticks to %s, checksum %08" SDL_PRIx32,
+                    replay.num_ticks, record_path, game_checksum(&game));
+        } else {
+            SDL_Log("Couldn't save replay to %s: %s", record_path, SDL_GetError());
         }
+    }
+    replay_free(&replay);
+    snapshot_buffer_free(&snapshots);
+    quad_batch_free(&quad_batch);
+    tile_cache_free(&tile_cache);
+    gpu_particles_free(&gpu_particles);
+    particle_queue_free(&pending_spawns);
+    particle_queue_free(&frame_spawns);
+    if (spawn_lock) {
+        SDL_DestroyMutex(spawn_lock);
+        spawn_lock = NULL;
+    }
+    atlas_free(&atlas);
+    game_free(&game);
+    jobs_shutdown(&jobs);
+}
 
-        // Jump buffering and variable jump height
-        if (jump_buffer > 0) {
-            jump_buffer--;
-            if (coyote_timer > 0 || (has_double_jump && !double_jump_used)) {
-                if (coyote_timer > 0) {
-                    player_vy = JUMP_STRENGTH;
-                    coyote_timer = 0;
-                } else {
-                    player_vy = JUMP_STRENGTH * 0.8f; // Double jump is slightly weaker
-                    double_jump_used = 1;
-                }
-                jump_buffer = 0;
-
-                // Jump particles
-                for (int i = 0; i < 8; i++) {
-                    add_particle(player.x + player.w/2, player.y + player.h,
-                               (float)(rand() % 40 - 20) / 10.0f,
-                               (float)(rand() % 10 + 5) / 10.0f,
-                               200, 200, 255, 40.0f);
-                }
-            }
-        }
+/* Latches presses for the next tick; safe to call while the simulation thread reads them. */
+void press_buttons(Uint32 buttons)
+{
+    int old;
+    do {
+        old = SDL_GetAtomicInt(&pending_buttons);
+    } while (!SDL_CompareAndSwapAtomicInt(&pending_buttons, old, old | (int)buttons));
+}
 
-        // Variable jump height
-        if (!jump_held && player_vy < -2.0f) {
-            player_vy *= 0.5f; // Cut jump short
-        }
+/* Samples the keyboard into the held buttons; runs on the main thread, which owns the keyboard state. */
+void sample_keyboard(void)
+{
+    const bool *keystate = SDL_GetKeyboardState(NULL);
+    Uint32 buttons = 0;
+    if (keystate[SDL_SCANCODE_LEFT] || keystate[SDL_SCANCODE_A]) {
+        buttons |= GAME_INPUT_LEFT;
+    }
+    if (keystate[SDL_SCANCODE_RIGHT] || keystate[SDL_SCANCODE_D]) {
+        buttons |= GAME_INPUT_RIGHT;
+    }
+    if (keystate[SDL_SCANCODE_SPACE] || keystate[SDL_SCANCODE_UP]) {
+        buttons |= GAME_INPUT_JUMP;
+    }
+    if (keystate[SDL_SCANCODE_BACKSPACE]) {
+        buttons |= GAME_INPUT_REWIND;
+    }
+    SDL_SetAtomicInt(&held_buttons, (int)buttons);
+}
 
-        // Gravity and vertical movement
-        player_vy += GRAVITY;
-        if (player_vy > MAX_FALL_SPEED) player_vy = MAX_FALL_SPEED;
-        player.y += player_vy;
-
-
-
-                 // Vertical collision
-         is_on_ground = 0;
-
-         // Platform collisions
-         for (int i = 0; i < level->num_platforms; i++) {
-             if (is_colliding(player, level->platforms[i])) {
-                 if (player_vy > 0) {
-                     player.y = level->platforms[i].y - player.h;
-                     player_vy = 0;
-                     is_on_ground = 1;
-                     double_jump_used = 0;
-
-                     // Landing particles
-                     for (int j = 0; j < 5; j++) {
-                         add_particle(player.x + (float)(rand() % (int)player.w),
-                                    player.y + player.h,
-                                    (float)(rand() % 20 - 10) / 5.0f, -2.0f,
-                                    139, 69, 19, 25.0f);
-                     }
-                 } else if (player_vy < 0) {
-                     player.y = level->platforms[i].y + level->platforms[i].h;
-                     player_vy = 0;
-                 }
-                 break;
-             }
-         }
-
-         // Moving platform collisions
-         for (int i = 0; i < num_moving_platforms; i++) {
-             if (is_colliding(player, moving_platforms[i].rect)) {
-                 if (player_vy > 0) {
-                     player.y = moving_platforms[i].rect.y - player.h;
-                     player_vy = 0;
-                     is_on_ground = 1;
-                     double_jump_used = 0;
-                     // Move with platform
-                     player.x += moving_platforms[i].vx;
-                 } else if (player_vy < 0) {
-                     player.y = moving_platforms[i].rect.y + moving_platforms[i].rect.h;
-                     player_vy = 0;
-                 }
-                 break;
-             }
-         }
-
-        // Update invincibility
-        if (invincibility_timer > 0) {
-            invincibility_timer--;
-        }
+/* The buttons for the next tick: what is held plus what was pressed since the last one. */
+GameInput read_input(void)
+{
+    GameInput input;
+    input.buttons = (Uint32)SDL_GetAtomicInt(&held_buttons) | (Uint32)SDL_SetAtomicInt(&pending_buttons, 0);
+    return input;
+}
 
-                 // Lava collision
-         if (invincibility_timer <= 0) {
-             for (int i = 0; i < level->num_lava; i++) {
-                 if (is_colliding(player, level->lava_squares[i])) {
-                    lives--;
-                    if (lives <= 0) {
-                        game_over = 1;
-                    } else {
-                        // Respawn with invincibility
-                        player.x = level->start_pos.x;
-                        player.y = level->start_pos.y;
-                        player_vy = 0;
-                        invincibility_timer = 120; // 2 seconds at 60fps
-                    }
-
-                    // Death particles
-                    for (int j = 0; j < 15; j++) {
-                        add_particle(player.x + player.w/2, player.y + player.h/2,
-                                   (float)(rand() % 40 - 20) / 5.0f,
-                                   (float)(rand() % 40 - 20) / 5.0f,
-                                   255, 100, 0, 60.0f);
-                    }
-                    break;
-                }
-            }
+/* Runs one simulation tick on live or replayed input; returns 0 once a replay has run out. */
+int run_tick(void)
+{
+    GameInput input;
+    if (replaying) {
+        if (!replay_next(&replay, &input)) {
+            SDL_Log("Replay finished after %" SDL_PRIu64 " ticks, checksum %08" SDL_PRIx32,
+                    game.tick, game_checksum(&game));
+            return 0;
         }
-
-        // Fall off screen
-        if (player.y > h + 100) {
-            lives--;
-            if (lives <= 0) {
-                game_over = 1;
-            } else {
-                player.x = level->start_pos.x;
-                player.y = level->start_pos.y;
-                player_vy = 0;
-                invincibility_timer = 60;
-            }
+    } else {
+        input = read_input();
+        if (record_path && !replay_record(&replay, &input)) {
+            SDL_Log("Out of memory recording input, recording stopped");
+            record_path = NULL;
         }
+    }
+    game_set_particle_detail(&game, SDL_GetAtomicInt(&particle_detail) / 1000.0f);
+    game_tick(&game, &input);
+    if (use_gpu_particles) {
+        SDL_LockMutex(spawn_lock);
+        particle_queue_append(&pending_spawns, &game.particle_spawns);
+        SDL_UnlockMutex(spawn_lock);
+    }
+    return 1;
+}
 
-        // Goal collision
-        if (is_colliding(player, level->goal)) {
-            if (collected_count >= total_collectibles) {
-                game_won = 1;
-                score += 1000 + (lives * 500);
-            }
+/* Copies the game into the next snapshot and hands it to the renderer. */
+void publish_snapshot(Uint64 time_ns)
+{
+    RenderSnapshot *next = snapshot_write(&snapshots);
+    if (!snapshot_capture(next, &game, time_ns)) {
+        SDL_Log("Out of memory capturing a render snapshot");
+    }
+    SDL_memcpy(next->sim_phase_ns, sim_profiler.current.phase_ns, sizeof(next->sim_phase_ns));
+    snapshot_publish(&snapshots);
+}
+
+/* Pipelined mode: ticks in real time and publishes a snapshot after every tick. */
+int SDLCALL simulation_thread(void *data)
+{
+    Uint64 next_tick = SDL_GetTicksNS();
+    while (!SDL_GetAtomicInt(&sim_quit)) {
+        Uint64 now = SDL_GetTicksNS();
+        if (now < next_tick) {
+            SDL_DelayNS(next_tick - now);
+            continue;
+        }
+        if (now - next_tick > MAX_FRAME_TIME_NS) {
+            next_tick = now - MAX_FRAME_TIME_NS; // Drop time beyond this, as the frame loop does
         }
 
-        update_collectibles();
-        update_moving_platforms();
-    } else if (game_over) {
-        // Spin when dead
-        player_rotation += SPIN_SPEED;
-        if (player_rotation >= 360.0f) {
-            player_rotation -= 360.0f;
+        if (!run_tick()) {
+            SDL_SetAtomicInt(&sim_finished, 1);
+            break;
         }
-    }
+        profiler_count_tick(&sim_profiler);
 
-    update_particles();
+        // Stamped with when this tick was due, so the renderer interpolates from then on
+        publish_snapshot(next_tick);
+        next_tick += TICK_TIME_NS;
+    }
+    return 0;
+}
 
-    // Rendering
+/* Draws the current state, interpolated by render_alpha between the last two ticks. */
+void render_frame(void)
+{
+    Uint64 phase_start = SDL_GetTicksNS();
     render_background();
+    profiler_add(&profiler, PROFILE_BACKGROUND, phase_start);
+
+    phase_start = SDL_GetTicksNS();
 
-    Level *level = &levels[current_level];
-
-    // Draw platforms
-    SDL_SetRenderDrawColor(renderer, 100, 200, 100, 255);
-    SDL_RenderFillRects(renderer, level->platforms, level->num_platforms);
-
-    // Draw lava with animated effect
-    for (int i = 0; i < level->num_lava; i++) {
-        // Animated lava color
-        Uint8 red = 255;
-        Uint8 green = 50 + (Uint8)(50 * SDL_sin(SDL_GetTicks() * 0.01f + i));
-        SDL_SetRenderDrawColor(renderer, red, green, 0, 255);
-        SDL_RenderFillRect(renderer, &level->lava_squares[i]);
-
-        // Lava particles
-        if (SDL_GetTicks() % 5 == 0) {
-            add_particle(level->lava_squares[i].x + (float)(rand() % (int)level->lava_squares[i].w),
-                       level->lava_squares[i].y,
-                       (float)(rand() % 10 - 5) / 10.0f, -2.0f,
-                       255, 100, 0, 80.0f);
+    // The world is drawn relative to the camera; the snapshot only holds what's in view
+    float camera_x = snapshot->prev_camera.x + (snapshot->camera.x - snapshot->prev_camera.x) * render_alpha;
+    float camera_y = snapshot->prev_camera.y + (snapshot->camera.y - snapshot->prev_camera.y) * render_alpha;
+    quad_batch_set_offset(&quad_batch, -camera_x, -camera_y);
+
+    // Platforms, lava and the goal come baked into tiles; without the cache they are drawn one by one
+    const SDL_FRect *goal = &snapshot->goal;
+    if (tile_cache_draw(&tile_cache, renderer, &quad_batch, snapshot)) {
+        quad_batch_set_texture(&quad_batch, renderer, atlas.texture, atlas.white);
+    } else {
+        for (int i = 0; i < snapshot->num_platforms; i++) {
+            quad_batch_add_rect(&quad_batch, &snapshot->platforms[i], TILE_PLATFORM_COLOR, 255);
+        }
+        for (int i = 0; i < snapshot->num_lava; i++) {
+            quad_batch_add_rect(&quad_batch, &snapshot->lava[i].rect, TILE_LAVA_COLOR, 255);
         }
+        if (snapshot->goal_visible) {
+            quad_batch_add_rect(&quad_batch, goal, TILE_GOAL_COLOR, 255);
+        }
+    }
+
+    // Lava glows brighter and dimmer over its baked colour
+    for (int i = 0; i < snapshot->num_lava; i++) {
+        const SnapshotLava *lava = &snapshot->lava[i];
+        float glow = 0.5f + 0.5f * SDL_sinf(SDL_GetTicks() * 0.01f + lava->index);
+        quad_batch_add_rect(&quad_batch, &lava->rect, 255, 100, 0, (Uint8)(255 * glow));
     }
 
     render_moving_platforms();
     render_collectibles();
 
-    // Draw goal
-    SDL_SetRenderDrawColor(renderer, 255, 215, 0, 255); // Gold
-    SDL_RenderFillRect(renderer, &level->goal);
-
-    // Goal glow effect
-    if (collected_count >= total_collectibles) {
-        SDL_SetRenderDrawColor(renderer, 255, 255, 255, 100);
-        SDL_FRect glow = {level->goal.x - 5, level->goal.y - 5, level->goal.w + 10, level->goal.h + 10};
-        SDL_RenderFillRect(renderer, &glow);
+    if (snapshot->goal_visible) {
+        // Goal glow effect
+        if (snapshot->collected_count >= snapshot->num_collectibles) {
+            SDL_FRect glow = {goal->x - 5, goal->y - 5, goal->w + 10, goal->h + 10};
+            quad_batch_add_rect(&quad_batch, &glow, 255, 255, 255, 100);
+        }
     }
+    profiler_add(&profiler, PROFILE_WORLD, phase_start);
 
-    // Draw player
+    // Draw walkers, then the player on top
+    phase_start = SDL_GetTicksNS();
+    render_walkers();
     render_player();
+    profiler_add(&profiler, PROFILE_PLAYER, phase_start);
 
-    render_particles();
-    render_hud();
-
-    SDL_RenderPresent(renderer);
-
-    // Frame rate limiting
-    Uint64 current_time = SDL_GetTicksNS();
-    Uint64 frame_time = current_time - last_frame_time;
-
-    if (frame_time < TARGET_FRAME_TIME) {
-        Uint64 delay_ns = TARGET_FRAME_TIME - frame_time;
-        SDL_DelayNS(delay_ns);
+    // World, figures and particles all sample the atlas, so they go out in one call
+    phase_start = SDL_GetTicksNS();
+    if (use_gpu_particles) {
+        quad_batch_flush(&quad_batch, renderer);
+        render_gpu_particles(camera_x, camera_y);
+    } else {
+        render_particles();
+        quad_batch_flush(&quad_batch, renderer);
     }
+    quad_batch_set_offset(&quad_batch, 0, 0);
+    profiler_add(&profiler, PROFILE_PARTICLE_DRAW, phase_start);
 
-    last_frame_time = SDL_GetTicksNS();
-
-    return SDL_APP_CONTINUE;
-}
+    phase_start = SDL_GetTicksNS();
+    render_hud();
+    if (show_profiler) {
+        render_profiler();
+    }
+    profiler_add(&profiler, PROFILE_HUD, phase_start);
 
-/* This function runs once at shutdown. */
-void SDL_AppQuit(void *appstate, SDL_AppResult result)
-{
+    phase_start = SDL_GetTicksNS();
+    SDL_RenderPresent(renderer);
+    frame_pacer_presented(&frame_pacer, phase_start);
+    profiler_add(&profiler, PROFILE_PRESENT, phase_start);
 }
 
 // Implementation of helper functions
-void init_particles(void)
+void render_particles(void)
 {
-    for (int i = 0; i < MAX_PARTICLES; i++) {
-        particles[i].active = 0;
+    // Step back along the velocity to where the particle is between ticks
+    float back = (render_alpha - 1.0f) * TICK_DT;
+    for (int i = 0; i < snapshot->num_particles; i++) {
+        const SnapshotParticle *particle = &snapshot->particles[i];
+        Uint32 color = particle->color;
+        quad_batch_add(&quad_batch, particle->x + particle->vx * back - 1, particle->y + particle->vy * back - 1, 2, 2,
+                       (Uint8)color, (Uint8)(color >> 8), (Uint8)(color >> 16), (Uint8)(color >> 24));
     }
 }
 
-void add_particle(float x, float y, float vx, float vy, Uint8 r, Uint8 g, Uint8 b, float life)
+/* Advances the GPU particles to the snapshot's tick, hands over the spawns
+   from the ticks up to it and composites the result over the world. */
+void render_gpu_particles(float camera_x, float camera_y)
 {
-    for (int i = 0; i < MAX_PARTICLES; i++) {
-        if (!particles[i].active) {
-            particles[i].x = x;
-            particles[i].y = y;
-            particles[i].vx = vx;
-            particles[i].vy = vy;
-            particles[i].r = r;
-            particles[i].g = g;
-            particles[i].b = b;
-            particles[i].life = life;
-            particles[i].max_life = life;
-            particles[i].active = 1;
-            break;
-        }
+    SDL_LockMutex(spawn_lock);
+    if (!particle_queue_append(&frame_spawns, &pending_spawns)) {
+        SDL_Log("Out of memory queueing GPU particles, some were dropped");
     }
-}
-
-void update_particles(void)
-{
-    for (int i = 0; i < MAX_PARTICLES; i++) {
-        if (particles[i].active) {
-            particles[i].x += particles[i].vx;
-            particles[i].y += particles[i].vy;
-            particles[i].vy += 0.1f; // Gravity on particles
-            particles[i].life--;
-
-            if (particles[i].life <= 0) {
-                particles[i].active = 0;
-            }
+    SDL_UnlockMutex(spawn_lock);
+
+    // Spawns are in tick order. Each is moved on by the ticks it has lived as of
+    // the snapshot, counting the one it was emitted on as the pool does
+    int ready = 0, kept = 0;
+    while (ready < frame_spawns.count && frame_spawns.ticks[ready] <= snapshot->tick) {
+        ParticleSpawn spawn = frame_spawns.spawns[ready];
+        Uint64 lived = snapshot->tick - frame_spawns.ticks[ready] + 1;
+        particle_spawn_advance(&spawn, (int)SDL_min(lived, (Uint64)GPU_PARTICLE_MAX_STEPS), TICK_DT, PARTICLE_GRAVITY);
+        if (spawn.life > 0.0f) {
+            frame_spawns.spawns[kept++] = spawn;
         }
+        ready++;
     }
-}
 
-void render_particles(void)
-{
-    for (int i = 0; i < MAX_PARTICLES; i++) {
-        if (particles[i].active) {
-            float alpha = particles[i].life / particles[i].max_life;
-            SDL_SetRenderDrawColor(renderer, particles[i].r, particles[i].g, particles[i].b,
-                                 (Uint8)(255 * alpha));
-            SDL_FRect rect = {particles[i].x - 1, particles[i].y - 1, 2, 2};
-            SDL_RenderFillRect(renderer, &rect);
-        }
+    int steps = (int)SDL_min(snapshot->tick - gpu_particle_tick, (Uint64)GPU_PARTICLE_MAX_STEPS);
+    gpu_particle_tick = snapshot->tick;
+    if (gpu_particles_render(&gpu_particles, renderer, frame_spawns.spawns, kept, steps,
+                             PARTICLE_GRAVITY, (SDL_FPoint){camera_x, camera_y})) {
+        SDL_RenderTexture(renderer, gpu_particles.target, NULL, NULL);
     }
+    particle_queue_remove_front(&frame_spawns, ready);
 }
 
-void init_levels(void)
+void render_collectibles(void)
 {
-    // Level 0 - Tutorial
-    levels[0].num_platforms = 6;
-    levels[0].platforms[0] = (SDL_FRect){0, h-50, 300, 50}; // Ground
-    levels[0].platforms[1] = (SDL_FRect){400, h-150, 200, 30};
-    levels[0].platforms[2] = (SDL_FRect){700, h-250, 200, 30};
-    levels[0].platforms[3] = (SDL_FRect){1000, h-200, 200, 30};
-    levels[0].platforms[4] = (SDL_FRect){350, h-350, 100, 30};
-    levels[0].platforms[5] = (SDL_FRect){900, h-400, 100, 30};
-
-    levels[0].num_lava = 2;
-    levels[0].lava_squares[0] = (SDL_FRect){300, h-45, 100, 50};
-    levels[0].lava_squares[1] = (SDL_FRect){600, h-45, 100, 50};
-
-    levels[0].start_pos = (SDL_FRect){50, h-150, 50, 50};
-    levels[0].goal = (SDL_FRect){w-100, h-300, 50, 50};
-
-    levels[0].num_collectibles = 3;
-    levels[0].level_collectibles[0] = (Collectible){{450, h-200, 20, 20}, 0, 0};
-    levels[0].level_collectibles[1] = (Collectible){{750, h-300, 20, 20}, 0, 0};
-    levels[0].level_collectibles[2] = (Collectible){{950, h-450, 20, 20}, 0, 0};
-
-    levels[0].num_moving = 1;
-    levels[0].level_moving_platforms[0] = (MovingPlatform){{500, h-300, 100, 20}, 1, 0, 500, 800, 0, 0, 1};
-
-    // Level 1 - Intermediate
-    levels[1].num_platforms = 8;
-    levels[1].platforms[0] = (SDL_FRect){0, h-50, 200, 50};
-    levels[1].platforms[1] = (SDL_FRect){300, h-150, 150, 30};
-    levels[1].platforms[2] = (SDL_FRect){550, h-280, 100, 30};
-    levels[1].platforms[3] = (SDL_FRect){750, h-200, 150, 30};
-    levels[1].platforms[4] = (SDL_FRect){1000, h-350, 100, 30};
-    levels[1].platforms[5] = (SDL_FRect){200, h-400, 100, 30};
-    levels[1].platforms[6] = (SDL_FRect){400, h-500, 200, 30};
-    levels[1].platforms[7] = (SDL_FRect){w-200, h-100, 200, 50};
-
-    levels[1].num_lava = 3;
-    levels[1].lava_squares[0] = (SDL_FRect){200, h-45, 100, 45};
-    levels[1].lava_squares[1] = (SDL_FRect){450, h-45, 300, 45};
-    levels[1].lava_squares[2] = (SDL_FRect){900, h-45, 100, 45};
-
-    levels[1].start_pos = (SDL_FRect){50, h-150, 50, 50};
-    levels[1].goal = (SDL_FRect){w-150, h-200, 50, 50};
-
-    levels[1].num_collectibles = 4;
-    levels[1].level_collectibles[0] = (Collectible){{350, h-200, 20, 20}, 0, 0};
-    levels[1].level_collectibles[1] = (Collectible){{575, h-330, 20, 20}, 0, 0};
-    levels[1].level_collectibles[2] = (Collectible){{1050, h-400, 20, 20}, 0, 0};
-    levels[1].level_collectibles[3] = (Collectible){{500, h-550, 20, 20}, 0, 0};
-
-    levels[1].num_moving = 2;
-    levels[1].level_moving_platforms[0] = (MovingPlatform){{650, h-350, 80, 20}, 0, -1, 0, 0, h-450, h-250, 1};
-    levels[1].level_moving_platforms[1] = (MovingPlatform){{800, h-400, 100, 20}, 1, 0, 800, 950, 0, 0, 1};
-
-    // Level 2 - Advanced
-    levels[2].num_platforms = 10;
-    levels[2].platforms[0] = (SDL_FRect){0, h-50, 150, 50};
-    levels[2].platforms[1] = (SDL_FRect){250, h-150, 100, 30};
-    levels[2].platforms[2] = (SDL_FRect){450, h-250, 80, 30};
-    levels[2].platforms[3] = (SDL_FRect){600, h-180, 100, 30};
-    levels[2].platforms[4] = (SDL_FRect){800, h-320, 80, 30};
-    levels[2].platforms[5] = (SDL_FRect){950, h-250, 100, 30};
-    levels[2].platforms[6] = (SDL_FRect){200, h-450, 100, 30};
-    levels[2].platforms[7] = (SDL_FRect){400, h-550, 150, 30};
-    levels[2].platforms[8] = (SDL_FRect){700, h-480, 100, 30};
-    levels[2].platforms[9] = (SDL_FRect){w-150, h-100, 150, 50};
-
-    levels[2].num_lava = 4;
-    levels[2].lava_squares[0] = (SDL_FRect){150, h-45, 100, 45};
-    levels[2].lava_squares[1] = (SDL_FRect){350, h-45, 100, 45};
-    levels[2].lava_squares[2] = (SDL_FRect){700, h-45, 250, 45};
-    levels[2].lava_squares[3] = (SDL_FRect){550, h-245, 50, 70};
-
-    levels[2].start_pos = (SDL_FRect){50, h-150, 50, 50};
-    levels[2].goal = (SDL_FRect){w-100, h-200, 50, 50};
-
-    levels[2].num_collectibles = 5;
-    levels[2].level_collectibles[0] = (Collectible){{275, h-200, 20, 20}, 0, 0};
-    levels[2].level_collectibles[1] = (Collectible){{475, h-300, 20, 20}, 0, 0};
-    levels[2].level_collectibles[2] = (Collectible){{825, h-370, 20, 20}, 0, 0};
-    levels[2].level_collectibles[3] = (Collectible){{475, h-600, 20, 20}, 0, 0};
-    levels[2].level_collectibles[4] = (Collectible){{725, h-530, 20, 20}, 0, 0};
-
-    levels[2].num_moving = 3;
-    levels[2].level_moving_platforms[0] = (MovingPlatform){{300, h-350, 80, 20}, 1, 0, 300, 500, 0, 0, 1};
-    levels[2].level_moving_platforms[1] = (MovingPlatform){{600, h-400, 80, 20}, 0, -1, 0, 0, h-500, h-300, 1};
-    levels[2].level_moving_platforms[2] = (MovingPlatform){{850, h-150, 100, 20}, 1, 0, 850, 1000, 0, 0, 1};
-
-    // Level 3 - Vertical Challenge
-    levels[3].num_platforms = 12;
-    levels[3].platforms[0] = (SDL_FRect){0, h-50, 100, 50}; // Small starting platform
-    levels[3].platforms[1] = (SDL_FRect){200, h-150, 80, 20};
-    levels[3].platforms[2] = (SDL_FRect){350, h-250, 80, 20};
-    levels[3].platforms[3] = (SDL_FRect){150, h-350, 80, 20};
-    levels[3].platforms[4] = (SDL_FRect){400, h-450, 80, 20};
-    levels[3].platforms[5] = (SDL_FRect){250, h-550, 80, 20};
-    levels[3].platforms[6] = (SDL_FRect){500, h-650, 80, 20};
-    levels[3].platforms[7] = (SDL_FRect){700, h-600, 100, 20};
-    levels[3].platforms[8] = (SDL_FRect){900, h-500, 80, 20};
-    levels[3].platforms[9] = (SDL_FRect){1050, h-400, 80, 20};
-    levels[3].platforms[10] = (SDL_FRect){850, h-300, 100, 20};
-    levels[3].platforms[11] = (SDL_FRect){w-150, h-200, 150, 50};
-
-    levels[3].num_lava = 5;
-    levels[3].lava_squares[0] = (SDL_FRect){100, h-45, 100, 45};
-    levels[3].lava_squares[1] = (SDL_FRect){300, h-45, 200, 45};
-    levels[3].lava_squares[2] = (SDL_FRect){600, h-45, 300, 45};
-    levels[3].lava_squares[3] = (SDL_FRect){450, h-345, 50, 95};
-    levels[3].lava_squares[4] = (SDL_FRect){750, h-445, 50, 145};
-
-    levels[3].start_pos = (SDL_FRect){25, h-150, 40, 40};
-    levels[3].goal = (SDL_FRect){w-100, h-300, 50, 50};
-
-    levels[3].num_collectibles = 6;
-    levels[3].level_collectibles[0] = (Collectible){{225, h-200, 20, 20}, 0, 0};
-    levels[3].level_collectibles[1] = (Collectible){{375, h-300, 20, 20}, 0, 0};
-    levels[3].level_collectibles[2] = (Collectible){{275, h-600, 20, 20}, 0, 0};
-    levels[3].level_collectibles[3] = (Collectible){{525, h-700, 20, 20}, 0, 0};
-    levels[3].level_collectibles[4] = (Collectible){{925, h-550, 20, 20}, 0, 0};
-    levels[3].level_collectibles[5] = (Collectible){{875, h-350, 20, 20}, 0, 0};
-
-    levels[3].num_moving = 2;
-    levels[3].level_moving_platforms[0] = (MovingPlatform){{600, h-350, 80, 20}, 0, -2, 0, 0, h-550, h-250, 1};
-    levels[3].level_moving_platforms[1] = (MovingPlatform){{800, h-400, 80, 20}, 1, 0, 800, 950, 0, 0, 1};
-
-    // Level 4 - Speed Run
-    levels[4].num_platforms = 15;
-    levels[4].platforms[0] = (SDL_FRect){0, h-50, 150, 50};
-    levels[4].platforms[1] = (SDL_FRect){250, h-120, 60, 20};
-    levels[4].platforms[2] = (SDL_FRect){400, h-180, 60, 20};
-    levels[4].platforms[3] = (SDL_FRect){550, h-120, 60, 20};
-    levels[4].platforms[4] = (SDL_FRect){700, h-200, 60, 20};
-    levels[4].platforms[5] = (SDL_FRect){850, h-150, 60, 20};
-    levels[4].platforms[6] = (SDL_FRect){1000, h-250, 60, 20};
-    levels[4].platforms[7] = (SDL_FRect){900, h-350, 80, 20};
-    levels[4].platforms[8] = (SDL_FRect){700, h-450, 80, 20};
-    levels[4].platforms[9] = (SDL_FRect){500, h-350, 80, 20};
-    levels[4].platforms[10] = (SDL_FRect){300, h-450, 80, 20};
-    levels[4].platforms[11] = (SDL_FRect){100, h-350, 80, 20};
-    levels[4].platforms[12] = (SDL_FRect){200, h-550, 100, 20};
-    levels[4].platforms[13] = (SDL_FRect){400, h-650, 100, 20};
-    levels[4].platforms[14] = (SDL_FRect){w-200, h-100, 200, 50};
-
-    levels[4].num_lava = 4;
-    levels[4].lava_squares[0] = (SDL_FRect){150, h-45, 100, 50};
-    levels[4].lava_squares[1] = (SDL_FRect){310, h-45, 240, 50};
-    levels[4].lava_squares[2] = (SDL_FRect){610, h-45, 240, 50};
-    levels[4].lava_squares[3] = (SDL_FRect){380, h-345, 120, 100};
-
-    levels[4].start_pos = (SDL_FRect){50, h-150, 40, 40};
-    levels[4].goal = (SDL_FRect){w-150, h-200, 50, 50};
-
-    levels[4].num_collectibles = 7;
-    levels[4].level_collectibles[0] = (Collectible){{275, h-170, 20, 20}, 0, 0};
-    levels[4].level_collectibles[1] = (Collectible){{575, h-170, 20, 20}, 0, 0};
-    levels[4].level_collectibles[2] = (Collectible){{875, h-200, 20, 20}, 0, 0};
-    levels[4].level_collectibles[3] = (Collectible){{925, h-400, 20, 20}, 0, 0};
-    levels[4].level_collectibles[4] = (Collectible){{325, h-500, 20, 20}, 0, 0};
-    levels[4].level_collectibles[5] = (Collectible){{225, h-600, 20, 20}, 0, 0};
-    levels[4].level_collectibles[6] = (Collectible){{425, h-700, 20, 20}, 0, 0};
-
-    levels[4].num_moving = 4;
-    levels[4].level_moving_platforms[0] = (MovingPlatform){{600, h-300, 60, 20}, 1, 0, 600, 750, 0, 0, 1};
-    levels[4].level_moving_platforms[1] = (MovingPlatform){{150, h-250, 60, 20}, 0, -2, 0, 0, h-400, h-200, 1};
-    levels[4].level_moving_platforms[2] = (MovingPlatform){{750, h-350, 60, 20}, 1, 0, 750, 900, 0, 0, 1};
-    levels[4].level_moving_platforms[3] = (MovingPlatform){{300, h-200, 60, 20}, 2, 0, 300, 500, 0, 0, 1};
-
-    // Level 5 - The Gauntlet (Final Challenge)
-    levels[5].num_platforms = 20;
-    levels[5].platforms[0] = (SDL_FRect){0, h-50, 120, 50};
-    levels[5].platforms[1] = (SDL_FRect){180, h-150, 60, 20};
-    levels[5].platforms[2] = (SDL_FRect){300, h-200, 40, 20};
-    levels[5].platforms[3] = (SDL_FRect){400, h-150, 40, 20};
-    levels[5].platforms[4] = (SDL_FRect){500, h-250, 60, 20};
-    levels[5].platforms[5] = (SDL_FRect){620, h-180, 40, 20};
-    levels[5].platforms[6] = (SDL_FRect){720, h-300, 60, 20};
-    levels[5].platforms[7] = (SDL_FRect){840, h-220, 40, 20};
-    levels[5].platforms[8] = (SDL_FRect){940, h-350, 60, 20};
-    levels[5].platforms[9] = (SDL_FRect){1050, h-280, 40, 20};
-    levels[5].platforms[10] = (SDL_FRect){950, h-450, 80, 20};
-    levels[5].platforms[11] = (SDL_FRect){800, h-550, 60, 20};
-    levels[5].platforms[12] = (SDL_FRect){650, h-450, 60, 20};
-    levels[5].platforms[13] = (SDL_FRect){500, h-550, 60, 20};
-    levels[5].platforms[14] = (SDL_FRect){350, h-450, 60, 20};
-    levels[5].platforms[15] = (SDL_FRect){200, h-550, 60, 20};
-    levels[5].platforms[16] = (SDL_FRect){100, h-650, 80, 20};
-    levels[5].platforms[17] = (SDL_FRect){300, h-700, 100, 20};
-    levels[5].platforms[18] = (SDL_FRect){500, h-750, 80, 20};
-    levels[5].platforms[19] = (SDL_FRect){w-150, h-150, 150, 50};
-
-    levels[5].num_lava = 5;
-    levels[5].lava_squares[0] = (SDL_FRect){120, h-45, 60, 50};
-    levels[5].lava_squares[1] = (SDL_FRect){240, h-45, 160, 50};
-    levels[5].lava_squares[2] = (SDL_FRect){440, h-45, 180, 50};
-    levels[5].lava_squares[3] = (SDL_FRect){660, h-45, 280, 50};
-    levels[5].lava_squares[4] = (SDL_FRect){780, h-395, 60, 150};
-
-    levels[5].start_pos = (SDL_FRect){25, h-150, 40, 40};
-    levels[5].goal = (SDL_FRect){w-100, h-250, 50, 50};
-
-    levels[5].num_collectibles = 8;
-    levels[5].level_collectibles[0] = (Collectible){{205, h-200, 20, 20}, 0, 0};
-    levels[5].level_collectibles[1] = (Collectible){{525, h-300, 20, 20}, 0, 0};
-    levels[5].level_collectibles[2] = (Collectible){{745, h-350, 20, 20}, 0, 0};
-    levels[5].level_collectibles[3] = (Collectible){{975, h-500, 20, 20}, 0, 0};
-    levels[5].level_collectibles[4] = (Collectible){{675, h-500, 20, 20}, 0, 0};
-    levels[5].level_collectibles[5] = (Collectible){{225, h-600, 20, 20}, 0, 0};
-    levels[5].level_collectibles[6] = (Collectible){{325, h-750, 20, 20}, 0, 0};
-    levels[5].level_collectibles[7] = (Collectible){{525, h-800, 20, 20}, 0, 0};
-
-    levels[5].num_moving = 5;
-    levels[5].level_moving_platforms[0] = (MovingPlatform){{250, h-300, 50, 20}, 1, 0, 250, 350, 0, 0, 1};
-    levels[5].level_moving_platforms[1] = (MovingPlatform){{450, h-350, 50, 20}, 0, -1, 0, 0, h-500, h-300, 1};
-    levels[5].level_moving_platforms[2] = (MovingPlatform){{600, h-350, 50, 20}, 1, 0, 600, 700, 0, 0, 1};
-    levels[5].level_moving_platforms[3] = (MovingPlatform){{400, h-600, 60, 20}, 2, 0, 400, 550, 0, 0, 1};
-    levels[5].level_moving_platforms[4] = (MovingPlatform){{200, h-400, 50, 20}, 0, -2, 0, 0, h-600, h-350, 1};
+    // Only uncollected gems are in the snapshot, already bobbed
+    for (int i = 0; i < snapshot->num_gems; i++) {
+        const SDL_FRect *gem = &snapshot->gems[i];
+        quad_batch_add_rect(&quad_batch, gem, 255, 255, 0, 255); // Yellow
+
+        // Glow effect
+        SDL_FRect glow = {gem->x - 2, gem->y - 2, gem->w + 4, gem->h + 4};
+        quad_batch_add_rect(&quad_batch, &glow, 255, 255, 200, 100);
+    }
 }
 
-void load_level(int level_num)
+void render_moving_platforms(void)
 {
-    if (level_num >= MAX_LEVELS) return;
-
-    Level *level = &levels[level_num];
-
-    // Copy collectibles
-    total_collectibles = level->num_collectibles;
-    collected_count = 0;
-    for (int i = 0; i < level->num_collectibles; i++) {
-        collectibles[i] = level->level_collectibles[i];
-        collectibles[i].collected = 0;
-        collectibles[i].bob_offset = (float)(rand() % 100) / 100.0f * 6.28f;
-    }
-
-    // Copy moving platforms
-    num_moving_platforms = level->num_moving;
-    for (int i = 0; i < level->num_moving; i++) {
-        moving_platforms[i] = level->level_moving_platforms[i];
+    for (int i = 0; i < snapshot->num_movers; i++) {
+        SDL_FRect rect = interpolate_rect(snapshot->prev_movers[i], snapshot->movers[i]);
+        quad_batch_add_rect(&quad_batch, &rect, 150, 100, 200, 255); // Purple
     }
-
-    // Give double jump power-up on level 1+
-    has_double_jump = (level_num > 0);
 }
 
-void reset_player(void)
+SDL_FRect interpolate_rect(SDL_FRect prev, SDL_FRect cur)
 {
-    Level *level = &levels[current_level];
-    player.x = level->start_pos.x;
-    player.y = level->start_pos.y;
-    player.w = 24; // Adjusted to match stick figure width
-    player.h = 40; // Keep same height
-    player_vy = 0;
-         player_rotation = 0;
-    is_on_ground = 0;
-    coyote_timer = 0;
-    jump_buffer = 0;
-    jump_held = 0;
-    double_jump_used = 0;
-    invincibility_timer = 0;
+    SDL_FRect rect = cur;
+    rect.x = prev.x + (cur.x - prev.x) * render_alpha;
+    rect.y = prev.y + (cur.y - prev.y) * render_alpha;
+    return rect;
 }
 
-void update_collectibles(void)
+/* Composites the cached HUD, redrawing it first if anything on it has changed. */
+void render_hud(void)
 {
-    for (int i = 0; i < total_collectibles; i++) {
-        if (!collectibles[i].collected) {
-            collectibles[i].bob_offset += 0.1f;
-
-            // Check collision with player
-            if (is_colliding(player, collectibles[i].rect)) {
-                collectibles[i].collected = 1;
-                collected_count++;
-                score += 100;
-
-                // Collection particles
-                for (int j = 0; j < 10; j++) {
-                    add_particle(collectibles[i].rect.x + collectibles[i].rect.w/2,
-                               collectibles[i].rect.y + collectibles[i].rect.h/2,
-                               (float)(rand() % 20 - 10) / 5.0f,
-                               (float)(rand() % 20 - 10) / 5.0f,
-                               255, 255, 0, 50.0f);
-                }
-            }
-        }
+    HudState state;
+    SDL_zero(state);
+    SDL_GetRenderOutputSize(renderer, &state.out_w, &state.out_h);
+    if (state.out_w <= 0 || state.out_h <= 0) {
+        return;
     }
-}
-
-void render_collectibles(void)
-{
-    for (int i = 0; i < total_collectibles; i++) {
-        if (!collectibles[i].collected) {
-            // Bobbing animation
-            float bob = SDL_sin(collectibles[i].bob_offset) * 5.0f;
-            SDL_FRect bobbing_rect = {
-                collectibles[i].rect.x,
-                collectibles[i].rect.y + bob,
-                collectibles[i].rect.w,
-                collectibles[i].rect.h
-            };
-
-            SDL_SetRenderDrawColor(renderer, 255, 255, 0, 255); // Yellow
-            SDL_RenderFillRect(renderer, &bobbing_rect);
-
-            // Glow effect
-            SDL_SetRenderDrawColor(renderer, 255, 255, 200, 100);
-            SDL_FRect glow = {bobbing_rect.x - 2, bobbing_rect.y - 2,
-                            bobbing_rect.w + 4, bobbing_rect.h + 4};
-            SDL_RenderFillRect(renderer, &glow);
-        }
+    state.score = snapshot->score;
+    state.lives = snapshot->lives;
+    state.level = snapshot->current_level;
+    state.collected = snapshot->collected_count;
+    state.num_collectibles = snapshot->num_collectibles;
+    state.timer_seconds = (int)snapshot->global_timer;
+    state.timer_urgency = snapshot->global_timer <= 60.0f ? 2 : snapshot->global_timer <= 180.0f ? 1 : 0;
+    state.time_up = snapshot->global_timer <= 0;
+    state.has_double_jump = snapshot->has_double_jump;
+    state.game_over = snapshot->game_over;
+    state.game_won = snapshot->game_won;
+
+    if (hud_texture && SDL_memcmp(&state, &hud_state, sizeof(state)) == 0) {
+        SDL_RenderTexture(renderer, hud_texture, NULL, NULL);
+        return;
     }
-}
-
-void update_moving_platforms(void)
-{
-    for (int i = 0; i < num_moving_platforms; i++) {
-        MovingPlatform *platform = &moving_platforms[i];
-
-        platform->rect.x += platform->vx;
-        platform->rect.y += platform->vy;
 
-        // Horizontal movement bounds
-        if (platform->vx != 0) {
-            if (platform->rect.x <= platform->start_x || platform->rect.x >= platform->end_x) {
-                platform->vx = -platform->vx;
-            }
+    if (!hud_texture || state.out_w != hud_state.out_w || state.out_h != hud_state.out_h) {
+        if (hud_texture) {
+            SDL_DestroyTexture(hud_texture);
         }
-
-        // Vertical movement bounds
-        if (platform->vy != 0) {
-            if (platform->rect.y <= platform->start_y || platform->rect.y >= platform->end_y) {
-                platform->vy = -platform->vy;
-            }
+        hud_texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_TARGET,
+                                        state.out_w, state.out_h);
+        if (!hud_texture) {
+            // Still show the HUD, just without the cache
+            draw_hud();
+            return;
         }
+        // Drawing blended onto transparent leaves the colours premultiplied
+        SDL_SetTextureBlendMode(hud_texture, SDL_BLENDMODE_BLEND_PREMULTIPLIED);
+        SDL_SetTextureScaleMode(hud_texture, SDL_SCALEMODE_NEAREST);
     }
-}
 
-void render_moving_platforms(void)
-{
-    SDL_SetRenderDrawColor(renderer, 150, 100, 200, 255); // Purple
-    for (int i = 0; i < num_moving_platforms; i++) {
-        SDL_RenderFillRect(renderer, &moving_platforms[i].rect);
-    }
-}
+    SDL_SetRenderTarget(renderer, hud_texture);
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+    SDL_RenderClear(renderer);
+    draw_hud();
+    SDL_SetRenderTarget(renderer, NULL);
+    hud_state = state;
 
-int is_colliding(SDL_FRect a, SDL_FRect b)
-{
-    return (a.x < b.x + b.w && a.x + a.w > b.x && a.y < b.y + b.h && a.y + a.h > b.y);
+    SDL_RenderTexture(renderer, hud_texture, NULL, NULL);
 }
 
-void render_hud(void)
+/* Draws the HUD to the current render target. */
+void draw_hud(void)
 {
     SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
 
     // Score
     char score_text[64];
-    SDL_snprintf(score_text, sizeof(score_text), "Score: %d", score);
+    SDL_snprintf(score_text, sizeof(score_text), "Score: %d", snapshot->score);
     SDL_RenderDebugText(renderer, 10, 10, score_text);
 
     // Lives
     char lives_text[32];
-    SDL_snprintf(lives_text, sizeof(lives_text), "Lives: %d", lives);
+    SDL_snprintf(lives_text, sizeof(lives_text), "Lives: %d", snapshot->lives);
     SDL_RenderDebugText(renderer, 10, 30, lives_text);
 
     // Level
     char level_text[32];
-    SDL_snprintf(level_text, sizeof(level_text), "Level: %d", current_level + 1);
+    SDL_snprintf(level_text, sizeof(level_text), "Level: %d", snapshot->current_level + 1);
     SDL_RenderDebugText(renderer, 10, 50, level_text);
 
     // Collectibles
     char collectible_text[64];
-    SDL_snprintf(collectible_text, sizeof(collectible_text), "Gems: %d/%d", collected_count, total_collectibles);
+    SDL_snprintf(collectible_text, sizeof(collectible_text), "Gems: %d/%d", snapshot->collected_count, snapshot->num_collectibles);
     SDL_RenderDebugText(renderer, 10, 70, collectible_text);
 
         // Global Timer - Make it prominent in the top right
     char timer_text[32];
-    int minutes = (int)(global_timer / 60.0f);
-    int seconds = (int)(global_timer) % 60;
+    int minutes = (int)(snapshot->global_timer / 60.0f);
+    int seconds = (int)(snapshot->global_timer) % 60;
     SDL_snprintf(timer_text, sizeof(timer_text), "TIME: %02d:%02d", minutes, seconds);
 
                 // Position timer prominently at top right corner
@@ -934,34 +759,38 @@ void render_hud(void)
 
     // Draw background box for timer - sized for 2x scaled text
     SDL_FRect timer_bg = {timer_x, timer_y - 15, 200, 60};
-    if (global_timer <= 60.0f) {
-        SDL_SetRenderDrawColor(renderer, 180, 0, 0, 200); // Dark red background when critical (1 minute left)
-    } else if (global_timer <= 180.0f) {
-        SDL_SetRenderDrawColor(renderer, 180, 140, 0, 200); // Dark yellow background when low (3 minutes left)
+    if (snapshot->global_timer <= 60.0f) {
+        quad_batch_add_rect(&quad_batch, &timer_bg, 180, 0, 0, 200); // Dark red background when critical (1 minute left)
+    } else if (snapshot->global_timer <= 180.0f) {
+        quad_batch_add_rect(&quad_batch, &timer_bg, 180, 140, 0, 200); // Dark yellow background when low (3 minutes left)
     } else {
-        SDL_SetRenderDrawColor(renderer, 0, 0, 0, 150); // Dark background when plenty
+        quad_batch_add_rect(&quad_batch, &timer_bg, 0, 0, 0, 150); // Dark background when plenty
     }
-    SDL_RenderFillRect(renderer, &timer_bg);
 
     // Draw thick border around timer
-    if (global_timer <= 60.0f) {
-        SDL_SetRenderDrawColor(renderer, 255, 0, 0, 255); // Bright red border when critical
-    } else if (global_timer <= 180.0f) {
-        SDL_SetRenderDrawColor(renderer, 255, 200, 0, 255); // Bright yellow border when low
-    } else {
-        SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255); // White border when plenty
+    Uint8 border_r = 255, border_g = 255, border_b = 255; // White border when plenty
+    if (snapshot->global_timer <= 60.0f) {
+        border_g = 0; // Bright red border when critical
+        border_b = 0;
+    } else if (snapshot->global_timer <= 180.0f) {
+        border_g = 200; // Bright yellow border when low
+        border_b = 0;
     }
-    // Draw multiple rectangles for thick border effect
-    SDL_RenderRect(renderer, &timer_bg);
-    SDL_FRect timer_border2 = {timer_bg.x - 1, timer_bg.y - 1, timer_bg.w + 2, timer_bg.h + 2};
-    SDL_RenderRect(renderer, &timer_border2);
-    SDL_FRect timer_border3 = {timer_bg.x - 2, timer_bg.y - 2, timer_bg.w + 4, timer_bg.h + 4};
-    SDL_RenderRect(renderer, &timer_border3);
+    // Three nested one pixel outlines for thick border effect, as edge quads in the same batch
+    for (int i = 0; i < 3; i++) {
+        float bx = timer_bg.x - i, by = timer_bg.y - i;
+        float bw = timer_bg.w + i * 2, bh = timer_bg.h + i * 2;
+        quad_batch_add(&quad_batch, bx, by, bw, 1, border_r, border_g, border_b, 255);
+        quad_batch_add(&quad_batch, bx, by + bh - 1, bw, 1, border_r, border_g, border_b, 255);
+        quad_batch_add(&quad_batch, bx, by + 1, 1, bh - 2, border_r, border_g, border_b, 255);
+        quad_batch_add(&quad_batch, bx + bw - 1, by + 1, 1, bh - 2, border_r, border_g, border_b, 255);
+    }
+    quad_batch_flush(&quad_batch, renderer);
 
     // Change text color based on remaining time
-    if (global_timer <= 60.0f) {
+    if (snapshot->global_timer <= 60.0f) {
         SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255); // White text on red background
-    } else if (global_timer <= 180.0f) {
+    } else if (snapshot->global_timer <= 180.0f) {
         SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255); // White text on yellow background
     } else {
         SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255); // White text
@@ -989,22 +818,22 @@ void render_hud(void)
     SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255); // Reset color
 
     // Power-ups
-    if (has_double_jump) {
+    if (snapshot->has_double_jump) {
         SDL_RenderDebugText(renderer, 10, 110, "Double Jump: ON");
     }
 
     // Instructions
-    if (game_over) {
+    if (snapshot->game_over) {
         SDL_SetRenderDrawColor(renderer, 255, 100, 100, 255);
         SDL_RenderDebugText(renderer, w/2 - 100, h/2 - 50, "GAME OVER");
         SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
-        if (global_timer <= 0) {
+        if (snapshot->global_timer <= 0) {
             SDL_RenderDebugText(renderer, w/2 - 60, h/2 - 30, "TIME'S UP!");
         }
         SDL_RenderDebugText(renderer, w/2 - 80, h/2 - 20, "Press R to restart");
-    } else if (game_won) {
+    } else if (snapshot->game_won) {
         SDL_SetRenderDrawColor(renderer, 100, 255, 100, 255);
-        if (current_level < MAX_LEVELS - 1) {
+        if (snapshot->current_level < MAX_LEVELS - 1) {
             SDL_RenderDebugText(renderer, w/2 - 80, h/2 - 50, "LEVEL COMPLETE!");
             SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
             SDL_RenderDebugText(renderer, w/2 - 100, h/2 - 20, "Press N for next level");
@@ -1019,121 +848,132 @@ void render_hud(void)
         SDL_RenderDebugText(renderer, w - 300, 100, "Controls:");
         SDL_RenderDebugText(renderer, w - 300, 120, "Arrow Keys / WASD: Move");
         SDL_RenderDebugText(renderer, w - 300, 140, "Space / Up: Jump");
-        if (has_double_jump) {
+        if (snapshot->has_double_jump) {
             SDL_RenderDebugText(renderer, w - 300, 160, "Double Jump Available!");
         }
         SDL_RenderDebugText(renderer, w - 300, 180, "Collect all gems to win!");
     }
 }
 
-void render_background(void)
+/* Draws the profiler overlay: per-phase averages, frame time percentiles, draw calls and frame pacing over the last PROFILE_HISTORY frames. */
+void render_profiler(void)
 {
-    // Gradient background
-    for (int y = 0; y < h; y++) {
-        float ratio = (float)y / h;
-        Uint8 r = (Uint8)(20 + ratio * 60);
-        Uint8 g = (Uint8)(30 + ratio * 80);
-        Uint8 b = (Uint8)(60 + ratio * 120);
-        SDL_SetRenderDrawColor(renderer, r, g, b, 255);
-        SDL_RenderLine(renderer, 0, y, w, y);
+    float x = 10, y = 140;
+    SDL_FRect panel = {x - 5, y - 5, 290, 76 + PROFILE_PHASE_COUNT * 12};
+    quad_batch_add_rect(&quad_batch, &panel, 0, 0, 0, 180);
+    quad_batch_flush(&quad_batch, renderer);
+
+    char text[64];
+    SDL_SetRenderDrawColor(renderer, 255, 255, 0, 255);
+    SDL_snprintf(text, sizeof(text), "Frame p50 %.2f ms  p99 %.2f ms",
+                 profiler_frame_percentile(&profiler, 50) / 1e6, profiler_frame_percentile(&profiler, 99) / 1e6);
+    SDL_RenderDebugText(renderer, x, y, text);
+    SDL_snprintf(text, sizeof(text), "Batched draw calls: %d", profiler_draw_calls_average(&profiler));
+    SDL_RenderDebugText(renderer, x, y + 12, text);
+
+    SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
+    for (int phase = 0; phase < PROFILE_PHASE_COUNT; phase++) {
+        SDL_snprintf(text, sizeof(text), "%-14s %6.3f ms", profiler_phase_name((ProfilePhase)phase),
+                     profiler_phase_average(&profiler, (ProfilePhase)phase) / 1e6);
+        SDL_RenderDebugText(renderer, x, y + 30 + phase * 12, text);
+    }
+    SDL_snprintf(text, sizeof(text), "Particle detail: %d%%", SDL_GetAtomicInt(&particle_detail) / 10);
+    SDL_RenderDebugText(renderer, x, y + 30 + PROFILE_PHASE_COUNT * 12, text);
+
+    // Pacing: how evenly frames start, against the target period where there is one
+    if (frame_pacer.target_hz == PACING_UNCAPPED) {
+        SDL_snprintf(text, sizeof(text), "uncapped  present %.2f ms", frame_pacer.present_ns / 1e6);
+    } else {
+        SDL_snprintf(text, sizeof(text), "%s %d Hz  present %.2f ms", frame_pacer_mode(&frame_pacer),
+                     frame_pacer.target_hz, frame_pacer.present_ns / 1e6);
     }
+    SDL_RenderDebugText(renderer, x, y + 42 + PROFILE_PHASE_COUNT * 12, text);
+    SDL_snprintf(text, sizeof(text), "Interval p99 %.2f  jitter %.3f ms", profiler_interval_percentile(&profiler, 99) / 1e6,
+                 profiler_interval_jitter(&profiler, frame_pacer.period_ns) / 1e6);
+    SDL_RenderDebugText(renderer, x, y + 54 + PROFILE_PHASE_COUNT * 12, text);
 }
 
-void render_player(void)
+void render_background(void)
 {
-    // Skip rendering if flashing during invincibility
-    if (invincibility_timer > 0 && ((int)invincibility_timer / 5) % 2) {
+    int out_w = 0, out_h = 0;
+    SDL_GetRenderOutputSize(renderer, &out_w, &out_h);
+    if (out_w <= 0 || out_h <= 0) {
         return;
     }
 
-    float center_x = player.x + player.w / 2.0f;
-    float center_y = player.y + player.h / 2.0f;
-
-    // Player color
-    SDL_SetRenderDrawColor(renderer, 255, 50, 50, 255);
-
-    if (game_over) {
-        // Spinning death animation - render as rotated stick figure
-        float angle_rad = player_rotation * (3.14159f / 180.0f);
-        float cos_a = SDL_cosf(angle_rad);
-        float sin_a = SDL_sinf(angle_rad);
-
-        // Define fat stick figure points relative to center
-        float head_x = 0, head_y = -16;
-        float body_left_x = -8, body_left_y = -2;
-        float body_right_x = 8, body_right_y = -2;
-        float left_arm_x = -12, left_arm_y = 2;
-        float right_arm_x = 12, right_arm_y = 2;
-        float left_leg_x = -6, left_leg_y = 17;
-        float right_leg_x = 6, right_leg_y = 17;
-
-        // Rotate all points
-        float rotated_points[7][2];
-        float original_points[7][2] = {
-            {head_x, head_y}, {body_left_x, body_left_y}, {body_right_x, body_right_y},
-            {left_arm_x, left_arm_y}, {right_arm_x, right_arm_y},
-            {left_leg_x, left_leg_y}, {right_leg_x, right_leg_y}
-        };
-
-        for (int i = 0; i < 7; i++) {
-            rotated_points[i][0] = center_x + (original_points[i][0] * cos_a - original_points[i][1] * sin_a);
-            rotated_points[i][1] = center_y + (original_points[i][0] * sin_a + original_points[i][1] * cos_a);
+    // Rebuild the cached gradient only when the output size changes
+    if (!background_texture || out_w != background_w || out_h != background_h) {
+        if (background_texture) {
+            SDL_DestroyTexture(background_texture);
         }
 
-        // Draw rotated fat stick figure
-        // Bigger head (circle approximated with filled rect)
-        SDL_FRect head = {rotated_points[0][0] - 5, rotated_points[0][1] - 4, 10, 8};
-        SDL_RenderFillRect(renderer, &head);
-
-        // Fat body (draw as thick line or multiple lines for width)
-        for (int offset = -3; offset <= 3; offset++) {
-            SDL_RenderLine(renderer, rotated_points[1][0] + offset, rotated_points[1][1],
-                          rotated_points[2][0] + offset, rotated_points[2][1]);
+        // The gradient only varies vertically, so a one pixel wide column
+        // stretched across the screen is enough
+        background_texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32,
+                                               SDL_TEXTUREACCESS_STATIC, 1, out_h);
+        if (!background_texture) {
+            SDL_Log("Couldn't create background texture: %s", SDL_GetError());
+            background_w = background_h = 0;
+            return;
         }
+        SDL_SetTextureScaleMode(background_texture, SDL_SCALEMODE_NEAREST);
 
-        // Arms
-        SDL_RenderLine(renderer, rotated_points[1][0], rotated_points[1][1],
-                      rotated_points[3][0], rotated_points[3][1]);
-        SDL_RenderLine(renderer, rotated_points[2][0], rotated_points[2][1],
-                      rotated_points[4][0], rotated_points[4][1]);
-
-        // Legs
-        SDL_RenderLine(renderer, rotated_points[1][0], rotated_points[1][1],
-                      rotated_points[5][0], rotated_points[5][1]);
-        SDL_RenderLine(renderer, rotated_points[2][0], rotated_points[2][1],
-                      rotated_points[6][0], rotated_points[6][1]);
-    } else {
-        // Fat/chubby stick figure
-        // Bigger head (circle approximated with filled rect)
-        SDL_FRect head = {center_x - 5, center_y - 20, 10, 8};
-        SDL_RenderFillRect(renderer, &head);
-
-        // Fat body (wide oval approximated with filled rect)
-        SDL_FRect body = {center_x - 8, center_y - 12, 16, 20};
-        SDL_RenderFillRect(renderer, &body);
-
-        // Shorter arms extending from wider body
-        float arm_swing = is_walking ? SDL_sinf(walk_animation_timer) * 2.0f : 0.0f;
-        SDL_RenderLine(renderer, center_x - 8, center_y - 2 + arm_swing, center_x - 12, center_y + 2 + arm_swing);
-        SDL_RenderLine(renderer, center_x + 8, center_y - 2 - arm_swing, center_x + 12, center_y + 2 - arm_swing);
-
-        if (is_walking) {
-            // Walking legs - alternating positions (shorter stride for fat person)
-            float leg_swing = SDL_sinf(walk_animation_timer) * 2.0f; // Reduced swing
-            float leg_forward = SDL_sinf(walk_animation_timer + 3.14f) * 2.0f; // Opposite phase
-
-            // Left leg (shorter, from bottom of wide body)
-            SDL_RenderLine(renderer, center_x - 4, center_y + 8,
-                          center_x - 6 + leg_swing, center_y + 17);
-
-            // Right leg (shorter, from bottom of wide body)
-            SDL_RenderLine(renderer, center_x + 4, center_y + 8,
-                          center_x + 6 + leg_forward, center_y + 17);
-        } else {
-            // Static legs (shorter, from wider body)
-            SDL_RenderLine(renderer, center_x - 4, center_y + 8, center_x - 6, center_y + 17);
-            SDL_RenderLine(renderer, center_x + 4, center_y + 8, center_x + 6, center_y + 17);
+        Uint8 *pixels = (Uint8 *)SDL_malloc((size_t)out_h * 4);
+        if (!pixels) {
+            SDL_DestroyTexture(background_texture);
+            background_texture = NULL;
+            return;
         }
+        for (int y = 0; y < out_h; y++) {
+            float ratio = (float)y / out_h;
+            pixels[y * 4 + 0] = (Uint8)(20 + ratio * 60);
+            pixels[y * 4 + 1] = (Uint8)(30 + ratio * 80);
+            pixels[y * 4 + 2] = (Uint8)(60 + ratio * 120);
+            pixels[y * 4 + 3] = 255;
+        }
+        SDL_UpdateTexture(background_texture, NULL, pixels, 4);
+        SDL_free(pixels);
+
+        background_w = out_w;
+        background_h = out_h;
     }
+
+    // Gradient background - a single textured draw
+    SDL_RenderTexture(renderer, background_texture, NULL, NULL);
 }
 
+void render_player(void)
+{
+    // Skip rendering if flashing during invincibility
+    int invincibility = snapshot->invincibility_timer;
+    if (invincibility > 0 && (invincibility / (TICK_RATE / 12)) % 2) {
+        return;
+    }
+
+    SDL_FRect draw = interpolate_rect(snapshot->prev_player, snapshot->player);
+    float center_x = draw.x + draw.w / 2.0f;
+    float center_y = draw.y + draw.h / 2.0f;
+
+    // Fat stick figure from the atlas: spinning after death, otherwise walking or standing
+    const SDL_FRect *sprite = &atlas.idle;
+    if (snapshot->game_over) {
+        sprite = atlas_spin_frame(&atlas, snapshot->player_rotation);
+    } else if (snapshot->walking) {
+        float walk_phase = SDL_fmodf(snapshot->walk_timer * TICK_DT * WALK_CYCLE_SPEED, 6.28f);
+        sprite = atlas_walk_frame(&atlas, walk_phase);
+    }
+    quad_batch_add_sprite(&quad_batch, center_x - ATLAS_CELL / 2, center_y - ATLAS_CELL / 2, ATLAS_CELL, ATLAS_CELL,
+                          sprite, 255, 50, 50, 255);
+}
+
+void render_walkers(void)
+{
+    // Walkers can number in the hundreds; each is one standing sprite in the batch
+    for (int i = 0; i < snapshot->num_walkers; i++) {
+        SDL_FRect draw = interpolate_rect(snapshot->prev_walkers[i], snapshot->walkers[i]);
+        float center_x = draw.x + draw.w / 2.0f;
+        float center_y = draw.y + draw.h / 2.0f;
+        quad_batch_add_sprite(&quad_batch, center_x - ATLAS_CELL / 2, center_y - ATLAS_CELL / 2,
+                              ATLAS_CELL, ATLAS_CELL, &atlas.idle, 80, 160, 255, 255);
+    }
+}
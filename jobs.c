@@ -0,0 +1,123 @@
+/*
+  Work-stealing job system.
+*/
+#include "jobs.h"
+
+// Claims and runs chunks from every queue, starting with the thread's own
+static void run_chunks(JobSystem *jobs, int self)
+{
+    int num_queues = jobs->num_threads + 1;
+    for (int k = 0; k < num_queues; k++) {
+        JobQueue *queue = &jobs->queues[(self + k) % num_queues];
+        for (;;) {
+            int chunk = SDL_AddAtomicInt(&queue->next, 1);
+            if (chunk >= queue->end) {
+                break;
+            }
+            int begin = chunk * jobs->grain;
+            int end = SDL_min(begin + jobs->grain, jobs->count);
+            jobs->func(jobs->data, begin, end);
+        }
+    }
+}
+
+static int SDLCALL worker_thread(void *data)
+{
+    JobWorker *worker = (JobWorker *)data;
+    JobSystem *jobs = worker->jobs;
+    for (;;) {
+        SDL_WaitSemaphore(jobs->wake);
+        if (SDL_GetAtomicInt(&jobs->quit)) {
+            break;
+        }
+        run_chunks(jobs, worker->index);
+        SDL_SignalSemaphore(jobs->idle);
+    }
+    return 0;
+}
+
+int jobs_init(JobSystem *jobs, int num_threads)
+{
+    SDL_zerop(jobs);
+    if (num_threads <= 0) {
+        num_threads = SDL_GetNumLogicalCPUCores();
+    }
+    int num_workers = SDL_clamp(num_threads - 1, 0, JOBS_MAX_THREADS);
+    if (num_workers == 0) {
+        return 1;
+    }
+
+    jobs->wake = SDL_CreateSemaphore(0);
+    jobs->idle = SDL_CreateSemaphore(0);
+    if (!jobs->wake || !jobs->idle) {
+        jobs_shutdown(jobs);
+        return 0;
+    }
+    for (int i = 0; i < num_workers; i++) {
+        jobs->workers[i].jobs = jobs;
+        jobs->workers[i].index = i;
+        jobs->threads[i] = SDL_CreateThread(worker_thread, "job worker", &jobs->workers[i]);
+        if (!jobs->threads[i]) {
+            break;
+        }
+        jobs->num_threads++;
+    }
+    return 1;
+}
+
+void jobs_shutdown(JobSystem *jobs)
+{
+    SDL_SetAtomicInt(&jobs->quit, 1);
+    for (int i = 0; i < jobs->num_threads; i++) {
+        SDL_SignalSemaphore(jobs->wake);
+    }
+    for (int i = 0; i < jobs->num_threads; i++) {
+        SDL_WaitThread(jobs->threads[i], NULL);
+    }
+    if (jobs->wake) {
+        SDL_DestroySemaphore(jobs->wake);
+    }
+    if (jobs->idle) {
+        SDL_DestroySemaphore(jobs->idle);
+    }
+    SDL_zerop(jobs);
+}
+
+void jobs_parallel_for(JobSystem *jobs, int count, int grain, JobFunc func, void *data)
+{
+    if (count <= 0) {
+        return;
+    }
+    if (grain < 1) {
+        grain = 1;
+    }
+    int num_chunks = (count + grain - 1) / grain;
+    if (!jobs || jobs->num_threads == 0 || num_chunks == 1) {
+        func(data, 0, count);
+        return;
+    }
+
+    jobs->func = func;
+    jobs->data = data;
+    jobs->count = count;
+    jobs->grain = grain;
+
+    // Deal the chunks out evenly; stealing evens out the rest
+    int num_queues = jobs->num_threads + 1;
+    for (int i = 0; i < num_queues; i++) {
+        SDL_SetAtomicInt(&jobs->queues[i].next, (int)((Sint64)num_chunks * i / num_queues));
+        jobs->queues[i].end = (int)((Sint64)num_chunks * (i + 1) / num_queues);
+    }
+
+    // Only wake as many workers as there are chunks for
+    int num_woken = SDL_min(jobs->num_threads, num_chunks - 1);
+    for (int i = 0; i < num_woken; i++) {
+        SDL_SignalSemaphore(jobs->wake);
+    }
+    run_chunks(jobs, jobs->num_threads);
+
+    // Barrier: a worker only signals idle once it can no longer touch this job
+    for (int i = 0; i < num_woken; i++) {
+        SDL_WaitSemaphore(jobs->idle);
+    }
+}
@@ -0,0 +1,60 @@
+/*
+  Small work-stealing job system for data-parallel simulation phases.
+
+  A parallel-for splits a range into chunks and deals them out evenly to a
+  queue per thread, the caller included. Each thread drains its own queue
+  and then steals from the others, so uneven chunks still balance out.
+  Chunks are claimed with an atomic add, which needs no locks. The call
+  returns once every chunk has run, so the next phase can rely on the
+  results.
+*/
+#ifndef JOBS_H
+#define JOBS_H
+
+#include <SDL3/SDL.h>
+
+#define JOBS_MAX_THREADS 16
+
+// Processes [begin, end) of the range handed to jobs_parallel_for().
+typedef void (*JobFunc)(void *data, int begin, int end);
+
+typedef struct JobSystem JobSystem;
+
+typedef struct {
+    SDL_AtomicInt next; // Next chunk to claim
+    int end; // One past the queue's last chunk
+    Uint8 padding[64 - sizeof(SDL_AtomicInt) - sizeof(int)]; // Keep queues on separate cache lines
+} JobQueue;
+
+typedef struct {
+    JobSystem *jobs;
+    int index;
+} JobWorker;
+
+struct JobSystem {
+    int num_threads; // Worker threads besides the caller
+    SDL_Thread *threads[JOBS_MAX_THREADS];
+    JobWorker workers[JOBS_MAX_THREADS];
+    JobQueue queues[JOBS_MAX_THREADS + 1]; // The caller owns the last one
+    SDL_Semaphore *wake; // Posted once per worker when a job starts
+    SDL_Semaphore *idle; // Posted by each worker once it finds nothing left
+    SDL_AtomicInt quit;
+
+    // The job in flight
+    JobFunc func;
+    void *data;
+    int count;
+    int grain;
+};
+
+// Spreads jobs over num_threads threads, the caller included, starting a worker
+// for each of the others; 0 or less uses every logical core. With a single
+// thread every job runs on the caller.
+int jobs_init(JobSystem *jobs, int num_threads);
+void jobs_shutdown(JobSystem *jobs);
+
+// Runs func over [0, count) in chunks of grain items and waits for all of them.
+// jobs may be NULL to run serially. func must only touch its own chunk.
+void jobs_parallel_for(JobSystem *jobs, int count, int grain, JobFunc func, void *data);
+
+#endif /* JOBS_H */
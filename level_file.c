@@ -0,0 +1,90 @@
+/*
+  Binary level files.
+*/
+#include "level_file.h"
+
+#include "physics.h"
+
+SDL_COMPILE_TIME_ASSERT(level_rect_matches_frect, sizeof(LevelRect) == sizeof(SDL_FRect));
+SDL_COMPILE_TIME_ASSERT(level_header_aligned, sizeof(LevelFileHeader) % 4 == 0);
+
+const size_t level_table_sizes[LEVEL_TABLE_COUNT] = {
+    sizeof(LevelRect), sizeof(LevelRect), sizeof(LevelRect), sizeof(LevelMover), sizeof(LevelChunk)
+};
+
+LevelRect level_mover_bounds(const LevelMover *mover)
+{
+    Uint32 num_points = SDL_clamp(mover->num_points, 1u, (Uint32)LEVEL_MOVER_MAX_POINTS);
+    float left = mover->points[0].x, top = mover->points[0].y;
+    float right = left, bottom = top;
+    for (Uint32 i = 1; i < num_points; i++) {
+        left = SDL_min(left, mover->points[i].x);
+        top = SDL_min(top, mover->points[i].y);
+        right = SDL_max(right, mover->points[i].x);
+        bottom = SDL_max(bottom, mover->points[i].y);
+    }
+    return (LevelRect){left, top, right - left + mover->w, bottom - top + mover->h};
+}
+
+int level_file_check_header(const LevelFileHeader *header, Uint64 file_size, const char *path)
+{
+    if (SDL_BYTEORDER != SDL_LIL_ENDIAN) {
+        return SDL_SetError("%s: level files are little-endian", path);
+    }
+    if (SDL_memcmp(header->magic, LEVEL_FILE_MAGIC, 4) != 0) {
+        return SDL_SetError("%s: not a level file", path);
+    }
+    if (header->version != LEVEL_FILE_VERSION) {
+        return SDL_SetError("%s: level file version %d, expected %d", path, header->version, LEVEL_FILE_VERSION);
+    }
+    if (header->file_size != file_size) {
+        return SDL_SetError("%s: level file size mismatch", path);
+    }
+    for (int i = 0; i < LEVEL_TABLE_COUNT; i++) {
+        const LevelTableEntry *entry = &header->tables[i];
+        if (entry->offset % 4 != 0 || entry->offset > file_size ||
+            entry->count > (file_size - entry->offset) / level_table_sizes[i]) {
+            return SDL_SetError("%s: level table out of range", path);
+        }
+    }
+    if (header->chunk_size == 0 || header->chunk_cols == 0 || header->chunk_rows == 0 ||
+        (Uint64)header->chunk_cols * header->chunk_rows != header->tables[LEVEL_TABLE_CHUNKS].count) {
+        return SDL_SetError("%s: bad chunk grid", path);
+    }
+    if (level_chunks_needed(header->chunk_size, header->chunk_cols, header->chunk_rows) > LEVEL_MAX_RESIDENT_CHUNKS) {
+        return SDL_SetError("%s: chunk size %u is too small to stream", path, (unsigned)header->chunk_size);
+    }
+    if (header->physics >= PHYSICS_PROFILE_COUNT) {
+        return SDL_SetError("%s: unknown physics profile %u", path, (unsigned)header->physics);
+    }
+    return 1;
+}
+
+// Chunks a span of length pixels can need along one axis: every chunk it
+// touches, and one more before it for entities sticking out of that one
+static Uint32 chunks_needed_along(Uint32 length, Uint32 chunk_size, Uint32 count)
+{
+    Uint32 touched = (length + chunk_size - 1) / chunk_size + 1;
+    return SDL_min(touched + 1, count);
+}
+
+int level_chunks_needed(Uint32 chunk_size, Uint32 chunk_cols, Uint32 chunk_rows)
+{
+    Uint32 cols = chunks_needed_along(LEVEL_VIEW_WIDTH + LEVEL_ACTIVE_MARGIN * 2, chunk_size, chunk_cols);
+    Uint32 rows = chunks_needed_along(LEVEL_VIEW_HEIGHT + LEVEL_ACTIVE_MARGIN * 2, chunk_size, chunk_rows);
+    return (int)(cols * rows);
+}
+
+int level_file_check_chunks(const LevelFileHeader *header, const LevelChunk *chunks, const char *path)
+{
+    Uint32 num_chunks = header->tables[LEVEL_TABLE_CHUNKS].count;
+    for (Uint32 c = 0; c < num_chunks; c++) {
+        for (int t = 0; t < LEVEL_ENTITY_TABLES; t++) {
+            Uint32 total = header->tables[t].count;
+            if (chunks[c].first[t] > total || chunks[c].count[t] > total - chunks[c].first[t]) {
+                return SDL_SetError("%s: chunk %u out of range", path, c);
+            }
+        }
+    }
+    return 1;
+}
@@ -0,0 +1,111 @@
+/*
+  Binary level files.
+
+  A level file is a fixed header followed by packed entity tables, laid out
+  so that a chunk's runs can be read straight into memory and used in place:
+  the tables are arrays of the structs below, 4-byte aligned, little-endian.
+  Files are produced from the text format by the levelc tool.
+
+  The world is divided into square chunks. Every entity belongs to the chunk
+  holding the top-left corner of its rect (for movers, of the whole path it
+  travels), and is no bigger than a chunk, so it can only reach into the
+  chunks to the right of and below its own. The entity tables are sorted by
+  chunk, and the chunk directory gives each chunk's run in every table, so
+  a chunk can be read on its own without touching the rest of the file.
+*/
+#ifndef LEVEL_FILE_H
+#define LEVEL_FILE_H
+
+#include <SDL3/SDL.h>
+
+#define LEVEL_FILE_MAGIC "PLVL"
+#define LEVEL_FILE_VERSION 4
+#define LEVEL_NAME_SIZE 32
+
+// Header flags
+#define LEVEL_FLAG_DOUBLE_JUMP 0x0001
+
+typedef enum {
+    LEVEL_TABLE_PLATFORMS,
+    LEVEL_TABLE_LAVA,
+    LEVEL_TABLE_COLLECTIBLES,
+    LEVEL_TABLE_MOVERS,
+    LEVEL_TABLE_CHUNKS, // One LevelChunk per chunk, row by row
+    LEVEL_TABLE_COUNT
+} LevelTable;
+
+#define LEVEL_ENTITY_TABLES LEVEL_TABLE_CHUNKS // The tables before the chunk directory
+#define LEVEL_DEFAULT_CHUNK_SIZE 1024
+
+// The game keeps the chunks under its view, plus a margin, resident in a pool
+// of LEVEL_MAX_RESIDENT_CHUNKS; a level's chunks can't be so small that a view
+// of the size the game is played at needs more than that
+#define LEVEL_VIEW_WIDTH 1200
+#define LEVEL_VIEW_HEIGHT 800
+#define LEVEL_ACTIVE_MARGIN 128 // How far past the view the level is simulated
+#define LEVEL_MAX_RESIDENT_CHUNKS 64
+
+// Laid out exactly like SDL_FRect so static geometry can be used straight from the file
+typedef struct {
+    float x, y, w, h;
+} LevelRect;
+
+#define LEVEL_MOVER_MAX_POINTS 8
+
+typedef struct {
+    float x, y;
+} LevelPoint;
+
+// A platform travelling from its first waypoint to its last and back, over
+// and over, so where it is only depends on how long the level has run
+typedef struct {
+    float w, h;
+    float speed; // Pixels per second along the path
+    float phase; // How far along the way there and back it is when the level starts
+    Uint32 num_points; // 1 to LEVEL_MOVER_MAX_POINTS; one point stands still
+    LevelPoint points[LEVEL_MOVER_MAX_POINTS]; // Top-left corner at each waypoint
+} LevelMover;
+
+typedef struct {
+    Uint32 offset; // Bytes from the start of the file
+    Uint32 count;
+} LevelTableEntry;
+
+// A chunk's entities are entries [first, first + count) of each entity table
+typedef struct {
+    Uint32 first[LEVEL_ENTITY_TABLES];
+    Uint32 count[LEVEL_ENTITY_TABLES];
+} LevelChunk;
+
+typedef struct {
+    char magic[4];
+    Uint16 version;
+    Uint16 flags;
+    Uint32 file_size;
+    Uint32 width, height; // World size; the camera scrolls when it's larger than the view
+    char name[LEVEL_NAME_SIZE];
+    LevelRect start;
+    LevelRect goal;
+    Uint32 chunk_size; // Side of a chunk in pixels
+    Uint32 chunk_cols, chunk_rows;
+    Uint32 physics; // PhysicsProfile the level is played with
+    LevelTableEntry tables[LEVEL_TABLE_COUNT];
+} LevelFileHeader;
+
+// Size of one entry of each table
+extern const size_t level_table_sizes[LEVEL_TABLE_COUNT];
+
+// The rect a mover covers over its whole path.
+LevelRect level_mover_bounds(const LevelMover *mover);
+
+// Most chunks a view of LEVEL_VIEW_WIDTH by LEVEL_VIEW_HEIGHT and its margin
+// can need at once, anywhere in a level with this chunk grid.
+int level_chunks_needed(Uint32 chunk_size, Uint32 chunk_cols, Uint32 chunk_rows);
+
+// Checks a header against the size of its file.
+int level_file_check_header(const LevelFileHeader *header, Uint64 file_size, const char *path);
+
+// Checks the chunk directory is complete and every run lies inside its table.
+int level_file_check_chunks(const LevelFileHeader *header, const LevelChunk *chunks, const char *path);
+
+#endif /* LEVEL_FILE_H */
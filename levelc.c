@@ -0,0 +1,468 @@
+/*
+  levelc - converts a text level description into a binary level file.
+
+  Usage: levelc input.txt output.lvl
+
+  The text format is one entity per line, '#' starts a comment:
+
+    name <text>
+    size <width> <height>         world size, scrolled through when larger than the screen
+    chunk <size>                  side of a streaming chunk, 1024 by default
+    flags double_jump
+    physics <profile>             movement constants, normal unless given; see physics.h
+    start x y w h
+    goal x y w h
+    platform x y w h
+    lava x y w h
+    gem x y w h
+    mover x y w h vx vy start_x end_x start_y end_y
+    path w h speed x1 y1 x2 y2 ...  up to 8 waypoints, travelled there and back
+
+  Any coordinate may be written relative to the world size as w-N or h-N.
+
+  A mover bounces along one axis between its bounds, starting at x y and
+  heading the way its velocity points; it is stored as a two point path.
+  A path starts at its first waypoint.
+
+  Platforms and lava bigger than a chunk are split into chunk-sized pieces;
+  gems and mover paths have to fit in one. Chunks so small that the game's
+  view would need more of them at once than it keeps resident are rejected.
+*/
+#include <SDL3/SDL.h>
+
+#include "level_file.h"
+#include "physics.h"
+
+#define MAX_TOKENS 24
+
+typedef struct {
+    void *data;
+    int count, capacity;
+} Table;
+
+static const char *input_path;
+static int line_number;
+
+static int fail(const char *message, const char *detail)
+{
+    SDL_Log("%s:%d: %s%s%s", input_path, line_number, message, detail ? ": " : "", detail ? detail : "");
+    return 0;
+}
+
+static void *table_push(Table *table, size_t element_size)
+{
+    if (table->count == table->capacity) {
+        int capacity = table->capacity ? table->capacity * 2 : 16;
+        void *data = SDL_realloc(table->data, element_size * capacity);
+        if (!data) {
+            return NULL;
+        }
+        table->data = data;
+        table->capacity = capacity;
+    }
+    return (Uint8 *)table->data + element_size * table->count++;
+}
+
+// Parses a number, or w/h optionally followed by an offset
+static int parse_value(const char *token, const LevelFileHeader *header, float *out)
+{
+    double base = 0.0;
+    if (token[0] == 'w' || token[0] == 'h') {
+        base = (token[0] == 'w') ? header->width : header->height;
+        token++;
+        if (!*token) {
+            *out = (float)base;
+            return 1;
+        }
+    }
+    char *end;
+    double value = SDL_strtod(token, &end);
+    if (end == token || *end) {
+        return 0;
+    }
+    *out = (float)(base + value);
+    return 1;
+}
+
+static int parse_values(char **tokens, int num_tokens, int expected, const LevelFileHeader *header, float *out)
+{
+    if (num_tokens != expected + 1) {
+        return fail("wrong number of values for", tokens[0]);
+    }
+    for (int i = 0; i < expected; i++) {
+        if (!parse_value(tokens[i + 1], header, &out[i])) {
+            return fail("bad value", tokens[i + 1]);
+        }
+    }
+    return 1;
+}
+
+// A mover given by its bounds, as a path between them starting partway along
+static LevelMover legacy_mover(LevelRect rect, float vx, float vy, float start_x, float end_x, float start_y, float end_y)
+{
+    LevelMover mover;
+    SDL_zero(mover);
+    mover.w = rect.w;
+    mover.h = rect.h;
+    mover.points[0] = (LevelPoint){rect.x, rect.y};
+    mover.num_points = 1;
+    if (vx == 0 && vy == 0) {
+        return mover;
+    }
+
+    float velocity = vx != 0 ? vx : vy;
+    float start = vx != 0 ? start_x : start_y;
+    float end = vx != 0 ? end_x : end_y;
+    float position = vx != 0 ? rect.x : rect.y;
+    float length = end - start;
+    mover.points[0] = vx != 0 ? (LevelPoint){start_x, rect.y} : (LevelPoint){rect.x, start_y};
+    mover.points[1] = vx != 0 ? (LevelPoint){end_x, rect.y} : (LevelPoint){rect.x, end_y};
+    mover.num_points = 2;
+    mover.speed = SDL_fabsf(velocity);
+    // Heading for end it's on the way there, otherwise on the way back
+    float along = SDL_clamp(position - start, 0.0f, length);
+    mover.phase = velocity > 0 ? along : 2.0f * length - along;
+    return mover;
+}
+
+static int parse_line(char *line, LevelFileHeader *header, Table *tables)
+{
+    char *comment = SDL_strchr(line, '#');
+    if (comment) {
+        *comment = '\0';
+    }
+
+    char *tokens[MAX_TOKENS];
+    int num_tokens = 0;
+    char *state = NULL;
+    for (char *token = SDL_strtok_r(line, " \t\r", &state); token; token = SDL_strtok_r(NULL, " \t\r", &state)) {
+        if (num_tokens == MAX_TOKENS) {
+            return fail("too many values", NULL);
+        }
+        tokens[num_tokens++] = token;
+    }
+    if (num_tokens == 0) {
+        return 1;
+    }
+
+    const char *keyword = tokens[0];
+    float v[3 + 2 * LEVEL_MOVER_MAX_POINTS];
+    if (SDL_strcmp(keyword, "name") == 0) {
+        // The name is the rest of the line, re-joined
+        header->name[0] = '\0';
+        for (int i = 1; i < num_tokens; i++) {
+            if (i > 1) {
+                SDL_strlcat(header->name, " ", sizeof(header->name));
+            }
+            SDL_strlcat(header->name, tokens[i], sizeof(header->name));
+        }
+    } else if (SDL_strcmp(keyword, "size") == 0) {
+        if (!parse_values(tokens, num_tokens, 2, header, v)) {
+            return 0;
+        }
+        header->width = (Uint32)v[0];
+        header->height = (Uint32)v[1];
+    } else if (SDL_strcmp(keyword, "chunk") == 0) {
+        if (!parse_values(tokens, num_tokens, 1, header, v)) {
+            return 0;
+        }
+        if (v[0] < 64) {
+            return fail("chunk size must be at least 64", tokens[1]);
+        }
+        header->chunk_size = (Uint32)v[0];
+    } else if (SDL_strcmp(keyword, "flags") == 0) {
+        for (int i = 1; i < num_tokens; i++) {
+            if (SDL_strcmp(tokens[i], "double_jump") == 0) {
+                header->flags |= LEVEL_FLAG_DOUBLE_JUMP;
+            } else {
+                return fail("unknown flag", tokens[i]);
+            }
+        }
+    } else if (SDL_strcmp(keyword, "physics") == 0) {
+        if (num_tokens != 2) {
+            return fail("wrong number of values for", tokens[0]);
+        }
+        int profile = 0;
+        while (profile < PHYSICS_PROFILE_COUNT && SDL_strcmp(tokens[1], physics_profile_names[profile]) != 0) {
+            profile++;
+        }
+        if (profile == PHYSICS_PROFILE_COUNT) {
+            return fail("unknown physics profile", tokens[1]);
+        }
+        header->physics = (Uint32)profile;
+    } else if (SDL_strcmp(keyword, "start") == 0 || SDL_strcmp(keyword, "goal") == 0) {
+        if (!parse_values(tokens, num_tokens, 4, header, v)) {
+            return 0;
+        }
+        LevelRect *rect = (keyword[0] == 's') ? &header->start : &header->goal;
+        *rect = (LevelRect){v[0], v[1], v[2], v[3]};
+    } else if (SDL_strcmp(keyword, "platform") == 0 || SDL_strcmp(keyword, "lava") == 0 ||
+               SDL_strcmp(keyword, "gem") == 0) {
+        LevelTable table = LEVEL_TABLE_COLLECTIBLES;
+        if (keyword[0] == 'p') {
+            table = LEVEL_TABLE_PLATFORMS;
+        } else if (keyword[0] == 'l') {
+            table = LEVEL_TABLE_LAVA;
+        }
+        if (!parse_values(tokens, num_tokens, 4, header, v)) {
+            return 0;
+        }
+        LevelRect *rect = (LevelRect *)table_push(&tables[table], sizeof(LevelRect));
+        if (!rect) {
+            return fail("out of memory", NULL);
+        }
+        *rect = (LevelRect){v[0], v[1], v[2], v[3]};
+    } else if (SDL_strcmp(keyword, "mover") == 0) {
+        if (!parse_values(tokens, num_tokens, 10, header, v)) {
+            return 0;
+        }
+        if (v[4] != 0 && v[5] != 0) {
+            return fail("movers travel along one axis, use a path", NULL);
+        }
+        LevelMover *mover = (LevelMover *)table_push(&tables[LEVEL_TABLE_MOVERS], sizeof(LevelMover));
+        if (!mover) {
+            return fail("out of memory", NULL);
+        }
+        *mover = legacy_mover((LevelRect){v[0], v[1], v[2], v[3]}, v[4], v[5], v[6], v[7], v[8], v[9]);
+    } else if (SDL_strcmp(keyword, "path") == 0) {
+        int num_points = (num_tokens - 4) / 2;
+        if (num_tokens < 6 || (num_tokens - 4) % 2 != 0 || num_points > LEVEL_MOVER_MAX_POINTS) {
+            return fail("a path takes a size, a speed and 1 to 8 waypoints", NULL);
+        }
+        if (!parse_values(tokens, num_tokens, num_tokens - 1, header, v)) {
+            return 0;
+        }
+        LevelMover *mover = (LevelMover *)table_push(&tables[LEVEL_TABLE_MOVERS], sizeof(LevelMover));
+        if (!mover) {
+            return fail("out of memory", NULL);
+        }
+        SDL_zerop(mover);
+        mover->w = v[0];
+        mover->h = v[1];
+        mover->speed = SDL_fabsf(v[2]);
+        mover->num_points = (Uint32)num_points;
+        for (int i = 0; i < num_points; i++) {
+            mover->points[i] = (LevelPoint){v[3 + 2 * i], v[4 + 2 * i]};
+        }
+    } else {
+        return fail("unknown keyword", keyword);
+    }
+    return 1;
+}
+
+// End of the piece starting at pos: the next chunk boundary if the whole span is longer than a chunk
+static float piece_end(float pos, float end, float length, float chunk_size)
+{
+    if (length <= chunk_size) {
+        return end;
+    }
+    return SDL_min(end, (SDL_floorf(pos / chunk_size) + 1) * chunk_size);
+}
+
+// Cuts rects bigger than a chunk at the chunk boundaries they cross
+static int split_table(Table *table, float chunk_size)
+{
+    Table pieces;
+    SDL_zero(pieces);
+    for (int i = 0; i < table->count; i++) {
+        LevelRect rect = ((const LevelRect *)table->data)[i];
+        for (float y = rect.y; y < rect.y + rect.h; ) {
+            float y_end = piece_end(y, rect.y + rect.h, rect.h, chunk_size);
+            for (float x = rect.x; x < rect.x + rect.w; ) {
+                float x_end = piece_end(x, rect.x + rect.w, rect.w, chunk_size);
+                LevelRect *piece = (LevelRect *)table_push(&pieces, sizeof(LevelRect));
+                if (!piece) {
+                    SDL_free(pieces.data);
+                    return 0;
+                }
+                *piece = (LevelRect){x, y, x_end - x, y_end - y};
+                x = x_end;
+            }
+            y = y_end;
+        }
+    }
+    SDL_free(table->data);
+    *table = pieces;
+    return 1;
+}
+
+typedef struct {
+    int chunk;
+    int index; // Original position, so the sort keeps file order within a chunk
+} ChunkKey;
+
+static int SDLCALL compare_keys(const void *a, const void *b)
+{
+    const ChunkKey *ka = (const ChunkKey *)a, *kb = (const ChunkKey *)b;
+    if (ka->chunk != kb->chunk) {
+        return ka->chunk < kb->chunk ? -1 : 1;
+    }
+    return ka->index < kb->index ? -1 : (ka->index > kb->index);
+}
+
+// The rect an entity can ever cover: movers sweep their whole path
+static LevelRect entity_bounds(LevelTable table, const void *entry)
+{
+    if (table != LEVEL_TABLE_MOVERS) {
+        return *(const LevelRect *)entry;
+    }
+    return level_mover_bounds((const LevelMover *)entry);
+}
+
+// Sorts every entity table by home chunk and fills in the chunk directory
+static int build_chunks(LevelFileHeader *header, Table *tables)
+{
+    if (header->chunk_size == 0) {
+        header->chunk_size = LEVEL_DEFAULT_CHUNK_SIZE;
+    }
+    float chunk_size = (float)header->chunk_size;
+    if (!split_table(&tables[LEVEL_TABLE_PLATFORMS], chunk_size) || !split_table(&tables[LEVEL_TABLE_LAVA], chunk_size)) {
+        return fail("out of memory", NULL);
+    }
+
+    int cols = (int)SDL_max((header->width + header->chunk_size - 1) / header->chunk_size, 1);
+    int rows = (int)SDL_max((header->height + header->chunk_size - 1) / header->chunk_size, 1);
+    header->chunk_cols = (Uint32)cols;
+    header->chunk_rows = (Uint32)rows;
+    if (level_chunks_needed(header->chunk_size, header->chunk_cols, header->chunk_rows) > LEVEL_MAX_RESIDENT_CHUNKS) {
+        char detail[64];
+        SDL_snprintf(detail, sizeof(detail), "%u needs up to %d of %d chunks at once", (unsigned)header->chunk_size,
+                     level_chunks_needed(header->chunk_size, header->chunk_cols, header->chunk_rows),
+                     LEVEL_MAX_RESIDENT_CHUNKS);
+        return fail("chunk size too small to stream", detail);
+    }
+    LevelChunk *chunks = (LevelChunk *)SDL_calloc((size_t)cols * rows, sizeof(LevelChunk));
+    if (!chunks) {
+        return fail("out of memory", NULL);
+    }
+
+    static const char *table_names[LEVEL_ENTITY_TABLES] = { "platform", "lava", "gem", "mover path" };
+    for (int t = 0; t < LEVEL_ENTITY_TABLES; t++) {
+        Table *table = &tables[t];
+        size_t size = level_table_sizes[t];
+        ChunkKey *keys = (ChunkKey *)SDL_malloc(sizeof(ChunkKey) * SDL_max(table->count, 1));
+        Uint8 *sorted = (Uint8 *)SDL_malloc(size * SDL_max(table->count, 1));
+        if (!keys || !sorted) {
+            SDL_free(keys);
+            SDL_free(sorted);
+            SDL_free(chunks);
+            return fail("out of memory", NULL);
+        }
+
+        for (int i = 0; i < table->count; i++) {
+            LevelRect bounds = entity_bounds((LevelTable)t, (const Uint8 *)table->data + size * i);
+            if (bounds.w > chunk_size || bounds.h > chunk_size) {
+                SDL_free(keys);
+                SDL_free(sorted);
+                SDL_free(chunks);
+                return fail("bigger than a chunk", table_names[t]);
+            }
+            int cx = SDL_clamp((int)SDL_floorf(bounds.x / chunk_size), 0, cols - 1);
+            int cy = SDL_clamp((int)SDL_floorf(bounds.y / chunk_size), 0, rows - 1);
+            keys[i] = (ChunkKey){cy * cols + cx, i};
+        }
+        SDL_qsort(keys, table->count, sizeof(ChunkKey), compare_keys);
+
+        for (int i = 0; i < table->count; i++) {
+            SDL_memcpy(sorted + size * i, (const Uint8 *)table->data + size * keys[i].index, size);
+            LevelChunk *chunk = &chunks[keys[i].chunk];
+            if (chunk->count[t]++ == 0) {
+                chunk->first[t] = (Uint32)i;
+            }
+        }
+        SDL_free(keys);
+        SDL_free(table->data);
+        table->data = sorted;
+        table->capacity = SDL_max(table->count, 1);
+    }
+
+    Table *directory = &tables[LEVEL_TABLE_CHUNKS];
+    SDL_free(directory->data);
+    directory->data = chunks;
+    directory->count = directory->capacity = cols * rows;
+    return 1;
+}
+
+// Lays the header and tables out back to back and writes them in one go
+static int write_level(const char *path, LevelFileHeader *header, Table *tables)
+{
+    const size_t *element_sizes = level_table_sizes;
+
+    size_t size = sizeof(LevelFileHeader);
+    for (int i = 0; i < LEVEL_TABLE_COUNT; i++) {
+        header->tables[i].offset = (Uint32)size;
+        header->tables[i].count = (Uint32)tables[i].count;
+        size += element_sizes[i] * tables[i].count;
+    }
+    header->file_size = (Uint32)size;
+
+    Uint8 *data = (Uint8 *)SDL_malloc(size);
+    if (!data) {
+        SDL_Log("Out of memory");
+        return 0;
+    }
+    SDL_memcpy(data, header, sizeof(LevelFileHeader));
+    for (int i = 0; i < LEVEL_TABLE_COUNT; i++) {
+        if (tables[i].count) {
+            SDL_memcpy(data + header->tables[i].offset, tables[i].data, element_sizes[i] * tables[i].count);
+        }
+    }
+
+    int ok = SDL_SaveFile(path, data, size);
+    if (!ok) {
+        SDL_Log("Couldn't write %s: %s", path, SDL_GetError());
+    }
+    SDL_free(data);
+    return ok;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc != 3) {
+        SDL_Log("Usage: %s input.txt output.lvl", argv[0]);
+        return 1;
+    }
+    input_path = argv[1];
+
+    size_t text_size;
+    char *text = (char *)SDL_LoadFile(input_path, &text_size);
+    if (!text) {
+        SDL_Log("Couldn't read %s: %s", input_path, SDL_GetError());
+        return 1;
+    }
+
+    LevelFileHeader header;
+    SDL_zero(header);
+    SDL_memcpy(header.magic, LEVEL_FILE_MAGIC, 4);
+    header.version = LEVEL_FILE_VERSION;
+    header.width = 1200;
+    header.height = 800;
+    header.physics = PHYSICS_NORMAL;
+
+    Table tables[LEVEL_TABLE_COUNT];
+    SDL_zeroa(tables);
+
+    int ok = 1;
+    char *state = NULL;
+    line_number = 0;
+    for (char *line = text; ok && line; line = state) {
+        // Split off one line at a time, keeping empty lines so line numbers stay right
+        state = SDL_strchr(line, '\n');
+        if (state) {
+            *state++ = '\0';
+        }
+        line_number++;
+        ok = parse_line(line, &header, tables);
+    }
+
+    if (ok) {
+        line_number = 0;
+        ok = build_chunks(&header, tables) && write_level(argv[2], &header, tables);
+    }
+
+    for (int i = 0; i < LEVEL_TABLE_COUNT; i++) {
+        SDL_free(tables[i].data);
+    }
+    SDL_free(text);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,692 @@
+/*
+  levelcheck - checks that binary levels can be completed.
+
+  Usage: levelcheck [--threads N] [--step N] [--max-seconds N] [--max-states N]
+                    level.lvl...
+
+  Plays each level with the game's own simulation, searching breadth first
+  over what the player can do: every step holds one of left, right or
+  nothing, with jump released, held or pressed again, for --step ticks
+  (default 8). Places the search has already been in are not gone on from -
+  the player's position and fall speed are compared within a few pixels,
+  along with whether it is on the ground, has a double jump left and is
+  holding jump through a rise - and nor are steps that cost a life. On
+  levels with moving platforms the time counts too while standing, in steps
+  of half a second, as waiting for a platform matters there.
+
+  Gems don't change how the player moves, so this first search only finds
+  where the player can get to, and which steps between those places reach
+  gems or the goal. A route is then played out from the start: a search of
+  the same kind, with the gems kept this time, goes on until it picks up
+  another gem that still leaves the rest and the goal within reach, and
+  starts again from there, until the level is won. Each part of the route is
+  one the simulation really took, so a level only counts as completable if
+  it was actually completed.
+
+  Each level is reported with the gems either search reached, when the goal
+  was first reached and how long the route took, to the tick. Going for the
+  nearest gem each time isn't always quickest, so a level may well be
+  completed sooner than that route, but never any later. A level that can't
+  be completed within --max-seconds of level time (default 60) or
+  --max-states places (default 1000000) fails, and the exit status is 1 if
+  any did.
+
+  Every step of the search is spread across --threads threads (default:
+  every core), each with a Game of its own working through a slice of the
+  places found by the step before. The slices are merged in order, so the
+  result doesn't depend on the thread count.
+*/
+#include <SDL3/SDL.h>
+
+#include "game.h"
+#include "jobs.h"
+
+#define DEFAULT_STEP_TICKS 8
+#define DEFAULT_MAX_SECONDS 60
+#define DEFAULT_MAX_STATES 1000000
+#define MAX_WORKERS (JOBS_MAX_THREADS + 1)
+#define MAX_ROUTE_GEMS 64 // Steps keep the gems taken in a bit mask
+
+// The game's play area, which decides what the camera keeps active
+#define PLAY_WIDTH 1200.0f
+#define PLAY_HEIGHT 800.0f
+
+// How close two states have to be to count as the same place
+#define CELL_SIZE 16.0f // Pixels, for steps of DEFAULT_STEP_TICKS; scaled with the step so one still leaves its cell
+#define FALL_SPEED_BUCKET 120.0f // Pixels per second
+#define PLATFORM_TIME_BUCKET (TICK_RATE / 2) // Ticks, only on levels with moving platforms
+
+#define NUM_ACTIONS 9
+#define JUMP_HOLD 1
+#define JUMP_PRESS 2
+
+// Left, right or neither, each with jump released, held or pressed again
+static const Uint32 actions[NUM_ACTIONS][2] = {
+    {0, 0}, {GAME_INPUT_LEFT, 0}, {GAME_INPUT_RIGHT, 0},
+    {0, JUMP_HOLD}, {GAME_INPUT_LEFT, JUMP_HOLD}, {GAME_INPUT_RIGHT, JUMP_HOLD},
+    {0, JUMP_PRESS}, {GAME_INPUT_LEFT, JUMP_PRESS}, {GAME_INPUT_RIGHT, JUMP_PRESS},
+};
+
+// A step tried from a place, as far as routes are concerned
+typedef struct {
+    Uint64 gems; // Touched during the step, a bit each
+    Sint32 to; // Place it ended in, -1 if it cost a life or wasn't tried
+    Uint8 goal; // Tick of the step the goal was first touched on plus one, 0 if it wasn't
+} Edge;
+
+// A step a worker tried, for the merge to add to the graph or the route to go on from
+typedef struct {
+    Uint64 place; // Hash of where it ended, never 0
+    Uint64 gems; // Touched during the step, or when routing, taken so far
+    int from; // Place it was tried from
+    Uint8 action;
+    Uint8 goal;
+    Uint8 ended; // The level was won during the step, so there is nothing to go on from
+} Move;
+
+// Moves and the states they ended in, or the states of places to go on from
+typedef struct {
+    Move *moves;
+    Uint8 *states;
+    int count, capacity;
+} MoveList;
+
+// Every place the search has been, open addressing on the place hash
+typedef struct {
+    Uint64 place; // 0 is empty
+    Sint32 node;
+} PlaceSlot;
+
+typedef struct {
+    PlaceSlot *slots;
+    size_t capacity; // Power of two
+    int count;
+} PlaceSet;
+
+// Where the player can get to: NUM_ACTIONS edges per place, in the order places were found
+typedef struct {
+    Edge *edges;
+    int num_places, capacity;
+} PlaceGraph;
+
+// The earliest level ticks something was reached at, -1 if it wasn't
+typedef struct {
+    Sint64 *gems;
+    Sint64 goal; // Touched, with or without every gem
+} Findings;
+
+typedef struct {
+    Game game;
+    Profiler profiler;
+    MoveList moves;
+    Findings findings;
+    int ok; // 0 if the worker ran out of memory
+} Worker;
+
+typedef struct {
+    Worker *workers;
+    int num_workers;
+    const Uint8 *frontier;
+    int frontier_count;
+    int first_node; // Place of the first frontier state; the rest follow in order
+    size_t state_size;
+    int step_ticks;
+    float cell_size;
+    int num_gems;
+    int timed; // Moving platforms, so the place includes the time
+    int start_lives;
+    int routing; // Gems stay taken and moves have all of them, rather than those from the step
+} Search;
+
+static Worker workers[MAX_WORKERS];
+
+static Uint64 hash_bytes(Uint64 hash, const void *data, size_t size)
+{
+    const Uint8 *bytes = (const Uint8 *)data;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+static Sint64 level_time(const Game *game)
+{
+    return (Sint64)(game->tick - game->loaded_level.start_tick);
+}
+
+/* The input for tick t of a step taking action. */
+static GameInput action_input(int action, int t)
+{
+    GameInput input = {actions[action][0]};
+    if (actions[action][1]) {
+        input.buttons |= GAME_INPUT_JUMP;
+    }
+    if (actions[action][1] == JUMP_PRESS && t == 0) {
+        input.buttons |= GAME_INPUT_JUMP_PRESSED;
+    }
+    return input;
+}
+
+/* Where the player is, as far as the search tells places apart. */
+static Uint64 place_key(const Search *search, const Game *game)
+{
+    const ActorTable *actors = &game->actors;
+    int on_ground = actors->on_ground[ACTOR_PLAYER];
+    Sint32 key[7] = {
+        (Sint32)SDL_floorf(actors->x[ACTOR_PLAYER] / search->cell_size),
+        (Sint32)SDL_floorf(actors->y[ACTOR_PLAYER] / search->cell_size),
+        (Sint32)SDL_floorf(actors->vy[ACTOR_PLAYER] / FALL_SPEED_BUCKET),
+        on_ground,
+        game->has_double_jump && actors->double_jump_used[ACTOR_PLAYER],
+        (actors->buttons[ACTOR_PLAYER] & GAME_INPUT_JUMP) && actors->vy[ACTOR_PLAYER] < 0, // Letting go only cuts a rise short
+        search->timed && on_ground ? (Sint32)(level_time(game) / PLATFORM_TIME_BUCKET) : 0,
+    };
+    Uint64 hash = hash_bytes(14695981039346656037ull, key, sizeof(key));
+    return hash ? hash : 1;
+}
+
+/* Makes room for one more entry and returns where its state goes, or NULL if the list couldn't grow. */
+static Uint8 *move_list_add(MoveList *list, const Move *move, size_t state_size)
+{
+    if (list->count == list->capacity) {
+        int capacity = list->capacity ? list->capacity * 2 : 1024;
+        Move *moves = (Move *)SDL_realloc(list->moves, sizeof(Move) * (size_t)capacity);
+        if (!moves) {
+            return NULL;
+        }
+        list->moves = moves;
+        Uint8 *states = (Uint8 *)SDL_realloc(list->states, state_size * (size_t)capacity);
+        if (!states) {
+            return NULL;
+        }
+        list->states = states;
+        list->capacity = capacity;
+    }
+    list->moves[list->count] = *move;
+    return list->states + state_size * (size_t)list->count++;
+}
+
+static void move_list_free(MoveList *list)
+{
+    SDL_free(list->moves);
+    SDL_free(list->states);
+    SDL_zerop(list);
+}
+
+/* The slot for place: holding it, or empty if it hasn't been seen. NULL if the set couldn't grow. */
+static PlaceSlot *place_set_find(PlaceSet *set, Uint64 place)
+{
+    if ((size_t)(set->count + 1) * 2 > set->capacity) {
+        size_t capacity = set->capacity ? set->capacity * 2 : 4096;
+        PlaceSlot *slots = (PlaceSlot *)SDL_calloc(capacity, sizeof(PlaceSlot));
+        if (!slots) {
+            return NULL;
+        }
+        for (size_t i = 0; i < set->capacity; i++) {
+            if (set->slots[i].place) {
+                size_t at = set->slots[i].place & (capacity - 1);
+                while (slots[at].place) {
+                    at = (at + 1) & (capacity - 1);
+                }
+                slots[at] = set->slots[i];
+            }
+        }
+        SDL_free(set->slots);
+        set->slots = slots;
+        set->capacity = capacity;
+    }
+
+    size_t at = place & (set->capacity - 1);
+    while (set->slots[at].place && set->slots[at].place != place) {
+        at = (at + 1) & (set->capacity - 1);
+    }
+    return &set->slots[at];
+}
+
+/* Adds a place with none of its steps tried yet; returns its index, or -1 if the graph couldn't grow. */
+static int place_graph_add(PlaceGraph *graph)
+{
+    if (graph->num_places == graph->capacity) {
+        int capacity = graph->capacity ? graph->capacity * 2 : 4096;
+        Edge *edges = (Edge *)SDL_realloc(graph->edges, sizeof(Edge) * NUM_ACTIONS * (size_t)capacity);
+        if (!edges) {
+            return -1;
+        }
+        graph->edges = edges;
+        graph->capacity = capacity;
+    }
+    for (int a = 0; a < NUM_ACTIONS; a++) {
+        graph->edges[graph->num_places * NUM_ACTIONS + a] = (Edge){0, -1, 0};
+    }
+    return graph->num_places++;
+}
+
+static void note_time(Sint64 *earliest, Sint64 ticks)
+{
+    if (*earliest < 0 || ticks < *earliest) {
+        *earliest = ticks;
+    }
+}
+
+/* Tries every action from the worker's slice of the frontier. */
+static void expand_places(void *data, int begin, int end)
+{
+    Search *search = (Search *)data;
+    for (int w = begin; w < end; w++) {
+        Worker *worker = &search->workers[w];
+        Game *game = &worker->game;
+        Level *level = &game->loaded_level;
+        int first = (int)((Sint64)search->frontier_count * w / search->num_workers);
+        int last = (int)((Sint64)search->frontier_count * (w + 1) / search->num_workers);
+        worker->moves.count = 0;
+
+        for (int s = first; s < last && worker->ok; s++) {
+            const Uint8 *state = search->frontier + search->state_size * (size_t)s;
+            int holding = -1;
+            for (int a = 0; a < NUM_ACTIONS && worker->ok; a++) {
+                game_load_state(game, state);
+                if (holding < 0) {
+                    holding = (game->actors.buttons[ACTOR_PLAYER] & GAME_INPUT_JUMP) != 0;
+                }
+                if (actions[a][1] == JUMP_HOLD && !holding) {
+                    continue; // Same as not jumping
+                }
+
+                // Mapping, states are saved with no gems taken, so the ones taken now are the ones this step reaches
+                Move move = {0, 0, search->first_node + s, (Uint8)a, 0, 0};
+                for (int t = 0; t < search->step_ticks && !game->game_over && !game->game_won; t++) {
+                    GameInput input = action_input(a, t);
+                    game_tick(game, &input);
+                    game->particle_spawns.count = 0; // Effects don't matter here
+
+                    Sint64 ticks = level_time(game);
+                    for (int i = 0; i < search->num_gems; i++) {
+                        if (level->collected[i]) {
+                            note_time(&worker->findings.gems[i], ticks);
+                            move.gems |= i < MAX_ROUTE_GEMS ? (Uint64)1 << i : 0;
+                        }
+                    }
+                    SDL_FRect player = actor_rect(&game->actors, ACTOR_PLAYER);
+                    if (SDL_HasRectIntersectionFloat(&player, &level->goal)) {
+                        note_time(&worker->findings.goal, ticks);
+                        if (!move.goal) {
+                            move.goal = (Uint8)(t + 1);
+                        }
+                    }
+                }
+                if (game->game_over || game->lives < search->start_lives) {
+                    continue;
+                }
+
+                move.ended = (Uint8)game->game_won;
+                move.place = place_key(search, game);
+                if (!search->routing) {
+                    SDL_memset(level->collected, 0, (size_t)level->total_collectibles);
+                    game->collected_count = 0;
+                }
+                Uint8 *saved = move_list_add(&worker->moves, &move, search->state_size);
+                if (!saved) {
+                    worker->ok = 0;
+                    break;
+                }
+                game_save_state(game, saved);
+            }
+        }
+    }
+}
+
+/* Tries every action from each state in frontier, spread over the workers. Returns 0 if one ran out of memory. */
+static int search_step(Search *search, JobSystem *jobs, const MoveList *frontier)
+{
+    search->frontier = frontier->states;
+    search->frontier_count = frontier->count;
+    jobs_parallel_for(jobs, search->num_workers, 1, expand_places, search);
+    for (int w = 0; w < search->num_workers; w++) {
+        if (!search->workers[w].ok) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* Adds the state to the list of places to go on from unless the place has
+   been seen; returns the slot, or NULL if something couldn't grow. */
+static PlaceSlot *visit_place(PlaceSet *seen, PlaceGraph *graph, MoveList *next, const Move *move, const void *state,
+                              size_t state_size)
+{
+    PlaceSlot *slot = place_set_find(seen, move->place);
+    if (!slot || slot->place) {
+        return slot;
+    }
+    int node = graph ? place_graph_add(graph) : seen->count;
+    Uint8 *saved = node >= 0 ? move_list_add(next, move, state_size) : NULL;
+    if (!saved) {
+        return NULL;
+    }
+    SDL_memcpy(saved, state, state_size);
+    *slot = (PlaceSlot){move->place, node};
+    seen->count++;
+    return slot;
+}
+
+/* Finds every place the player can get to from the level's first state,
+   linking them up into graph. Returns 0 if it ran out of memory; stopped is
+   set if the search had to give up before the end. */
+static int map_level(Search *search, JobSystem *jobs, const Uint8 *initial, Sint64 max_ticks, int max_states,
+                     PlaceSet *seen, PlaceGraph *graph, const char **stopped)
+{
+    MoveList frontier = {0};
+    Move start = {place_key(search, &search->workers[0].game), 0, 0, 0, 0, 0};
+    int ok = visit_place(seen, graph, &frontier, &start, initial, search->state_size) != NULL;
+    search->routing = 0;
+    for (Sint64 ticks = 0; ok && frontier.count > 0; ticks += search->step_ticks) {
+        if (ticks >= max_ticks || seen->count > max_states) {
+            *stopped = ticks >= max_ticks ? "out of time" : "too many places";
+            break;
+        }
+        search->first_node = graph->num_places - frontier.count;
+        ok = search_step(search, jobs, &frontier);
+
+        // Link up the steps, going on from the places nothing earlier reached
+        MoveList next = {0};
+        for (int w = 0; w < search->num_workers && ok; w++) {
+            Worker *worker = &search->workers[w];
+            for (int i = 0; ok && i < worker->moves.count; i++) {
+                const Move *move = &worker->moves.moves[i];
+                Edge *edge = &graph->edges[move->from * NUM_ACTIONS + move->action];
+                edge->gems = move->gems;
+                edge->goal = move->goal;
+                if (move->ended) {
+                    continue;
+                }
+                PlaceSlot *slot = visit_place(seen, graph, &next, move,
+                                              worker->moves.states + search->state_size * (size_t)i, search->state_size);
+                ok = slot != NULL;
+                if (ok) {
+                    // The graph may have grown, so look the edge up again
+                    graph->edges[move->from * NUM_ACTIONS + move->action].to = slot->node;
+                }
+            }
+        }
+        move_list_free(&frontier);
+        frontier = next;
+    }
+    move_list_free(&frontier);
+    return ok;
+}
+
+/* Adds what a worker reached, on the way to a route as well as while mapping, to found. */
+static void merge_findings(Findings *found, const Findings *findings, int num_gems)
+{
+    for (int i = 0; i < num_gems; i++) {
+        if (findings->gems[i] >= 0) {
+            note_time(&found->gems[i], findings->gems[i]);
+        }
+    }
+    if (findings->goal >= 0) {
+        note_time(&found->goal, findings->goal);
+    }
+}
+
+/* Whether every gem not in taken and the goal can be reached from node, going by the graph. */
+static int can_finish(const PlaceGraph *graph, Sint32 node, Uint64 taken, Uint64 all)
+{
+    Sint32 *queue = (Sint32 *)SDL_malloc(sizeof(Sint32) * (size_t)graph->num_places);
+    Uint8 *visited = (Uint8 *)SDL_calloc((size_t)graph->num_places, 1);
+    if (!queue || !visited) {
+        SDL_free(queue);
+        SDL_free(visited);
+        return 1; // Can't tell, so don't rule it out
+    }
+    int head = 0, tail = 0, goal = 0;
+    queue[tail++] = node;
+    visited[node] = 1;
+    while (head < tail && (taken != all || !goal)) {
+        const Edge *edges = &graph->edges[queue[head++] * NUM_ACTIONS];
+        for (int a = 0; a < NUM_ACTIONS; a++) {
+            taken |= edges[a].gems;
+            goal |= edges[a].goal != 0;
+            if (edges[a].to >= 0 && !visited[edges[a].to]) {
+                visited[edges[a].to] = 1;
+                queue[tail++] = edges[a].to;
+            }
+        }
+    }
+    SDL_free(queue);
+    SDL_free(visited);
+    return taken == all && goal;
+}
+
+/* Plays the level out from its first state, going for the nearest gem that
+   leaves the rest and the goal within reach each time. Returns the level
+   ticks it was won on, -1 if it wasn't and -2 if it ran out of memory. */
+static Sint64 route_level(Search *search, JobSystem *jobs, const Uint8 *initial, Sint64 max_ticks, int max_states,
+                          PlaceSet *places, const PlaceGraph *graph)
+{
+    Game *game = &search->workers[0].game;
+    Uint64 all = search->num_gems == MAX_ROUTE_GEMS ? ~(Uint64)0 : ((Uint64)1 << search->num_gems) - 1;
+    Uint8 *start = (Uint8 *)SDL_malloc(search->state_size);
+    if (!start) {
+        return -2;
+    }
+    SDL_memcpy(start, initial, search->state_size);
+
+    Sint64 won = -1;
+    int ok = 1, advanced = 1;
+    Uint64 taken = 0;
+    search->routing = 1;
+    while (ok && advanced && won < 0) {
+        game_load_state(game, start);
+        Sint64 ticks = level_time(game);
+        PlaceSet seen = {0};
+        MoveList frontier = {0};
+        Move first = {place_key(search, game), taken, 0, 0, 0, 0};
+        ok = visit_place(&seen, NULL, &frontier, &first, start, search->state_size) != NULL;
+        advanced = 0;
+
+        // Breadth first from the last gem, with a place only gone on from the first time; the first step
+        // taking another gem that doesn't rule the rest out is where the next part of the route starts
+        for (; ok && !advanced && won < 0 && frontier.count > 0 && ticks < max_ticks && seen.count <= max_states;
+             ticks += search->step_ticks) {
+            ok = search_step(search, jobs, &frontier);
+            MoveList next = {0};
+            for (int w = 0; w < search->num_workers && ok && !advanced && won < 0; w++) {
+                const MoveList *moves = &search->workers[w].moves;
+                for (int i = 0; i < moves->count && ok && !advanced && won < 0; i++) {
+                    const Move *move = &moves->moves[i];
+                    const Uint8 *state = moves->states + search->state_size * (size_t)i;
+                    if (move->ended) {
+                        game_load_state(game, state);
+                        won = level_time(game);
+                    } else if (move->gems != taken) {
+                        PlaceSlot *slot = place_set_find(places, move->place);
+                        if (!slot || !slot->place || can_finish(graph, slot->node, move->gems, all)) {
+                            SDL_memcpy(start, state, search->state_size);
+                            taken = move->gems;
+                            advanced = 1;
+                        }
+                    } else {
+                        ok = visit_place(&seen, NULL, &next, move, state, search->state_size) != NULL;
+                    }
+                }
+            }
+            move_list_free(&frontier);
+            frontier = next;
+        }
+        move_list_free(&frontier);
+        SDL_free(seen.slots);
+    }
+    SDL_free(start);
+    return ok ? won : -2;
+}
+
+static const char *format_time(char *text, size_t size, Sint64 ticks)
+{
+    if (ticks < 0) {
+        SDL_strlcpy(text, "never", size);
+    } else {
+        SDL_snprintf(text, size, "%.2f s (%d ticks)", (double)ticks / TICK_RATE, (int)ticks);
+    }
+    return text;
+}
+
+/* Searches one level and prints what was found; returns 1 if it can be completed. */
+static int check_level(const char *path, JobSystem *jobs, int num_workers, int step_ticks, Sint64 max_ticks,
+                       int max_states)
+{
+    Uint64 start = SDL_GetTicksNS();
+    for (int w = 0; w < num_workers; w++) {
+        if (!game_load_level_file(&workers[w].game, path)) {
+            SDL_Log("%s: couldn't load: %s", path, SDL_GetError());
+            return 0;
+        }
+    }
+
+    Game *first = &workers[0].game;
+    Search search = {0};
+    search.workers = workers;
+    search.num_workers = num_workers;
+    search.state_size = game_state_size(first);
+    search.step_ticks = step_ticks;
+    search.cell_size = CELL_SIZE * step_ticks / DEFAULT_STEP_TICKS;
+    search.num_gems = first->loaded_level.total_collectibles;
+    search.timed = first->loaded_level.stream->header.tables[LEVEL_TABLE_MOVERS].count > 0;
+    search.start_lives = first->lives;
+
+    int ok = 1;
+    for (int w = 0; w < num_workers && ok; w++) {
+        Findings *findings = &workers[w].findings;
+        SDL_free(findings->gems);
+        findings->gems = (Sint64 *)SDL_malloc(sizeof(Sint64) * (size_t)SDL_max(search.num_gems, 1));
+        ok = findings->gems != NULL;
+        for (int i = 0; ok && i < search.num_gems; i++) {
+            findings->gems[i] = -1;
+        }
+        findings->goal = -1;
+        move_list_free(&workers[w].moves); // Sized for the last level's states
+        workers[w].ok = 1;
+    }
+
+    // Both searches start from the level as loaded
+    PlaceSet seen = {0};
+    PlaceGraph graph = {0};
+    Findings found = {NULL, -1};
+    Uint8 *initial = (Uint8 *)SDL_malloc(search.state_size);
+    found.gems = (Sint64 *)SDL_malloc(sizeof(Sint64) * (size_t)SDL_max(search.num_gems, 1));
+    ok = ok && initial && found.gems;
+    for (int i = 0; ok && i < search.num_gems; i++) {
+        found.gems[i] = -1;
+    }
+    const char *failed = NULL;
+    if (ok) {
+        game_save_state(first, initial);
+        ok = map_level(&search, jobs, initial, max_ticks, max_states, &seen, &graph, &failed);
+    }
+
+    Sint64 won = -1;
+    if (ok && search.num_gems > MAX_ROUTE_GEMS) {
+        failed = "too many gems to route";
+    } else if (ok) {
+        won = route_level(&search, jobs, initial, max_ticks, max_states, &seen, &graph);
+        ok = won != -2;
+        if (won < 0 && !failed) {
+            failed = "no route found";
+        }
+    }
+    if (!ok) {
+        failed = "out of memory";
+        won = -1;
+    }
+    for (int w = 0; w < num_workers && found.gems && workers[w].findings.gems; w++) {
+        merge_findings(&found, &workers[w].findings, search.num_gems);
+    }
+
+    int num_found = 0;
+    for (int i = 0; found.gems && i < search.num_gems; i++) {
+        num_found += found.gems[i] >= 0;
+    }
+    char completed[64], goal[64];
+    SDL_Log("%s: completed %s%s%s - gems %d/%d, goal reached %s; %d places in %.2f s", path,
+            format_time(completed, sizeof(completed), won), won < 0 && failed ? ", " : "",
+            won < 0 && failed ? failed : "", num_found, search.num_gems, format_time(goal, sizeof(goal), found.goal),
+            seen.count, (double)(SDL_GetTicksNS() - start) / SDL_NS_PER_SECOND);
+    for (int i = 0; found.gems && i < search.num_gems; i++) {
+        if (found.gems[i] < 0) {
+            SDL_Log("%s: gem %d was never reached", path, i);
+        }
+    }
+
+    SDL_free(found.gems);
+    SDL_free(initial);
+    SDL_free(seen.slots);
+    SDL_free(graph.edges);
+    return won >= 0;
+}
+
+int main(int argc, char *argv[])
+{
+    int num_threads = 0;
+    int step_ticks = DEFAULT_STEP_TICKS;
+    int max_seconds = DEFAULT_MAX_SECONDS;
+    int max_states = DEFAULT_MAX_STATES;
+    int first_level = argc;
+    for (int i = 1; i < argc; i++) {
+        if (SDL_strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            num_threads = SDL_atoi(argv[++i]);
+        } else if (SDL_strcmp(argv[i], "--step") == 0 && i + 1 < argc) {
+            step_ticks = SDL_atoi(argv[++i]);
+        } else if (SDL_strcmp(argv[i], "--max-seconds") == 0 && i + 1 < argc) {
+            max_seconds = SDL_atoi(argv[++i]);
+        } else if (SDL_strcmp(argv[i], "--max-states") == 0 && i + 1 < argc) {
+            max_states = SDL_atoi(argv[++i]);
+        } else if (argv[i][0] != '-') {
+            first_level = i;
+            break;
+        } else {
+            break;
+        }
+    }
+    if (first_level == argc || step_ticks < 1 || step_ticks > 255) {
+        SDL_Log("Usage: %s [--threads N] [--step N] [--max-seconds N] [--max-states N] level.lvl...", argv[0]);
+        return 1;
+    }
+
+    static JobSystem jobs;
+    JobSystem *job_system = &jobs;
+    if (!jobs_init(&jobs, num_threads)) {
+        SDL_Log("Couldn't start job threads: %s", SDL_GetError());
+        job_system = NULL;
+    }
+    int num_workers = job_system ? jobs.num_threads + 1 : 1;
+
+    // A Game per thread, without walkers, particles or a rewind history
+    for (int w = 0; w < num_workers; w++) {
+        Worker *worker = &workers[w];
+        if (!game_init(&worker->game, PLAY_WIDTH, PLAY_HEIGHT, 1, 0, 0, &worker->profiler)) {
+            SDL_Log("Couldn't set up a game for thread %d", w);
+            return 1;
+        }
+        worker->game.external_particles = 1;
+        game_set_particle_detail(&worker->game, GAME_MIN_PARTICLE_DETAIL);
+        save_ring_free(&worker->game.rewind);
+    }
+
+    int failed = 0;
+    Uint64 start = SDL_GetTicksNS();
+    for (int i = first_level; i < argc; i++) {
+        failed += !check_level(argv[i], job_system, num_workers, step_ticks, (Sint64)max_seconds * TICK_RATE,
+                               max_states);
+    }
+    SDL_Log("%d of %d levels can be completed, checked in %.2f s on %d threads", argc - first_level - failed,
+            argc - first_level, (double)(SDL_GetTicksNS() - start) / SDL_NS_PER_SECOND, num_workers);
+
+    for (int w = 0; w < num_workers; w++) {
+        move_list_free(&workers[w].moves);
+        SDL_free(workers[w].findings.gems);
+        game_free(&workers[w].game);
+    }
+    if (job_system) {
+        jobs_shutdown(job_system);
+    }
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,144 @@
+/*
+  Frame pacing.
+*/
+#include "pacing.h"
+
+#define FALLBACK_HZ 60 // When the display's rate is unknown or the rate is uncapped
+#define SPIN_MIN_NS 100000 // Always spin at least this long
+#define SPIN_MAX_NS 4000000
+#define SPIN_SLACK_NS 100000 // Spin this much longer than sleeps have been overshooting
+#define SPIN_DECAY 32 // Frames for the margin to come most of the way back down
+#define PRESENT_SMOOTHING 0.1f // Weight of the newest present in the average
+#define VSYNC_CHECK_FRAMES 60
+
+static const int rates[] = { 60, 120, 144, PACING_UNCAPPED };
+
+void frame_pacer_init(FramePacer *pacer, SDL_Renderer *renderer, SDL_Window *window, int target_hz)
+{
+    SDL_zerop(pacer);
+    pacer->renderer = renderer;
+    const SDL_DisplayMode *mode = SDL_GetCurrentDisplayMode(SDL_GetDisplayForWindow(window));
+    if (mode && mode->refresh_rate > 0.0f) {
+        pacer->display_hz = (int)SDL_roundf(mode->refresh_rate);
+    }
+    pacer->spin_ns = SPIN_MAX_NS / 4;
+    frame_pacer_set_rate(pacer, target_hz);
+}
+
+void frame_pacer_set_rate(FramePacer *pacer, int target_hz)
+{
+    // Vsync does the pacing only when it runs at the rate asked for
+    int want_vsync;
+    if (target_hz == PACING_DISPLAY) {
+        target_hz = pacer->display_hz > 0 ? pacer->display_hz : FALLBACK_HZ;
+        want_vsync = 1;
+    } else {
+        want_vsync = target_hz != PACING_UNCAPPED && SDL_abs(target_hz - pacer->display_hz) <= 1;
+    }
+    pacer->target_hz = target_hz;
+    pacer->period_ns = target_hz != PACING_UNCAPPED ? SDL_NS_PER_SECOND / (Uint64)target_hz : 0;
+
+    int interval = 0;
+    pacer->vsync = want_vsync && SDL_SetRenderVSync(pacer->renderer, 1) &&
+                   SDL_GetRenderVSync(pacer->renderer, &interval) && interval != 0;
+    if (!pacer->vsync) {
+        SDL_SetRenderVSync(pacer->renderer, 0);
+    }
+    pacer->vsync_frames = 0;
+    pacer->deadline = SDL_GetTicksNS();
+}
+
+void frame_pacer_next_rate(FramePacer *pacer)
+{
+    int next = 0;
+    for (int i = 0; i < (int)SDL_arraysize(rates); i++) {
+        if (rates[i] == pacer->target_hz) {
+            next = (i + 1) % (int)SDL_arraysize(rates);
+            break;
+        }
+    }
+    frame_pacer_set_rate(pacer, rates[next]);
+}
+
+void frame_pacer_presented(FramePacer *pacer, Uint64 start)
+{
+    float present_ns = (float)(SDL_GetTicksNS() - start);
+    if (pacer->present_ns == 0.0f) {
+        pacer->present_ns = present_ns;
+    } else {
+        pacer->present_ns += (present_ns - pacer->present_ns) * PRESENT_SMOOTHING;
+    }
+}
+
+// Vsync that was accepted but isn't honoured shows up as frames faster than the display
+static void check_vsync(FramePacer *pacer, Uint64 now)
+{
+    if (pacer->display_hz <= 0 || pacer->vsync_frames > VSYNC_CHECK_FRAMES) {
+        return;
+    }
+    if (pacer->vsync_frames++ == 0) {
+        pacer->vsync_start = now;
+        return;
+    }
+    if (pacer->vsync_frames <= VSYNC_CHECK_FRAMES) {
+        return;
+    }
+    Uint64 average = (now - pacer->vsync_start) / VSYNC_CHECK_FRAMES;
+    Uint64 display_period = SDL_NS_PER_SECOND / (Uint64)pacer->display_hz;
+    if (average < display_period * 3 / 4) {
+        SDL_Log("Vsync isn't holding frames to %d Hz, pacing them here", pacer->display_hz);
+        SDL_SetRenderVSync(pacer->renderer, 0);
+        pacer->vsync = 0;
+        pacer->deadline = now;
+    }
+}
+
+void frame_pacer_wait(FramePacer *pacer)
+{
+    Uint64 now = SDL_GetTicksNS();
+    if (pacer->vsync) {
+        check_vsync(pacer, now);
+        return;
+    }
+    if (pacer->target_hz == PACING_UNCAPPED) {
+        return;
+    }
+
+    pacer->deadline += pacer->period_ns;
+    if (pacer->deadline <= now) {
+        pacer->deadline = now;
+        return;
+    }
+
+    // Sleep most of the way, learning from how far the sleep overshoots
+    if (pacer->deadline - now > pacer->spin_ns) {
+        Uint64 wake = pacer->deadline - pacer->spin_ns;
+        SDL_DelayNS(wake - now);
+        Uint64 woke = SDL_GetTicksNS();
+        Uint64 margin = (woke > wake ? woke - wake : 0) + SPIN_SLACK_NS;
+        if (margin > pacer->spin_ns) {
+            pacer->spin_ns = margin;
+        } else {
+            pacer->spin_ns -= (pacer->spin_ns - margin) / SPIN_DECAY;
+        }
+        pacer->spin_ns = SDL_clamp(pacer->spin_ns, SPIN_MIN_NS, SPIN_MAX_NS);
+    }
+
+    // and spin the rest
+    while (SDL_GetTicksNS() < pacer->deadline) {
+        SDL_CPUPauseInstruction();
+    }
+}
+
+Uint64 frame_pacer_budget(const FramePacer *pacer)
+{
+    return pacer->period_ns ? pacer->period_ns : SDL_NS_PER_SECOND / FALLBACK_HZ;
+}
+
+const char *frame_pacer_mode(const FramePacer *pacer)
+{
+    if (pacer->vsync) {
+        return "vsync";
+    }
+    return pacer->target_hz == PACING_UNCAPPED ? "uncapped" : "sleep+spin";
+}
@@ -0,0 +1,58 @@
+/*
+  Frame pacing.
+
+  Holds the frame rate to a target of 60, 120 or 144 Hz, or leaves it
+  uncapped. When the display refreshes at the target rate, presents wait
+  for vsync and nothing else is done. Otherwise vsync is turned off and the
+  pacer waits out the rest of each frame itself: it sleeps until shortly
+  before the deadline, then spins the last stretch, since a sleep can
+  overshoot by a good part of a millisecond. The spin margin follows how
+  far sleeps have been overshooting lately. Deadlines advance by whole
+  periods so errors don't accumulate, and a frame that misses its deadline
+  starts the next one at once rather than trying to catch up.
+
+  Vsync is checked once it is on: if the first frames come faster than the
+  display could show them, the driver isn't honouring it and the pacer
+  takes over. Present latency - how long SDL_RenderPresent blocks - is
+  tracked too, for the profiler overlay.
+*/
+#ifndef PACING_H
+#define PACING_H
+
+#include <SDL3/SDL.h>
+
+#define PACING_UNCAPPED 0
+#define PACING_DISPLAY -1 // Whatever the display refreshes at, on vsync
+
+typedef struct {
+    SDL_Renderer *renderer;
+    int display_hz; // Refresh rate of the window's display; 0 if unknown
+    int target_hz; // PACING_UNCAPPED for no limit
+    int vsync; // Presents wait for vsync
+    Uint64 period_ns; // Frame time at target_hz
+    Uint64 deadline; // When the next frame is due
+    Uint64 spin_ns; // How long before the deadline sleeping stops
+    float present_ns; // Smoothed present latency
+    int vsync_frames; // Frames seen while checking vsync
+    Uint64 vsync_start;
+} FramePacer;
+
+// Paces frames for the renderer's window at target_hz, PACING_UNCAPPED or PACING_DISPLAY.
+void frame_pacer_init(FramePacer *pacer, SDL_Renderer *renderer, SDL_Window *window, int target_hz);
+void frame_pacer_set_rate(FramePacer *pacer, int target_hz);
+
+// Cycles through 60, 120 and 144 Hz and uncapped.
+void frame_pacer_next_rate(FramePacer *pacer);
+
+// Records present latency, given the time taken with SDL_GetTicksNS just before presenting.
+void frame_pacer_presented(FramePacer *pacer, Uint64 start);
+
+// Waits until the next frame is due; call once a frame, after presenting.
+void frame_pacer_wait(FramePacer *pacer);
+
+// The frame time the game should budget for, which is 60 Hz when uncapped.
+Uint64 frame_pacer_budget(const FramePacer *pacer);
+
+const char *frame_pacer_mode(const FramePacer *pacer);
+
+#endif /* PACING_H */
@@ -0,0 +1,347 @@
+/*
+  Structure-of-arrays particle pool and update kernels.
+*/
+#include "particles.h"
+
+#if defined(SDL_SSE_INTRINSICS)
+#include <xmmintrin.h>
+#elif defined(SDL_NEON_INTRINSICS)
+#include <arm_neon.h>
+#endif
+
+// Arrays are padded to a whole number of SIMD lanes and aligned for vector loads
+#define PARTICLE_LANES 4
+#define PARTICLE_ALIGN 16
+
+int particle_pool_init(ParticlePool *pool, int capacity)
+{
+    SDL_zerop(pool);
+    if (capacity < 1) {
+        capacity = 1;
+    }
+    int padded = (capacity + PARTICLE_LANES - 1) & ~(PARTICLE_LANES - 1);
+
+    // One block for every attribute array, carved up below
+    size_t stride = sizeof(float) * (size_t)padded;
+    Uint8 *block = (Uint8 *)SDL_aligned_alloc(PARTICLE_ALIGN, stride * 7);
+    if (!block) {
+        return 0;
+    }
+
+    pool->x = (float *)(block + stride * 0);
+    pool->y = (float *)(block + stride * 1);
+    pool->vx = (float *)(block + stride * 2);
+    pool->vy = (float *)(block + stride * 3);
+    pool->life = (float *)(block + stride * 4);
+    pool->max_life = (float *)(block + stride * 5);
+    pool->color = (Uint32 *)(block + stride * 6);
+    pool->capacity = capacity;
+    pool->limit = capacity;
+    return 1;
+}
+
+void particle_pool_free(ParticlePool *pool)
+{
+    // x is the start of the shared block
+    SDL_aligned_free(pool->x);
+    SDL_zerop(pool);
+}
+
+void particle_pool_add(ParticlePool *pool, float x, float y, float vx, float vy,
+                       Uint8 r, Uint8 g, Uint8 b, float life)
+{
+    int i;
+    if (pool->count < pool->limit) {
+        i = pool->count++;
+    } else if (pool->count > 0) {
+        // Pool is full - recycle an existing particle rather than drop the new one
+        i = pool->recycle % pool->count;
+        pool->recycle = (i + 1) % pool->count;
+    } else {
+        return;
+    }
+
+    pool->x[i] = x;
+    pool->y[i] = y;
+    pool->vx[i] = vx;
+    pool->vy[i] = vy;
+    pool->life[i] = life;
+    pool->max_life[i] = life;
+    pool->color[i] = (Uint32)r | ((Uint32)g << 8) | ((Uint32)b << 16) | (255u << 24);
+}
+
+void particle_integrate_scalar(ParticlePool *pool, int begin, int end, float dt, float gravity)
+{
+    float *x = pool->x, *y = pool->y, *vx = pool->vx, *vy = pool->vy, *life = pool->life;
+    float gdt = gravity * dt;
+    for (int i = begin; i < end; i++) {
+        x[i] += vx[i] * dt;
+        y[i] += vy[i] * dt;
+        vy[i] += gdt;
+        life[i] -= dt;
+    }
+}
+
+void particle_integrate(ParticlePool *pool, int begin, int end, float dt, float gravity)
+{
+#if defined(SDL_SSE_INTRINSICS) || defined(SDL_NEON_INTRINSICS)
+    float *x = pool->x, *y = pool->y, *vx = pool->vx, *vy = pool->vy, *life = pool->life;
+    int i = begin;
+    int vec_end = begin + ((end - begin) & ~(PARTICLE_LANES - 1));
+
+#if defined(SDL_SSE_INTRINSICS)
+    const __m128 vdt = _mm_set1_ps(dt);
+    const __m128 vgdt = _mm_set1_ps(gravity * dt);
+    for (; i < vec_end; i += PARTICLE_LANES) {
+        __m128 pvx = _mm_loadu_ps(vx + i);
+        __m128 pvy = _mm_loadu_ps(vy + i);
+        _mm_storeu_ps(x + i, _mm_add_ps(_mm_loadu_ps(x + i), _mm_mul_ps(pvx, vdt)));
+        _mm_storeu_ps(y + i, _mm_add_ps(_mm_loadu_ps(y + i), _mm_mul_ps(pvy, vdt)));
+        _mm_storeu_ps(vy + i, _mm_add_ps(pvy, vgdt));
+        _mm_storeu_ps(life + i, _mm_sub_ps(_mm_loadu_ps(life + i), vdt));
+    }
+#else
+    const float32x4_t vdt = vdupq_n_f32(dt);
+    const float32x4_t vgdt = vdupq_n_f32(gravity * dt);
+    for (; i < vec_end; i += PARTICLE_LANES) {
+        float32x4_t pvx = vld1q_f32(vx + i);
+        float32x4_t pvy = vld1q_f32(vy + i);
+        vst1q_f32(x + i, vmlaq_f32(vld1q_f32(x + i), pvx, vdt));
+        vst1q_f32(y + i, vmlaq_f32(vld1q_f32(y + i), pvy, vdt));
+        vst1q_f32(vy + i, vaddq_f32(pvy, vgdt));
+        vst1q_f32(life + i, vsubq_f32(vld1q_f32(life + i), vdt));
+    }
+#endif
+
+    // Leftovers that don't fill a vector
+    particle_integrate_scalar(pool, i, end, dt, gravity);
+#else
+    particle_integrate_scalar(pool, begin, end, dt, gravity);
+#endif
+}
+
+void particle_pool_compact(ParticlePool *pool)
+{
+    float *life = pool->life;
+    int count = pool->count;
+    for (int i = 0; i < count; ) {
+        if (life[i] > 0) {
+            i++;
+            continue;
+        }
+
+        // Swap-remove; the moved particle is checked on the next pass over i
+        int last = --count;
+        pool->x[i] = pool->x[last];
+        pool->y[i] = pool->y[last];
+        pool->vx[i] = pool->vx[last];
+        pool->vy[i] = pool->vy[last];
+        life[i] = life[last];
+        pool->max_life[i] = pool->max_life[last];
+        pool->color[i] = pool->color[last];
+    }
+    pool->count = count;
+    if (pool->recycle >= count) {
+        pool->recycle = 0;
+    }
+}
+
+SDL_COMPILE_TIME_ASSERT(particle_spawn_size, sizeof(ParticleSpawn) == 32);
+
+static int particle_queue_reserve(ParticleQueue *queue, int count)
+{
+    if (count <= queue->capacity) {
+        return 1;
+    }
+    int capacity = SDL_max(count, queue->capacity ? queue->capacity * 2 : 256);
+    ParticleSpawn *spawns = (ParticleSpawn *)SDL_realloc(queue->spawns, sizeof(ParticleSpawn) * capacity);
+    if (!spawns) {
+        return 0;
+    }
+    queue->spawns = spawns;
+    Uint64 *ticks = (Uint64 *)SDL_realloc(queue->ticks, sizeof(Uint64) * capacity);
+    if (!ticks) {
+        return 0;
+    }
+    queue->ticks = ticks;
+    queue->capacity = capacity;
+    return 1;
+}
+
+int particle_queue_push(ParticleQueue *queue, Uint64 tick, float x, float y, float vx, float vy,
+                        Uint8 r, Uint8 g, Uint8 b, float life)
+{
+    if (!particle_queue_reserve(queue, queue->count + 1)) {
+        return 0;
+    }
+    Uint32 color = (Uint32)r | ((Uint32)g << 8) | ((Uint32)b << 16) | (255u << 24);
+    queue->spawns[queue->count] = (ParticleSpawn){x, y, vx, vy, life, life, color, 0.0f};
+    queue->ticks[queue->count] = tick;
+    queue->count++;
+    return 1;
+}
+
+int particle_queue_append(ParticleQueue *dest, ParticleQueue *source)
+{
+    int ok = particle_queue_reserve(dest, dest->count + source->count);
+    if (ok && source->count > 0) {
+        SDL_memcpy(dest->spawns + dest->count, source->spawns, sizeof(ParticleSpawn) * source->count);
+        SDL_memcpy(dest->ticks + dest->count, source->ticks, sizeof(Uint64) * source->count);
+        dest->count += source->count;
+    }
+    source->count = 0;
+    return ok;
+}
+
+void particle_queue_remove_front(ParticleQueue *queue, int count)
+{
+    count = SDL_clamp(count, 0, queue->count);
+    queue->count -= count;
+    if (count > 0 && queue->count > 0) {
+        SDL_memmove(queue->spawns, queue->spawns + count, sizeof(ParticleSpawn) * queue->count);
+        SDL_memmove(queue->ticks, queue->ticks + count, sizeof(Uint64) * queue->count);
+    }
+}
+
+void particle_queue_free(ParticleQueue *queue)
+{
+    SDL_free(queue->spawns);
+    SDL_free(queue->ticks);
+    SDL_zerop(queue);
+}
+
+void particle_spawn_advance(ParticleSpawn *spawn, int steps, float dt, float gravity)
+{
+    float gdt = gravity * dt;
+    for (int step = 0; step < steps && spawn->life > 0.0f; step++) {
+        spawn->x += spawn->vx * dt;
+        spawn->y += spawn->vy * dt;
+        spawn->vy += gdt;
+        spawn->life -= dt;
+    }
+}
+
+int particle_emitter_step(ParticleEmitter *emitter, float dt, float scale)
+{
+    emitter->pending += emitter->rate * scale * dt;
+    int due = (int)emitter->pending;
+    emitter->pending -= (float)due;
+    return due;
+}
+
+void particle_pool_update(ParticlePool *pool, float dt, float gravity)
+{
+    particle_integrate(pool, 0, pool->count, dt, gravity);
+    particle_pool_compact(pool);
+}
+
+const char *particle_kernel_name(void)
+{
+#if defined(SDL_SSE_INTRINSICS)
+    return "sse";
+#elif defined(SDL_NEON_INTRINSICS)
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
+
+// The array-of-structs layout and update loop the SoA pool replaced, kept as a baseline
+typedef struct {
+    float x, y, vx, vy;
+    float life, max_life;
+    Uint8 r, g, b, a;
+} BenchParticle;
+
+static void bench_update_aos(BenchParticle *particles, int *count, float dt, float gravity)
+{
+    for (int i = 0; i < *count; ) {
+        BenchParticle *p = &particles[i];
+        p->x += p->vx * dt;
+        p->y += p->vy * dt;
+        p->vy += gravity * dt;
+        p->life -= dt;
+
+        if (p->life <= 0) {
+            *p = particles[--(*count)];
+            continue;
+        }
+        i++;
+    }
+}
+
+static void bench_fill_pool(ParticlePool *pool, const BenchParticle *src, int count)
+{
+    pool->count = 0;
+    for (int i = 0; i < count; i++) {
+        particle_pool_add(pool, src[i].x, src[i].y, src[i].vx, src[i].vy,
+                          src[i].r, src[i].g, src[i].b, src[i].life);
+    }
+}
+
+static void bench_report(const char *name, int count, int iterations, Uint64 ns, float checksum)
+{
+    double ms = (double)ns / SDL_NS_PER_MS;
+    double rate = ms > 0.0 ? ((double)count * iterations) / ms : 0.0;
+    SDL_Log("  %-12s %8.2f ms  %12.0f particles/ms  (checksum %g)", name, ms, rate, checksum);
+}
+
+void particle_benchmark(int count, int iterations)
+{
+    const float dt = 1.0f / 120.0f;
+    const float gravity = 360.0f;
+
+    SDL_Log("Particle benchmark: %d particles x %d updates, kernel '%s'",
+            count, iterations, particle_kernel_name());
+
+    // Lifetimes long enough that the whole set stays alive for the run
+    BenchParticle *aos = (BenchParticle *)SDL_malloc(sizeof(BenchParticle) * count);
+    ParticlePool pool;
+    if (!aos || !particle_pool_init(&pool, count)) {
+        SDL_Log("Couldn't allocate benchmark particles");
+        SDL_free(aos);
+        return;
+    }
+
+    for (int i = 0; i < count; i++) {
+        float vx = (float)(i % 200 - 100);
+        float vy = (float)(i % 120 - 60);
+        aos[i] = (BenchParticle){(float)(i % 1200), (float)(i % 800), vx, vy, 1e6f, 1e6f, 255, 255, 255, 255};
+    }
+
+    // Runs the baseline on a copy so every variant starts from the same state
+    BenchParticle *work = (BenchParticle *)SDL_malloc(sizeof(BenchParticle) * count);
+    if (!work) {
+        SDL_Log("Couldn't allocate benchmark particles");
+        particle_pool_free(&pool);
+        SDL_free(aos);
+        return;
+    }
+    SDL_memcpy(work, aos, sizeof(BenchParticle) * count);
+
+    int aos_count = count;
+    Uint64 start = SDL_GetTicksNS();
+    for (int n = 0; n < iterations; n++) {
+        bench_update_aos(work, &aos_count, dt, gravity);
+    }
+    bench_report("aos scalar", count, iterations, SDL_GetTicksNS() - start, work[count - 1].y);
+
+    bench_fill_pool(&pool, aos, count);
+    start = SDL_GetTicksNS();
+    for (int n = 0; n < iterations; n++) {
+        particle_integrate_scalar(&pool, 0, pool.count, dt, gravity);
+        particle_pool_compact(&pool);
+    }
+    bench_report("soa scalar", count, iterations, SDL_GetTicksNS() - start, pool.y[count - 1]);
+
+    bench_fill_pool(&pool, aos, count);
+    start = SDL_GetTicksNS();
+    for (int n = 0; n < iterations; n++) {
+        particle_pool_update(&pool, dt, gravity);
+    }
+    bench_report("soa kernel", count, iterations, SDL_GetTicksNS() - start, pool.y[count - 1]);
+
+    particle_pool_free(&pool);
+    SDL_free(work);
+    SDL_free(aos);
+}
@@ -0,0 +1,85 @@
+/*
+  Structure-of-arrays particle pool.
+
+  Each particle attribute lives in its own float array so the update kernel
+  can integrate several particles per instruction. Live particles are packed
+  into [0, count); expired ones are swap-removed after integration.
+*/
+#ifndef PARTICLES_H
+#define PARTICLES_H
+
+#include <SDL3/SDL.h>
+
+typedef struct {
+    float *x, *y;
+    float *vx, *vy;
+    float *life, *max_life;
+    Uint32 *color; // RGBA packed as r | g << 8 | b << 16 | a << 24
+    int count;
+    int capacity;
+    int limit; // Live particles allowed, at most capacity; lowering it lets the excess expire
+    int recycle; // Next slot to overwrite once the pool is full
+} ParticlePool;
+
+// Continuous emitter - accumulates a rate so the output doesn't depend on how
+// often it's polled
+typedef struct {
+    float rate; // Particles per second
+    float pending; // Fraction of a particle owed from earlier steps
+} ParticleEmitter;
+
+// A particle to be spawned somewhere other than a pool, laid out the way the
+// GPU particle buffer stores it
+typedef struct {
+    float x, y, vx, vy;
+    float life, max_life;
+    Uint32 color; // Same packing as ParticlePool
+    float padding;
+} ParticleSpawn;
+
+// Spawns waiting to be handed over, grown as needed
+typedef struct {
+    ParticleSpawn *spawns;
+    Uint64 *ticks; // Per spawn, the tick it was emitted on
+    int count;
+    int capacity;
+} ParticleQueue;
+
+int particle_pool_init(ParticlePool *pool, int capacity);
+void particle_pool_free(ParticlePool *pool);
+void particle_pool_add(ParticlePool *pool, float x, float y, float vx, float vy,
+                       Uint8 r, Uint8 g, Uint8 b, float life);
+void particle_pool_update(ParticlePool *pool, float dt, float gravity);
+
+// Integrates particles [begin, end): position, gravity and life decay.
+// Does not remove anything, so ranges can be processed independently.
+void particle_integrate(ParticlePool *pool, int begin, int end, float dt, float gravity);
+void particle_integrate_scalar(ParticlePool *pool, int begin, int end, float dt, float gravity);
+
+// Swap-removes every particle whose life has run out.
+void particle_pool_compact(ParticlePool *pool);
+
+// Queues a spawn emitted on tick with the same arguments as particle_pool_add(). Returns 0, dropping it, if out of memory.
+int particle_queue_push(ParticleQueue *queue, Uint64 tick, float x, float y, float vx, float vy,
+                        Uint8 r, Uint8 g, Uint8 b, float life);
+
+// Moves every spawn in source to the end of dest and empties source. Returns 0
+// if dest couldn't grow, in which case the spawns are dropped.
+int particle_queue_append(ParticleQueue *dest, ParticleQueue *source);
+// Drops the first count spawns, keeping the rest in order.
+void particle_queue_remove_front(ParticleQueue *queue, int count);
+void particle_queue_free(ParticleQueue *queue);
+
+// Moves a spawn on by steps ticks with the same motion as particle_integrate().
+void particle_spawn_advance(ParticleSpawn *spawn, int steps, float dt, float gravity);
+
+// Advances the emitter by dt seconds at its rate times scale; returns how many particles are due.
+int particle_emitter_step(ParticleEmitter *emitter, float dt, float scale);
+
+// Name of the kernel particle_integrate() uses on this build ("sse", "neon" or "scalar").
+const char *particle_kernel_name(void);
+
+// Times the old AoS update against the SoA kernels and logs particles per millisecond.
+void particle_benchmark(int count, int iterations);
+
+#endif /* PARTICLES_H */
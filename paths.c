@@ -0,0 +1,46 @@
+/*
+  Closed-form mover paths.
+*/
+#include "paths.h"
+
+void mover_path_init(MoverPath *path, const LevelMover *mover)
+{
+    SDL_zerop(path);
+    path->num_points = (int)SDL_clamp(mover->num_points, 1u, (Uint32)LEVEL_MOVER_MAX_POINTS);
+    for (int i = 0; i < path->num_points; i++) {
+        path->points[i] = (SDL_FPoint){mover->points[i].x, mover->points[i].y};
+        if (i > 0) {
+            double dx = (double)path->points[i].x - path->points[i - 1].x;
+            double dy = (double)path->points[i].y - path->points[i - 1].y;
+            path->distance[i] = path->distance[i - 1] + SDL_sqrt(dx * dx + dy * dy);
+        }
+    }
+    path->speed = mover->speed;
+    path->phase = mover->phase;
+}
+
+SDL_FPoint mover_path_at(const MoverPath *path, double time)
+{
+    double length = path->distance[path->num_points - 1];
+    if (length <= 0 || path->speed <= 0) {
+        return path->points[0];
+    }
+
+    // Fold the way back onto the way there
+    double along = SDL_fmod(path->phase + path->speed * time, 2.0 * length);
+    if (along < 0) {
+        along += 2.0 * length;
+    }
+    if (along > length) {
+        along = 2.0 * length - along;
+    }
+
+    int i = 1;
+    while (i < path->num_points - 1 && along > path->distance[i]) {
+        i++;
+    }
+    double span = path->distance[i] - path->distance[i - 1];
+    double t = span > 0 ? (along - path->distance[i - 1]) / span : 0;
+    const SDL_FPoint *from = &path->points[i - 1], *to = &path->points[i];
+    return (SDL_FPoint){(float)(from->x + (to->x - from->x) * t), (float)(from->y + (to->y - from->y) * t)};
+}
@@ -0,0 +1,30 @@
+/*
+  Closed-form mover paths.
+
+  A moving platform's position is a pure function of time: it travels its
+  waypoints at a constant speed, first to last and back again. Nothing is
+  integrated, so there is no drift and no overshooting the ends however long
+  a level runs, and the position for any tick can be worked out on its own,
+  whether or not the platform was updated on the ticks before.
+*/
+#ifndef PATHS_H
+#define PATHS_H
+
+#include <SDL3/SDL.h>
+
+#include "level_file.h"
+
+typedef struct {
+    SDL_FPoint points[LEVEL_MOVER_MAX_POINTS];
+    double distance[LEVEL_MOVER_MAX_POINTS]; // From the first point to each one along the way there
+    int num_points;
+    double speed; // Pixels per second
+    double phase; // Pixels along the way there and back at time 0
+} MoverPath;
+
+void mover_path_init(MoverPath *path, const LevelMover *mover);
+
+// Top-left corner of the platform time seconds after the level started.
+SDL_FPoint mover_path_at(const MoverPath *path, double time);
+
+#endif /* PATHS_H */
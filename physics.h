@@ -0,0 +1,36 @@
+/*
+  Physics profiles.
+
+  A profile is the set of movement constants a level is played with. Each
+  level file names its profile, and the game picks a movement routine built
+  for it (and for whether the level has the double jump) once, when the
+  level starts, so the per-actor loop runs with its constants folded in.
+
+  To add a profile, add a line to PHYSICS_PROFILES; levelc learns its name
+  and the game gets its routines from the same line.
+*/
+#ifndef PHYSICS_H
+#define PHYSICS_H
+
+// X(id, name, gravity, jump strength, move speed, max fall speed, coyote ticks, jump buffer ticks)
+// Speeds are per second; tick counts may use TICK_RATE, they are only expanded in the game
+#define PHYSICS_PROFILES(X) \
+    X(NORMAL, normal, 720.0f, -480.0f, 300.0f, 1080.0f, TICK_RATE / 10, TICK_RATE * 2 / 15) \
+    X(LOW_GRAVITY, low_gravity, 480.0f, -480.0f, 300.0f, 720.0f, TICK_RATE / 5, TICK_RATE / 5) \
+    X(SPEED, speed, 900.0f, -540.0f, 480.0f, 1200.0f, TICK_RATE / 15, TICK_RATE / 10)
+
+typedef enum {
+#define PHYSICS_PROFILE_ID(id, name, ...) PHYSICS_##id,
+    PHYSICS_PROFILES(PHYSICS_PROFILE_ID)
+#undef PHYSICS_PROFILE_ID
+    PHYSICS_PROFILE_COUNT
+} PhysicsProfile;
+
+// The name a profile goes by in level text files
+static const char *const physics_profile_names[PHYSICS_PROFILE_COUNT] = {
+#define PHYSICS_PROFILE_NAME(id, name, ...) #name,
+    PHYSICS_PROFILES(PHYSICS_PROFILE_NAME)
+#undef PHYSICS_PROFILE_NAME
+};
+
+#endif /* PHYSICS_H */
@@ -0,0 +1,177 @@
+/*
+  Frame profiler.
+*/
+#include "profiler.h"
+
+static const char *phase_names[PROFILE_PHASE_COUNT] = {
+    "input",
+    "collision",
+    "entities",
+    "particles",
+    "background",
+    "world",
+    "player",
+    "particle_draw",
+    "hud",
+    "present",
+};
+
+// Ring slot of the i-th oldest completed frame
+static const ProfileFrame *frame_at(const Profiler *profiler, int i)
+{
+    int first = (profiler->next - profiler->count + PROFILE_HISTORY) % PROFILE_HISTORY;
+    return &profiler->frames[(first + i) % PROFILE_HISTORY];
+}
+
+static int compare_u64(const void *a, const void *b)
+{
+    Uint64 x = *(const Uint64 *)a, y = *(const Uint64 *)b;
+    return (x > y) - (x < y);
+}
+
+void profiler_begin_frame(Profiler *profiler)
+{
+    Uint64 now = SDL_GetTicksNS();
+    SDL_zero(profiler->current);
+    if (profiler->total_frames > 0) {
+        profiler->current.interval_ns = now - profiler->frame_start;
+    }
+    profiler->frame_start = now;
+}
+
+void profiler_end_frame(Profiler *profiler, int draw_calls)
+{
+    profiler->current.frame_ns = SDL_GetTicksNS() - profiler->frame_start;
+    profiler->current.draw_calls = draw_calls;
+    profiler->frames[profiler->next] = profiler->current;
+    profiler->next = (profiler->next + 1) % PROFILE_HISTORY;
+    if (profiler->count < PROFILE_HISTORY) {
+        profiler->count++;
+    }
+    profiler->total_frames++;
+}
+
+void profiler_add(Profiler *profiler, ProfilePhase phase, Uint64 start)
+{
+    profiler->current.phase_ns[phase] += SDL_GetTicksNS() - start;
+}
+
+void profiler_count_tick(Profiler *profiler)
+{
+    profiler->current.ticks++;
+}
+
+const char *profiler_phase_name(ProfilePhase phase)
+{
+    return phase_names[phase];
+}
+
+Uint64 profiler_phase_average(const Profiler *profiler, ProfilePhase phase)
+{
+    if (profiler->count == 0) {
+        return 0;
+    }
+    Uint64 total = 0;
+    for (int i = 0; i < profiler->count; i++) {
+        total += frame_at(profiler, i)->phase_ns[phase];
+    }
+    return total / profiler->count;
+}
+
+// Position, oldest first, of the first frame with an interval; the very first frame has none
+static int first_interval(const Profiler *profiler)
+{
+    return (Uint64)profiler->count == profiler->total_frames ? 1 : 0;
+}
+
+// Percentile of frame times, or of frame intervals
+static Uint64 percentile_of(const Profiler *profiler, int intervals, int percentile)
+{
+    int first = intervals ? first_interval(profiler) : 0;
+    int n = profiler->count - first;
+    if (n <= 0) {
+        return 0;
+    }
+    Uint64 sorted[PROFILE_HISTORY];
+    for (int i = 0; i < n; i++) {
+        const ProfileFrame *frame = frame_at(profiler, first + i);
+        sorted[i] = intervals ? frame->interval_ns : frame->frame_ns;
+    }
+    SDL_qsort(sorted, n, sizeof(Uint64), compare_u64);
+    int index = (n * percentile) / 100;
+    if (index >= n) {
+        index = n - 1;
+    }
+    return sorted[index];
+}
+
+Uint64 profiler_frame_percentile(const Profiler *profiler, int percentile)
+{
+    return percentile_of(profiler, 0, percentile);
+}
+
+Uint64 profiler_interval_percentile(const Profiler *profiler, int percentile)
+{
+    return percentile_of(profiler, 1, percentile);
+}
+
+Uint64 profiler_interval_jitter(const Profiler *profiler, Uint64 target_ns)
+{
+    int first = first_interval(profiler);
+    int n = profiler->count - first;
+    if (n <= 0) {
+        return 0;
+    }
+    if (target_ns == 0) {
+        Uint64 total = 0;
+        for (int i = first; i < profiler->count; i++) {
+            total += frame_at(profiler, i)->interval_ns;
+        }
+        target_ns = total / n;
+    }
+    Uint64 deviation = 0;
+    for (int i = first; i < profiler->count; i++) {
+        Uint64 interval = frame_at(profiler, i)->interval_ns;
+        deviation += interval > target_ns ? interval - target_ns : target_ns - interval;
+    }
+    return deviation / n;
+}
+
+int profiler_draw_calls_average(const Profiler *profiler)
+{
+    if (profiler->count == 0) {
+        return 0;
+    }
+    int total = 0;
+    for (int i = 0; i < profiler->count; i++) {
+        total += frame_at(profiler, i)->draw_calls;
+    }
+    return total / profiler->count;
+}
+
+int profiler_write_csv(const Profiler *profiler, const char *path)
+{
+    SDL_IOStream *io = SDL_IOFromFile(path, "w");
+    if (!io) {
+        return 0;
+    }
+
+    SDL_IOprintf(io, "frame,frame_ms,interval_ms,ticks,draw_calls");
+    for (int phase = 0; phase < PROFILE_PHASE_COUNT; phase++) {
+        SDL_IOprintf(io, ",%s_ms", phase_names[phase]);
+    }
+    SDL_IOprintf(io, "\n");
+
+    Uint64 first_frame = profiler->total_frames - profiler->count;
+    for (int i = 0; i < profiler->count; i++) {
+        const ProfileFrame *frame = frame_at(profiler, i);
+        SDL_IOprintf(io, "%" SDL_PRIu64 ",%.4f,%.4f,%d,%d", first_frame + i,
+                     frame->frame_ns / 1e6, frame->interval_ns / 1e6, frame->ticks, frame->draw_calls);
+        for (int phase = 0; phase < PROFILE_PHASE_COUNT; phase++) {
+            SDL_IOprintf(io, ",%.4f", frame->phase_ns[phase] / 1e6);
+        }
+        SDL_IOprintf(io, "\n");
+    }
+
+    return SDL_CloseIO(io);
+}
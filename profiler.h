@@ -0,0 +1,69 @@
+/*
+  Frame profiler.
+
+  Phases are timed with SDL_GetTicksNS around the code they cover and
+  accumulated into the current frame; completed frames go into a ring
+  buffer holding the last PROFILE_HISTORY frames, which the overlay and the
+  CSV dump read from. Each frame also records the interval since the one
+  before began, waits for vsync or the frame pacer included, which is what
+  frame pacing jitter is measured from.
+*/
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <SDL3/SDL.h>
+
+typedef enum {
+    PROFILE_INPUT,
+    PROFILE_COLLISION,
+    PROFILE_ENTITIES,
+    PROFILE_PARTICLES,
+    PROFILE_BACKGROUND,
+    PROFILE_WORLD,
+    PROFILE_PLAYER,
+    PROFILE_PARTICLE_DRAW,
+    PROFILE_HUD,
+    PROFILE_PRESENT,
+    PROFILE_PHASE_COUNT
+} ProfilePhase;
+
+#define PROFILE_HISTORY 256
+
+typedef struct {
+    Uint64 frame_ns;
+    Uint64 interval_ns; // Since the previous frame began; 0 for the first
+    Uint64 phase_ns[PROFILE_PHASE_COUNT];
+    int ticks; // Simulation ticks run this frame
+    int draw_calls;
+} ProfileFrame;
+
+typedef struct {
+    ProfileFrame frames[PROFILE_HISTORY];
+    ProfileFrame current;
+    Uint64 frame_start;
+    int next; // Ring slot the current frame goes into
+    int count; // Completed frames in the ring
+    Uint64 total_frames;
+} Profiler;
+
+void profiler_begin_frame(Profiler *profiler);
+void profiler_end_frame(Profiler *profiler, int draw_calls);
+
+// Adds the time since start, taken with SDL_GetTicksNS, to a phase of the current frame.
+void profiler_add(Profiler *profiler, ProfilePhase phase, Uint64 start);
+void profiler_count_tick(Profiler *profiler);
+
+const char *profiler_phase_name(ProfilePhase phase);
+
+// Summaries over the frames in the ring
+Uint64 profiler_phase_average(const Profiler *profiler, ProfilePhase phase);
+Uint64 profiler_frame_percentile(const Profiler *profiler, int percentile);
+Uint64 profiler_interval_percentile(const Profiler *profiler, int percentile);
+// Mean absolute deviation of frame intervals from target_ns, or from their own mean when target_ns is 0.
+Uint64 profiler_interval_jitter(const Profiler *profiler, Uint64 target_ns);
+int profiler_draw_calls_average(const Profiler *profiler);
+
+// Writes one row per frame in the ring, oldest first.
+int profiler_write_csv(const Profiler *profiler, const char *path);
+
+#endif /* PROFILER_H */
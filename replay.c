@@ -0,0 +1,134 @@
+/*
+  Input recording and replay.
+*/
+#include "replay.h"
+
+SDL_COMPILE_TIME_ASSERT(replay_header_size, sizeof(ReplayHeader) == 48);
+
+void replay_init(Replay *replay, Uint64 seed, float width, float height, int num_walkers, int particle_capacity)
+{
+    SDL_zerop(replay);
+    replay->seed = seed;
+    replay->width = width;
+    replay->height = height;
+    replay->num_walkers = num_walkers;
+    replay->particle_capacity = particle_capacity;
+}
+
+void replay_free(Replay *replay)
+{
+    SDL_free(replay->runs);
+    SDL_zerop(replay);
+}
+
+int replay_record(Replay *replay, const GameInput *input)
+{
+    Uint32 buttons = input->buttons & 0xFF;
+    replay->num_ticks++;
+
+    // Extend the last run while the buttons stay the same
+    if (replay->num_runs > 0) {
+        Uint32 *last = &replay->runs[replay->num_runs - 1];
+        if (REPLAY_RUN_BUTTONS(*last) == buttons && REPLAY_RUN_LENGTH(*last) < REPLAY_MAX_RUN_LENGTH) {
+            *last += 1 << 8;
+            return 1;
+        }
+    }
+
+    if (replay->num_runs == replay->capacity) {
+        int capacity = replay->capacity ? replay->capacity * 2 : 1024;
+        Uint32 *runs = (Uint32 *)SDL_realloc(replay->runs, sizeof(Uint32) * capacity);
+        if (!runs) {
+            replay->num_ticks--;
+            return 0;
+        }
+        replay->runs = runs;
+        replay->capacity = capacity;
+    }
+    replay->runs[replay->num_runs++] = (1 << 8) | buttons;
+    return 1;
+}
+
+int replay_save(const Replay *replay, const char *path)
+{
+    ReplayHeader header;
+    SDL_zero(header);
+    SDL_memcpy(header.magic, REPLAY_MAGIC, 4);
+    header.version = REPLAY_VERSION;
+    header.seed = replay->seed;
+    header.width = replay->width;
+    header.height = replay->height;
+    header.num_ticks = replay->num_ticks;
+    header.num_runs = (Uint32)replay->num_runs;
+    header.num_walkers = (Uint32)replay->num_walkers;
+    header.particle_capacity = (Uint32)replay->particle_capacity;
+
+    SDL_IOStream *io = SDL_IOFromFile(path, "wb");
+    if (!io) {
+        return 0;
+    }
+    size_t runs_size = sizeof(Uint32) * replay->num_runs;
+    int ok = SDL_WriteIO(io, &header, sizeof(header)) == sizeof(header) &&
+             (runs_size == 0 || SDL_WriteIO(io, replay->runs, runs_size) == runs_size);
+    if (!SDL_CloseIO(io)) {
+        ok = 0;
+    }
+    return ok;
+}
+
+int replay_load(Replay *replay, const char *path)
+{
+    SDL_zerop(replay);
+    if (SDL_BYTEORDER != SDL_LIL_ENDIAN) {
+        return SDL_SetError("%s: replays are little-endian", path);
+    }
+
+    size_t size;
+    Uint8 *data = (Uint8 *)SDL_LoadFile(path, &size);
+    if (!data) {
+        return 0;
+    }
+
+    ReplayHeader header;
+    if (size < sizeof(header)) {
+        SDL_free(data);
+        return SDL_SetError("%s: truncated replay", path);
+    }
+    SDL_memcpy(&header, data, sizeof(header));
+    if (SDL_memcmp(header.magic, REPLAY_MAGIC, 4) != 0 || header.version != REPLAY_VERSION) {
+        SDL_free(data);
+        return SDL_SetError("%s: not a version %d replay", path, REPLAY_VERSION);
+    }
+    if (header.num_runs > (size - sizeof(header)) / sizeof(Uint32)) {
+        SDL_free(data);
+        return SDL_SetError("%s: truncated replay", path);
+    }
+
+    replay_init(replay, header.seed, header.width, header.height, (int)header.num_walkers, (int)header.particle_capacity);
+    if (header.num_runs > 0) {
+        replay->runs = (Uint32 *)SDL_malloc(sizeof(Uint32) * header.num_runs);
+        if (!replay->runs) {
+            SDL_free(data);
+            return 0;
+        }
+        SDL_memcpy(replay->runs, data + sizeof(header), sizeof(Uint32) * header.num_runs);
+    }
+    replay->num_runs = replay->capacity = (int)header.num_runs;
+    replay->num_ticks = header.num_ticks;
+    SDL_free(data);
+    return 1;
+}
+
+int replay_next(Replay *replay, GameInput *input)
+{
+    while (replay->run < replay->num_runs && replay->run_tick >= REPLAY_RUN_LENGTH(replay->runs[replay->run])) {
+        replay->run++;
+        replay->run_tick = 0;
+    }
+    if (replay->run >= replay->num_runs) {
+        return 0;
+    }
+    input->buttons = REPLAY_RUN_BUTTONS(replay->runs[replay->run]);
+    replay->run_tick++;
+    return 1;
+}
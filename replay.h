@@ -0,0 +1,68 @@
+/*
+  Input recording and replay.
+
+  A replay is the seed, play area, walker count and particle capacity a
+  session started with plus the GameInput of every tick, run-length
+  encoded. Since the simulation is fixed-step and all randomness comes from
+  the seed, feeding the inputs back reproduces the session bit for bit.
+
+  File layout (little-endian): a ReplayHeader followed by num_runs Uint32
+  runs, each holding the buttons in the low 8 bits and the number of ticks
+  they were held for in the upper 24.
+*/
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <SDL3/SDL.h>
+
+#include "game.h"
+
+#define REPLAY_MAGIC "PRPL"
+#define REPLAY_VERSION 2
+
+#define REPLAY_RUN_BUTTONS(run) ((run) & 0xFF)
+#define REPLAY_RUN_LENGTH(run) ((run) >> 8)
+#define REPLAY_MAX_RUN_LENGTH 0xFFFFFF
+
+typedef struct {
+    char magic[4];
+    Uint32 version;
+    Uint64 seed;
+    float width, height;
+    Uint64 num_ticks;
+    Uint32 num_runs;
+    Uint32 num_walkers;
+    Uint32 particle_capacity;
+    Uint32 reserved; // Zero
+} ReplayHeader;
+
+typedef struct {
+    Uint64 seed;
+    float width, height;
+    int num_walkers;
+    int particle_capacity;
+    Uint64 num_ticks;
+
+    Uint32 *runs;
+    int num_runs;
+    int capacity;
+
+    // Playback position
+    int run;
+    Uint32 run_tick;
+} Replay;
+
+// Starts an empty recording for a session with the given seed, play area, walkers and particle pool.
+void replay_init(Replay *replay, Uint64 seed, float width, float height, int num_walkers, int particle_capacity);
+void replay_free(Replay *replay);
+
+// Appends one tick of input. Returns 0 if out of memory.
+int replay_record(Replay *replay, const GameInput *input);
+
+int replay_save(const Replay *replay, const char *path);
+int replay_load(Replay *replay, const char *path);
+
+// Reads the next tick of input; returns 0 once the replay is exhausted.
+int replay_next(Replay *replay, GameInput *input);
+
+#endif /* REPLAY_H */
@@ -0,0 +1,48 @@
+/*
+  PCG32 random number generator, see https://www.pcg-random.org/.
+*/
+#include "rng.h"
+
+#define PCG_MULTIPLIER 6364136223846793005ULL
+
+void rng_seed(Rng *rng, Uint64 seed, Uint64 stream)
+{
+    rng->state = 0;
+    rng->inc = (stream << 1) | 1;
+    rng_next(rng);
+    rng->state += seed;
+    rng_next(rng);
+}
+
+Uint32 rng_next(Rng *rng)
+{
+    Uint64 old = rng->state;
+    rng->state = old * PCG_MULTIPLIER + rng->inc;
+    Uint32 xorshifted = (Uint32)(((old >> 18) ^ old) >> 27);
+    Uint32 rot = (Uint32)(old >> 59);
+    return (xorshifted >> rot) | (xorshifted << ((32 - rot) & 31));
+}
+
+float rng_float(Rng *rng)
+{
+    // The top 24 bits fill a float mantissa exactly
+    return (float)(rng_next(rng) >> 8) * (1.0f / 16777216.0f);
+}
+
+float rng_range(Rng *rng, float min, float max)
+{
+    return min + (max - min) * rng_float(rng);
+}
+
+int rng_int(Rng *rng, int n)
+{
+    return (int)(((Uint64)rng_next(rng) * (Uint32)n) >> 32);
+}
+
+void rng_fill_floats(Rng *rng, float *out, int count, float min, float max)
+{
+    float scale = (max - min) * (1.0f / 16777216.0f);
+    for (int i = 0; i < count; i++) {
+        out[i] = min + (float)(rng_next(rng) >> 8) * scale;
+    }
+}
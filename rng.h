@@ -0,0 +1,34 @@
+/*
+  Small seeded random number generator (PCG32).
+
+  Each subsystem owns its own Rng so the streams don't disturb each other,
+  and a run can be reproduced exactly from its seed.
+*/
+#ifndef RNG_H
+#define RNG_H
+
+#include <SDL3/SDL.h>
+
+typedef struct {
+    Uint64 state;
+    Uint64 inc; // Stream selector, always odd
+} Rng;
+
+// Seeds the generator; different streams with the same seed give independent sequences.
+void rng_seed(Rng *rng, Uint64 seed, Uint64 stream);
+
+Uint32 rng_next(Rng *rng);
+
+// Uniform float in [0, 1).
+float rng_float(Rng *rng);
+
+// Uniform float in [min, max).
+float rng_range(Rng *rng, float min, float max);
+
+// Uniform integer in [0, n), without a modulo.
+int rng_int(Rng *rng, int n);
+
+// Fills out with count uniform floats in [min, max), for emitters that need a batch at once.
+void rng_fill_floats(Rng *rng, float *out, int count, float min, float max);
+
+#endif /* RNG_H */
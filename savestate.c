@@ -0,0 +1,91 @@
+/*
+  Save-state ring.
+*/
+#include "savestate.h"
+
+#define SAVE_STATE_ALIGN 16
+
+int save_ring_init(SaveRing *ring, size_t size)
+{
+    SDL_zerop(ring);
+    ring->data = (Uint8 *)SDL_malloc(size);
+    if (!ring->data) {
+        return 0;
+    }
+    ring->size = size;
+    return 1;
+}
+
+void save_ring_free(SaveRing *ring)
+{
+    SDL_free(ring->data);
+    SDL_zerop(ring);
+}
+
+void save_ring_clear(SaveRing *ring)
+{
+    ring->first = 0;
+    ring->count = 0;
+}
+
+static void drop_oldest(SaveRing *ring)
+{
+    ring->first = (ring->first + 1) % SAVE_RING_MAX_STATES;
+    ring->count--;
+}
+
+void *save_ring_push(SaveRing *ring, size_t size)
+{
+    size = (size + SAVE_STATE_ALIGN - 1) & ~(size_t)(SAVE_STATE_ALIGN - 1);
+    if (!ring->data || size > ring->size) {
+        return NULL;
+    }
+
+    // Right after the newest state, or back at the start if it doesn't fit before the end
+    size_t at = 0;
+    if (ring->count > 0) {
+        int newest = (ring->first + ring->count - 1) % SAVE_RING_MAX_STATES;
+        at = ring->offsets[newest] + ring->sizes[newest];
+    }
+    int wrapped = at + size > ring->size;
+    size_t skipped = at; // Anything from here to the end is older than what's at the start
+    if (wrapped) {
+        at = 0;
+    }
+
+    // States only ever get newer going forward from the oldest, so the ones in the way are all at the front
+    while (ring->count > 0) {
+        size_t offset = ring->offsets[ring->first];
+        int in_skipped = wrapped && offset >= skipped;
+        int overlaps = offset < at + size && offset + ring->sizes[ring->first] > at;
+        if (!in_skipped && !overlaps && ring->count < SAVE_RING_MAX_STATES) {
+            break;
+        }
+        drop_oldest(ring);
+    }
+
+    int index = (ring->first + ring->count) % SAVE_RING_MAX_STATES;
+    ring->offsets[index] = at;
+    ring->sizes[index] = size;
+    ring->count++;
+    return ring->data + at;
+}
+
+const void *save_ring_newest(const SaveRing *ring, size_t *size)
+{
+    if (ring->count == 0) {
+        return NULL;
+    }
+    int newest = (ring->first + ring->count - 1) % SAVE_RING_MAX_STATES;
+    if (size) {
+        *size = ring->sizes[newest];
+    }
+    return ring->data + ring->offsets[newest];
+}
+
+void save_ring_pop(SaveRing *ring)
+{
+    if (ring->count > 0) {
+        ring->count--;
+    }
+}
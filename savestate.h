@@ -0,0 +1,40 @@
+/*
+  Save-state ring.
+
+  Recent save states kept back to back in one fixed block of memory, newest
+  last. States are plain bytes of any size; when a new one doesn't fit, the
+  oldest are dropped to make room, so the ring always holds as much recent
+  history as its size allows and never allocates after it is set up.
+*/
+#ifndef SAVESTATE_H
+#define SAVESTATE_H
+
+#include <SDL3/SDL.h>
+
+#define SAVE_RING_MAX_STATES 4096
+
+typedef struct {
+    Uint8 *data;
+    size_t size;
+    size_t offsets[SAVE_RING_MAX_STATES]; // Of each state, oldest at index first
+    size_t sizes[SAVE_RING_MAX_STATES];
+    int first;
+    int count;
+} SaveRing;
+
+// Allocates size bytes for states. Returns 0 if out of memory.
+int save_ring_init(SaveRing *ring, size_t size);
+void save_ring_free(SaveRing *ring);
+void save_ring_clear(SaveRing *ring);
+
+// Makes room for a state of size bytes after the newest one and returns
+// where to write it, or NULL if it is bigger than the whole ring.
+void *save_ring_push(SaveRing *ring, size_t size);
+
+// The newest state, or NULL if there is none.
+const void *save_ring_newest(const SaveRing *ring, size_t *size);
+
+// Drops the newest state, making the one before it the newest.
+void save_ring_pop(SaveRing *ring);
+
+#endif /* SAVESTATE_H */
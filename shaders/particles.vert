@@ -0,0 +1,43 @@
+#version 450
+// One instance per particle: a 2x2 pixel quad drawn as a four vertex strip,
+// faded by remaining life. Dead particles collapse off screen.
+
+struct Particle {
+    vec2 position;
+    vec2 velocity;
+    float life;
+    float max_life;
+    uint color;
+    float padding;
+};
+
+layout(std430, set = 0, binding = 0) readonly buffer Particles {
+    Particle particles[];
+};
+
+layout(set = 1, binding = 0) uniform View {
+    vec2 camera; // World position of the target's top-left corner
+    vec2 target_size;
+};
+
+layout(location = 0) out vec4 frag_color;
+
+void main()
+{
+    Particle p = particles[gl_InstanceIndex];
+    if (p.life <= 0.0) {
+        gl_Position = vec4(2.0, 2.0, 0.0, 1.0);
+        frag_color = vec4(0.0);
+        return;
+    }
+
+    vec2 corner = vec2(gl_VertexIndex & 1, gl_VertexIndex >> 1);
+    vec2 pixel = p.position - camera - 1.0 + corner * 2.0;
+    vec2 ndc = pixel / target_size * 2.0 - 1.0;
+    gl_Position = vec4(ndc.x, -ndc.y, 0.0, 1.0);
+
+    // Premultiplied, so the target composites like the HUD cache does
+    vec4 color = unpackUnorm4x8(p.color);
+    color.a *= clamp(p.life / p.max_life, 0.0, 1.0);
+    frag_color = vec4(color.rgb * color.a, color.a);
+}
@@ -0,0 +1,236 @@
+/*
+  Render snapshots and the triple buffer between simulation and renderer.
+*/
+#include "snapshot.h"
+
+// Slack around the view for interpolation, gem bobbing and glows
+#define SNAPSHOT_VIEW_MARGIN 16.0f
+
+void snapshot_buffer_init(SnapshotBuffer *buffer)
+{
+    SDL_zerop(buffer);
+    buffer->write = 0;
+    SDL_SetAtomicInt(&buffer->latest, 1);
+    buffer->read = 2;
+}
+
+void snapshot_buffer_free(SnapshotBuffer *buffer)
+{
+    for (int i = 0; i < 3; i++) {
+        RenderSnapshot *snapshot = &buffer->snapshots[i];
+        SDL_free(snapshot->platforms);
+        SDL_free(snapshot->lava);
+        SDL_free(snapshot->gems);
+        SDL_free(snapshot->movers);
+        SDL_free(snapshot->prev_movers);
+        SDL_free(snapshot->walkers);
+        SDL_free(snapshot->prev_walkers);
+        SDL_free(snapshot->particles);
+        SDL_free(snapshot->visible);
+    }
+    SDL_zerop(buffer);
+}
+
+// Grows an array to hold count items; keeps the old one and returns 0 on failure
+static int reserve(void **array, int *capacity, int count, size_t item_size)
+{
+    if (count <= *capacity) {
+        return 1;
+    }
+    int new_capacity = SDL_max(count, *capacity * 2);
+    void *grown = SDL_realloc(*array, item_size * (size_t)new_capacity);
+    if (!grown) {
+        return 0;
+    }
+    *array = grown;
+    *capacity = new_capacity;
+    return 1;
+}
+
+// Like reserve, for the paired current/previous rect arrays sharing one capacity
+static int reserve_pair(SDL_FRect **a, SDL_FRect **b, int *capacity, int count)
+{
+    int capacity_a = *capacity, capacity_b = *capacity;
+    if (!reserve((void **)a, &capacity_a, count, sizeof(SDL_FRect)) ||
+        !reserve((void **)b, &capacity_b, capacity_a, sizeof(SDL_FRect))) {
+        return 0;
+    }
+    *capacity = capacity_a;
+    return 1;
+}
+
+static int point_in_view(float x, float y, const SDL_FRect *view)
+{
+    return x >= view->x && x <= view->x + view->w && y >= view->y && y <= view->y + view->h;
+}
+
+// Queries the broadphase into snapshot->visible, growing it until every hit fits
+static int query_view(RenderSnapshot *snapshot, Broadphase *broadphase, SDL_FRect view, int *ok)
+{
+    for (;;) {
+        int found = broadphase_query(broadphase, view, snapshot->visible, snapshot->visible_capacity);
+        if (found < snapshot->visible_capacity) {
+            return found;
+        }
+        if (!reserve((void **)&snapshot->visible, &snapshot->visible_capacity,
+                     SDL_max(snapshot->visible_capacity * 2, 256), sizeof(Uint32))) {
+            *ok = 0;
+            return found;
+        }
+    }
+}
+
+int snapshot_capture(RenderSnapshot *snapshot, Game *game, Uint64 time_ns)
+{
+    Level *level = &game->loaded_level;
+    const ActorTable *actors = &game->actors;
+    int ok = 1;
+
+    snapshot->tick = game->tick;
+    snapshot->time_ns = time_ns;
+    snapshot->score = game->score;
+    snapshot->lives = game->lives;
+    snapshot->current_level = game->current_level;
+    snapshot->collected_count = game->collected_count;
+    snapshot->num_collectibles = level->total_collectibles;
+    snapshot->game_over = game->game_over;
+    snapshot->game_won = game->game_won;
+    snapshot->has_double_jump = game->has_double_jump;
+    snapshot->global_timer = game->global_timer;
+
+    snapshot->player = actor_rect(actors, ACTOR_PLAYER);
+    snapshot->prev_player = actor_prev_rect(actors, ACTOR_PLAYER);
+    snapshot->player_rotation = game->player_rotation;
+    snapshot->invincibility_timer = actors->invincibility_timer[ACTOR_PLAYER];
+    snapshot->walk_timer = actors->walk_timer[ACTOR_PLAYER];
+    snapshot->walking = actors->walking[ACTOR_PLAYER];
+
+    // Everything either camera position shows, so interpolating between them pops nothing in
+    snapshot->camera = game->camera;
+    snapshot->prev_camera = game->prev_camera;
+    SDL_FRect view = {SDL_min(game->camera.x, game->prev_camera.x) - SNAPSHOT_VIEW_MARGIN,
+                      SDL_min(game->camera.y, game->prev_camera.y) - SNAPSHOT_VIEW_MARGIN,
+                      game->width + SDL_fabsf(game->camera.x - game->prev_camera.x) + SNAPSHOT_VIEW_MARGIN * 2,
+                      game->height + SDL_fabsf(game->camera.y - game->prev_camera.y) + SNAPSHOT_VIEW_MARGIN * 2};
+
+    // Static geometry comes whole tiles at a time, clamped to the level
+    int tile_cols = SDL_max((int)SDL_ceilf(level->width / SNAPSHOT_TILE_SIZE), 1);
+    int tile_rows = SDL_max((int)SDL_ceilf(level->height / SNAPSHOT_TILE_SIZE), 1);
+    int left = SDL_clamp((int)SDL_floorf(view.x / SNAPSHOT_TILE_SIZE), 0, tile_cols - 1);
+    int top = SDL_clamp((int)SDL_floorf(view.y / SNAPSHOT_TILE_SIZE), 0, tile_rows - 1);
+    int right = SDL_clamp((int)SDL_floorf((view.x + view.w) / SNAPSHOT_TILE_SIZE), left, tile_cols - 1);
+    int bottom = SDL_clamp((int)SDL_floorf((view.y + view.h) / SNAPSHOT_TILE_SIZE), top, tile_rows - 1);
+    snapshot->level_serial = game->level_serial;
+    snapshot->active_chunks = level->active_chunks;
+    snapshot->tiles = (SDL_Rect){left, top, right - left + 1, bottom - top + 1};
+    SDL_FRect cover = {left * SNAPSHOT_TILE_SIZE, top * SNAPSHOT_TILE_SIZE,
+                       snapshot->tiles.w * SNAPSHOT_TILE_SIZE, snapshot->tiles.h * SNAPSHOT_TILE_SIZE};
+    SDL_FRect query;
+    SDL_GetRectUnionFloat(&view, &cover, &query);
+    int num_visible = query_view(snapshot, &level->broadphase, query, &ok);
+    float bob_time = game_bob_time(game);
+
+    // Each kind gets room for everything found, which bounds how many of it there can be
+    snapshot->goal = level->goal;
+    snapshot->goal_visible = 0;
+    snapshot->num_platforms = 0;
+    snapshot->num_lava = 0;
+    snapshot->num_gems = 0;
+    snapshot->num_movers = 0;
+    if (reserve((void **)&snapshot->platforms, &snapshot->platforms_capacity, num_visible, sizeof(SDL_FRect)) &&
+        reserve((void **)&snapshot->lava, &snapshot->lava_capacity, num_visible, sizeof(SnapshotLava)) &&
+        reserve((void **)&snapshot->gems, &snapshot->gems_capacity, num_visible, sizeof(SDL_FRect)) &&
+        reserve_pair(&snapshot->movers, &snapshot->prev_movers, &snapshot->movers_capacity, num_visible)) {
+        for (int i = 0; i < num_visible; i++) {
+            Uint32 handle = snapshot->visible[i];
+            int index = ENTITY_INDEX(handle);
+            switch (ENTITY_TYPE(handle)) {
+            case ENTITY_PLATFORM:
+                snapshot->platforms[snapshot->num_platforms++] = level->platforms[index];
+                break;
+            case ENTITY_LAVA:
+                snapshot->lava[snapshot->num_lava++] = (SnapshotLava){level->lava_squares[index], index};
+                break;
+            case ENTITY_GOAL:
+                snapshot->goal_visible = 1;
+                break;
+            case ENTITY_COLLECTIBLE: {
+                // The broadphase only holds uncollected gems; the bob is worked out for the ones in view
+                const Collectible *collectible = &level->collectibles[index];
+                if (SDL_HasRectIntersectionFloat(&collectible->rect, &view)) {
+                    SDL_FRect rect = collectible->rect;
+                    rect.y += SDL_sinf(collectible->bob_phase + bob_time) * COLLECTIBLE_BOB_HEIGHT;
+                    snapshot->gems[snapshot->num_gems++] = rect;
+                }
+                break;
+            }
+            case ENTITY_MOVING_PLATFORM:
+                if (!SDL_HasRectIntersectionFloat(&level->moving_platforms[index].rect, &view)) {
+                    break;
+                }
+                snapshot->movers[snapshot->num_movers] = level->moving_platforms[index].rect;
+                snapshot->prev_movers[snapshot->num_movers] = level->moving_platforms[index].prev_rect;
+                snapshot->num_movers++;
+                break;
+            }
+        }
+    } else {
+        ok = 0;
+    }
+
+    int num_walkers = actors->count - (ACTOR_PLAYER + 1);
+    snapshot->num_walkers = 0;
+    if (reserve_pair(&snapshot->walkers, &snapshot->prev_walkers, &snapshot->walkers_capacity, num_walkers)) {
+        for (int i = ACTOR_PLAYER + 1; i < actors->count; i++) {
+            SDL_FRect rect = actor_rect(actors, i);
+            if (SDL_HasRectIntersectionFloat(&rect, &view)) {
+                snapshot->walkers[snapshot->num_walkers] = rect;
+                snapshot->prev_walkers[snapshot->num_walkers] = actor_prev_rect(actors, i);
+                snapshot->num_walkers++;
+            }
+        }
+    } else {
+        ok = 0;
+    }
+
+    const ParticlePool *pool = &game->particles;
+    snapshot->num_particles = 0;
+    if (reserve((void **)&snapshot->particles, &snapshot->particles_capacity, pool->count, sizeof(SnapshotParticle))) {
+        for (int i = 0; i < pool->count; i++) {
+            if (!point_in_view(pool->x[i], pool->y[i], &view)) {
+                continue;
+            }
+            SnapshotParticle *particle = &snapshot->particles[snapshot->num_particles++];
+            float alpha = pool->life[i] / pool->max_life[i];
+            particle->x = pool->x[i];
+            particle->y = pool->y[i];
+            particle->vx = pool->vx[i];
+            particle->vy = pool->vy[i];
+            particle->color = (pool->color[i] & 0x00FFFFFF) | ((Uint32)(255 * alpha) << 24);
+        }
+    } else {
+        ok = 0;
+    }
+    return ok;
+}
+
+RenderSnapshot *snapshot_write(SnapshotBuffer *buffer)
+{
+    return &buffer->snapshots[buffer->write];
+}
+
+void snapshot_publish(SnapshotBuffer *buffer)
+{
+    // Swap the finished snapshot in as the latest and take back whichever it replaces
+    int previous = SDL_SetAtomicInt(&buffer->latest, buffer->write | SNAPSHOT_FRESH);
+    buffer->write = previous & SNAPSHOT_INDEX_MASK;
+}
+
+const RenderSnapshot *snapshot_acquire(SnapshotBuffer *buffer)
+{
+    if (SDL_GetAtomicInt(&buffer->latest) & SNAPSHOT_FRESH) {
+        int previous = SDL_SetAtomicInt(&buffer->latest, buffer->read);
+        buffer->read = previous & SNAPSHOT_INDEX_MASK;
+    }
+    return &buffer->snapshots[buffer->read];
+}
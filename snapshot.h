@@ -0,0 +1,113 @@
+/*
+  Render snapshots.
+
+  A RenderSnapshot is everything the renderer draws, copied out of the Game
+  at the end of a tick. It holds each moving thing's position before and
+  after the tick for interpolation, plus the HUD values. Only what is in
+  view is copied - the level broadphase is queried with the camera's view -
+  so capturing and drawing cost scales with the screen, not the level.
+  Static geometry is copied for every world tile the view touches, whole,
+  so the renderer can bake those tiles once and reuse them. With pipelined
+  rendering the simulation runs on its own thread and hands snapshots to
+  the renderer through a lock-free triple buffer. The writer never waits
+  for the reader, and the reader always gets the newest complete snapshot.
+*/
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <SDL3/SDL.h>
+
+#include "game.h"
+
+#define SNAPSHOT_TILE_SIZE 256 // Side of the world tiles static geometry is grouped by
+
+typedef struct {
+    float x, y, vx, vy;
+    Uint32 color; // RGBA with the alpha already faded by remaining life
+} SnapshotParticle;
+
+typedef struct {
+    SDL_FRect rect;
+    int index; // In the level, which seeds the animation
+} SnapshotLava;
+
+typedef struct {
+    Uint64 tick;
+    Uint64 time_ns; // When the tick was due, for interpolating in pipelined mode
+
+    // HUD
+    int score;
+    int lives;
+    int current_level;
+    int collected_count;
+    int num_collectibles;
+    int game_over;
+    int game_won;
+    int has_double_jump;
+    float global_timer;
+
+    // Player
+    SDL_FRect player, prev_player;
+    float player_rotation;
+    int invincibility_timer;
+    int walk_timer;
+    int walking;
+
+    // Camera, top-left of the view in the world
+    SDL_FPoint camera, prev_camera;
+
+    // Level, culled to the view; platforms, lava and the goal to the tiles it touches
+    Uint32 level_serial; // Changes when the level does
+    SDL_Rect active_chunks; // Chunks the level's active entities came from; art baked from others may miss some
+    SDL_Rect tiles; // In tile coordinates
+    SDL_FRect goal;
+    int goal_visible;
+    SDL_FRect *platforms;
+    int num_platforms;
+    SnapshotLava *lava;
+    int num_lava;
+    SDL_FRect *gems; // Uncollected only, with the bob applied
+    int num_gems;
+    SDL_FRect *movers, *prev_movers;
+    int num_movers;
+    SDL_FRect *walkers, *prev_walkers;
+    int num_walkers;
+    SnapshotParticle *particles;
+    int num_particles;
+
+    Uint64 sim_phase_ns[PROFILE_PHASE_COUNT]; // Simulation time per phase since startup, pipelined mode only
+
+    Uint32 *visible; // Broadphase query results while capturing
+
+    // Array capacities, grown as needed
+    int platforms_capacity, lava_capacity, gems_capacity, movers_capacity, walkers_capacity, particles_capacity;
+    int visible_capacity;
+} RenderSnapshot;
+
+#define SNAPSHOT_FRESH 0x4 // Set on the shared index until the reader takes it
+#define SNAPSHOT_INDEX_MASK 0x3
+
+typedef struct {
+    RenderSnapshot snapshots[3];
+    SDL_AtomicInt latest; // Newest complete snapshot, shared between the threads
+    int write; // Owned by the writer
+    int read; // Owned by the reader
+} SnapshotBuffer;
+
+void snapshot_buffer_init(SnapshotBuffer *buffer);
+void snapshot_buffer_free(SnapshotBuffer *buffer);
+
+// Copies what the renderer needs out of game, on the thread that ticks it
+// since it queries the level broadphase. Returns 0 if an array couldn't
+// grow, in which case that part of the snapshot is left empty.
+int snapshot_capture(RenderSnapshot *snapshot, Game *game, Uint64 time_ns);
+
+// Writer side: fill the snapshot returned by snapshot_write, then publish it.
+RenderSnapshot *snapshot_write(SnapshotBuffer *buffer);
+void snapshot_publish(SnapshotBuffer *buffer);
+
+// Reader side: the newest published snapshot, which stays valid until the next call.
+// Returns the same one again if nothing new was published.
+const RenderSnapshot *snapshot_acquire(SnapshotBuffer *buffer);
+
+#endif /* SNAPSHOT_H */
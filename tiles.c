@@ -0,0 +1,171 @@
+/*
+  Baked static level art.
+*/
+#include "tiles.h"
+
+static void clear_cells(TileCache *cache);
+static int find_cell(const TileCache *cache, int col, int row);
+static int claim_cell(TileCache *cache);
+static SDL_FRect cell_rect(int cell);
+static void bake_tile(TileCache *cache, SDL_Renderer *renderer, const RenderSnapshot *snapshot, int cell);
+static void fill_clipped(SDL_Renderer *renderer, const SDL_FRect *rect, const SDL_FRect *tile, const SDL_FRect *cell);
+
+int tile_cache_init(TileCache *cache, SDL_Renderer *renderer)
+{
+    SDL_zerop(cache);
+    clear_cells(cache);
+    cache->texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_TARGET,
+                                       TILE_CACHE_TEXTURE_SIZE, TILE_CACHE_TEXTURE_SIZE);
+    if (!cache->texture) {
+        return 0;
+    }
+    // Baked texels are either opaque or empty, and land on the screen one to one
+    SDL_SetTextureBlendMode(cache->texture, SDL_BLENDMODE_BLEND);
+    SDL_SetTextureScaleMode(cache->texture, SDL_SCALEMODE_NEAREST);
+    return 1;
+}
+
+void tile_cache_free(TileCache *cache)
+{
+    if (cache->texture) {
+        SDL_DestroyTexture(cache->texture);
+    }
+    SDL_zerop(cache);
+}
+
+int tile_cache_draw(TileCache *cache, SDL_Renderer *renderer, QuadBatch *batch, const RenderSnapshot *snapshot)
+{
+    const SDL_Rect *tiles = &snapshot->tiles;
+    if (!cache->texture || tiles->w * tiles->h > TILE_CACHE_CELLS) {
+        return 0;
+    }
+    if (cache->level_serial != snapshot->level_serial ||
+        SDL_memcmp(&cache->active_chunks, &snapshot->active_chunks, sizeof(SDL_Rect)) != 0) {
+        clear_cells(cache);
+        cache->level_serial = snapshot->level_serial;
+        cache->active_chunks = snapshot->active_chunks;
+    }
+    cache->frame++;
+
+    // Bake what's missing first; that switches render targets, so whatever is batched goes out before
+    int cells[TILE_CACHE_CELLS];
+    int n = 0, baking = 0;
+    for (int row = tiles->y; row < tiles->y + tiles->h; row++) {
+        for (int col = tiles->x; col < tiles->x + tiles->w; col++) {
+            int cell = find_cell(cache, col, row);
+            if (cell < 0) {
+                if (!baking) {
+                    quad_batch_flush(batch, renderer);
+                    SDL_SetRenderTarget(renderer, cache->texture);
+                    baking = 1;
+                }
+                cell = claim_cell(cache);
+                cache->cells[cell].col = col;
+                cache->cells[cell].row = row;
+                bake_tile(cache, renderer, snapshot, cell);
+                cache->bakes++;
+            }
+            cache->cells[cell].last_used = cache->frame;
+            cells[n++] = cell;
+        }
+    }
+    if (baking) {
+        SDL_SetRenderClipRect(renderer, NULL);
+        SDL_SetRenderTarget(renderer, NULL);
+    }
+
+    quad_batch_set_texture(batch, renderer, cache->texture, (SDL_FPoint){0, 0});
+    for (int i = 0; i < n; i++) {
+        const TileCell *cell = &cache->cells[cells[i]];
+        SDL_FRect uv = cell_rect(cells[i]);
+        uv.x /= TILE_CACHE_TEXTURE_SIZE;
+        uv.y /= TILE_CACHE_TEXTURE_SIZE;
+        uv.w /= TILE_CACHE_TEXTURE_SIZE;
+        uv.h /= TILE_CACHE_TEXTURE_SIZE;
+        quad_batch_add_sprite(batch, (float)(cell->col * SNAPSHOT_TILE_SIZE), (float)(cell->row * SNAPSHOT_TILE_SIZE),
+                              SNAPSHOT_TILE_SIZE, SNAPSHOT_TILE_SIZE, &uv, 255, 255, 255, 255);
+    }
+    return 1;
+}
+
+static void clear_cells(TileCache *cache)
+{
+    for (int i = 0; i < TILE_CACHE_CELLS; i++) {
+        cache->cells[i] = (TileCell){-1, -1, 0};
+    }
+}
+
+static int find_cell(const TileCache *cache, int col, int row)
+{
+    for (int i = 0; i < TILE_CACHE_CELLS; i++) {
+        if (cache->cells[i].col == col && cache->cells[i].row == row) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/* An empty cell if there is one, otherwise the least recently used. Never
+   one drawn this frame, since a frame needs no more tiles than there are cells. */
+static int claim_cell(TileCache *cache)
+{
+    int best = 0;
+    for (int i = 0; i < TILE_CACHE_CELLS; i++) {
+        if (cache->cells[i].col < 0) {
+            return i;
+        }
+        if (cache->cells[i].last_used < cache->cells[best].last_used) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+static SDL_FRect cell_rect(int cell)
+{
+    return (SDL_FRect){(float)(cell % TILE_CACHE_COLS * SNAPSHOT_TILE_SIZE), (float)(cell / TILE_CACHE_COLS * SNAPSHOT_TILE_SIZE),
+                       SNAPSHOT_TILE_SIZE, SNAPSHOT_TILE_SIZE};
+}
+
+/* Renders the static geometry of a cell's tile into it, on the cache texture
+   already set as the target. Geometry from neighbouring tiles is clipped off. */
+static void bake_tile(TileCache *cache, SDL_Renderer *renderer, const RenderSnapshot *snapshot, int index)
+{
+    const TileCell *cell = &cache->cells[index];
+    SDL_FRect target = cell_rect(index);
+    SDL_FRect tile = {(float)(cell->col * SNAPSHOT_TILE_SIZE), (float)(cell->row * SNAPSHOT_TILE_SIZE),
+                      SNAPSHOT_TILE_SIZE, SNAPSHOT_TILE_SIZE};
+    SDL_Rect clip = {(int)target.x, (int)target.y, SNAPSHOT_TILE_SIZE, SNAPSHOT_TILE_SIZE};
+    SDL_SetRenderClipRect(renderer, &clip);
+
+    // Overwrite rather than blend, so the cell starts out empty and opaque texels stay opaque
+    SDL_BlendMode blend;
+    SDL_GetRenderDrawBlendMode(renderer, &blend);
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+    SDL_RenderFillRect(renderer, &target);
+
+    SDL_SetRenderDrawColor(renderer, TILE_PLATFORM_COLOR, 255);
+    for (int i = 0; i < snapshot->num_platforms; i++) {
+        fill_clipped(renderer, &snapshot->platforms[i], &tile, &target);
+    }
+    SDL_SetRenderDrawColor(renderer, TILE_LAVA_COLOR, 255);
+    for (int i = 0; i < snapshot->num_lava; i++) {
+        fill_clipped(renderer, &snapshot->lava[i].rect, &tile, &target);
+    }
+    if (snapshot->goal_visible) {
+        SDL_SetRenderDrawColor(renderer, TILE_GOAL_COLOR, 255);
+        fill_clipped(renderer, &snapshot->goal, &tile, &target);
+    }
+    SDL_SetRenderDrawBlendMode(renderer, blend);
+}
+
+/* Fills a world rect that overlaps tile at the matching spot in the cell. */
+static void fill_clipped(SDL_Renderer *renderer, const SDL_FRect *rect, const SDL_FRect *tile, const SDL_FRect *cell)
+{
+    if (!SDL_HasRectIntersectionFloat(rect, tile)) {
+        return;
+    }
+    SDL_FRect moved = {rect->x - tile->x + cell->x, rect->y - tile->y + cell->y, rect->w, rect->h};
+    SDL_RenderFillRect(renderer, &moved);
+}
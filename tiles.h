@@ -0,0 +1,54 @@
+/*
+  Baked static level art.
+
+  Platforms, lava and the goal never move, so instead of being drawn rect by
+  rect every frame they are rendered once per world tile into a cache, and a
+  frame draws one textured quad per tile in view. The cache is a single
+  render target split into cells, so every tile goes out in one batch.
+  Cells are handed out again least recently used first as the camera moves,
+  and all of them are dropped when the level changes. They are also dropped
+  when the level's active chunks do: a tile can be baked while a chunk
+  whose geometry reaches into it isn't active yet.
+*/
+#ifndef TILES_H
+#define TILES_H
+
+#include <SDL3/SDL.h>
+
+#include "batch.h"
+#include "snapshot.h"
+
+#define TILE_CACHE_TEXTURE_SIZE 2048
+#define TILE_CACHE_COLS (TILE_CACHE_TEXTURE_SIZE / SNAPSHOT_TILE_SIZE)
+#define TILE_CACHE_CELLS (TILE_CACHE_COLS * TILE_CACHE_COLS)
+
+// Colours the static geometry is baked in
+#define TILE_PLATFORM_COLOR 100, 200, 100
+#define TILE_LAVA_COLOR 255, 50, 0
+#define TILE_GOAL_COLOR 255, 215, 0
+
+typedef struct {
+    int col, row; // Tile held, in tile coordinates; col is -1 when the cell is empty
+    Uint64 last_used; // Frame the tile was last drawn on
+} TileCell;
+
+typedef struct {
+    SDL_Texture *texture; // Render target holding every cell
+    TileCell cells[TILE_CACHE_CELLS];
+    Uint32 level_serial; // Level the cells were baked from
+    SDL_Rect active_chunks; // and the chunks active at the time
+    Uint64 frame;
+    int bakes; // Tiles baked since the counter was last reset
+} TileCache;
+
+int tile_cache_init(TileCache *cache, SDL_Renderer *renderer);
+void tile_cache_free(TileCache *cache);
+
+// Adds a quad for each tile in the snapshot to batch, baking the ones not
+// cached yet first. Leaves the cache texture set on the batch, so set the
+// previous one back before adding plain quads. Returns 0 without drawing
+// anything if there is no cache or the view needs more tiles than it holds;
+// the static geometry then has to be drawn directly.
+int tile_cache_draw(TileCache *cache, SDL_Renderer *renderer, QuadBatch *batch, const RenderSnapshot *snapshot);
+
+#endif /* TILES_H */